@@ -23,8 +23,10 @@
 #ifndef UT_TAMARIN_APP_H_ 
 #define UT_TAMARIN_APP_H_
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace uttamarin {
@@ -36,16 +38,25 @@ class OutputWriter;
 struct LemmaJob;
 struct UtTamarinConfig;
 struct TamarinOutput;
+struct GcStatistics;
 
-enum class TamarinHeuristic;
+// Queues the given task, which runs the given lemma job, for execution on
+// some worker thread
+using LemmaJobSubmitter =
+        std::function<void(const LemmaJob&, std::function<void()>)>;
 
 class App {
 
  public:
+  // If a submitter is given, the lemma jobs are submitted with it (e.g., to
+  // the scheduler that a JobServer shares between its clients). Otherwise,
+  // every run of lemma jobs uses a WorkerPool of its own with the number of
+  // jobs of the config.
   App(std::unique_ptr<LemmaProcessor> lemma_processor,
       std::unique_ptr<TheoryPreprocessor> theory_preprocessor,
       std::shared_ptr<UtTamarinConfig> config,
-      std::shared_ptr<OutputWriter> output_writer);
+      std::shared_ptr<OutputWriter> output_writer,
+      LemmaJobSubmitter submit_lemma_job=nullptr);
 
   ~App();
 
@@ -54,7 +65,35 @@ class App {
   // able to prove all lemmas.
   bool RunOnLemmas(const std::vector<LemmaJob>& lemma_jobs);
 
+  // Searches for a heuristic string (e.g., "CsI") with which Tamarin proves
+  // or disproves the lemma of the given jobs (one per single goal ranking,
+  // best first). The search prunes with short probes: every round gives its
+  // heuristics a fraction of the timeout and extends those that ran into it
+  // by one more goal ranking, up to 'max_heuristic_length' goal rankings.
+  // Heuristics that fail otherwise (e.g., because Tamarin crashed) are
+  // pruned, and only the extended heuristics with the best score (made of
+  // the best goal rankings) go on. If no probe produces a definitive result,
+  // the best heuristics that survived the probes run with the full timeout.
+  // The search stops after the first round with a definitive result and
+  // returns the fastest heuristic of that round (or the empty string if
+  // there is none).
+  std::string RunHeuristicSearch(const std::vector<LemmaJob>& lemma_jobs,
+                                 int max_heuristic_length);
+
  private:
+  // Runs the given lemma jobs on a pool of worker threads (see the
+  // constructor). The function 'handle_output' is called
+  // for each finished job (with the index of the job), one job at a time.
+  // Once it returns false, no further jobs are started, and the jobs that
+  // still run are cancelled (see TaskControl).
+  void ProcessLemmaJobs(
+          const std::vector<LemmaJob>& lemma_jobs,
+          const std::function<bool(size_t, const LemmaJob&,
+                                   const TamarinOutput&)>& handle_output);
+
+  // Preprocesses the theory of the given job and runs Tamarin on it.
+  TamarinOutput ProcessLemmaJob(LemmaJob lemma_job);
+
   void PrintHeader();
 
   void PrintLemmaResults(const LemmaJob& lemma_job,
@@ -63,14 +102,20 @@ class App {
                          int number_of_lemmas);
 
   void PrintFooter(int true_lemmas, int false_lemmas,
-                   int unknown_lemmas, int overall_duration);
+                   int unknown_lemmas, int cancelled_lemmas,
+                   int overall_duration);
 
-  std::string ToOutputString(const TamarinHeuristic& heuristic);
+  // Prints the total allocation, the maximum residency and the share of GC
+  // time over the given lemmas, followed by the lemmas that are GC-bound.
+  void PrintGcSummary(
+          const std::vector<std::pair<std::string, GcStatistics>>&
+                  gc_statistics_of_lemmas);
 
   std::unique_ptr<LemmaProcessor> lemma_processor_;
   std::unique_ptr<TheoryPreprocessor> theory_preprocessor_;
   std::shared_ptr<UtTamarinConfig> config_;
   std::shared_ptr<OutputWriter> output_writer_;
+  LemmaJobSubmitter submit_lemma_job_;
 };
 
 } // namespace uttamarin
@@ -25,39 +25,43 @@
 
 #include "lemma_processor.h"
 
-#include <istream>
+#include <memory>
 #include <string>
 
 namespace uttamarin {
 
-enum class TamarinHeuristic;
+class JobserverClient;
+class ResourceSampler;
 
 class BashLemmaProcessor : public LemmaProcessor {
  public:
+  // If a sampler is given, the resource usage of every Tamarin run is sampled
+  // while it runs (see TamarinOutput::samples). If 'collect_gc_statistics' is
+  // set, Tamarin's GHC runtime writes its statistics to a side file, which
+  // are parsed into TamarinOutput::gc_statistics. If a jobserver is given,
+  // every Tamarin run waits for a job slot of the jobserver.
   BashLemmaProcessor(const std::string& proof_directory="",
-                     const int timeout=600);
+                     const int timeout=600,
+                     std::shared_ptr<ResourceSampler> sampler=nullptr,
+                     bool collect_gc_statistics=false,
+                     std::shared_ptr<JobserverClient> jobserver=nullptr);
   virtual ~BashLemmaProcessor();
 
+  // Returns the version of the installed Tamarin prover (e.g.,
+  // "tamarin-prover 1.8.0") or the empty string if it cannot be determined.
+  static std::string GetTamarinVersion();
+
  private:
   // Takes as input a  lemma name and then runs Tamarin on the given lemma.
   // Returns some output/statistics (like Tamarin's result and the execution
   // duration).
   virtual TamarinOutput DoProcessLemma(const LemmaJob& lemma_job) override;
 
-  // Returns a command line representation of the heuristic argument
-  std::string GetTamarinHeuristicArgument(const TamarinHeuristic& heuristic);
-
-  // Takes as input a stream of Tamarin output and the name of a lemma and
-  // returns the result ("verified", "falsified", "analysis incomplete").
-  ProverResult ExtractResultForLemma(std::istream& tamarin_stream,
-                                     const std::string& lemma_name);
-
-  // Takes as input a line of the Tamarin output (a line that shows the Tamarin
-  // result for a particular lemma) and returns the name of the lemma.
-  std::string ExtractLemmaName(std::string line);
-
   std::string proof_directory_;
   int timeout_;
+  std::shared_ptr<ResourceSampler> sampler_;
+  bool collect_gc_statistics_;
+  std::shared_ptr<JobserverClient> jobserver_;
 };
 
 } // namespace uttamarin
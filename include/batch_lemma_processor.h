@@ -0,0 +1,101 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef UT_TAMARIN_BATCH_LEMMA_PROCESSOR_H_
+#define UT_TAMARIN_BATCH_LEMMA_PROCESSOR_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lemma_processor.h"
+
+namespace uttamarin {
+
+// Runs lemma jobs on a cluster through its batch system (e.g., Slurm). The
+// jobs that arrive within a short time (e.g., from all workers of an App)
+// form a batch, which is submitted as one job array: the theories are staged
+// in a directory that the nodes of the cluster share with this host, and an
+// array script runs Tamarin on the job with the index of its array task
+// (see $SLURM_ARRAY_TASK_ID, $PBS_ARRAY_INDEX or $UTTAMARIN_ARRAY_INDEX).
+// Every array task writes the output of Tamarin and, at the end, a status
+// file to the shared directory, which the processor polls for results.
+class BatchLemmaProcessor : public LemmaProcessor {
+ public:
+  // The submit command is run by the shell in the directory of the batch,
+  // after replacing "{script}" by the path of the array script, "{size}" by
+  // the number of jobs and "{last}" by the index of the last job, e.g.,
+  // "sbatch --array=0-{last} {script}". The timeout (in seconds) applies to
+  // lemma jobs without a timeout of their own. A job whose array task has
+  // not written its status within its timeout plus the queue grace period
+  // (in seconds) after the submission fails as a crash, since its task was
+  // lost (e.g., killed with its node or stuck in the queue).
+  BatchLemmaProcessor(const std::string& shared_directory,
+                      const std::string& submit_command,
+                      int timeout,
+                      int queue_grace_period);
+
+  // Removes the staged theories and the results.
+  virtual ~BatchLemmaProcessor();
+
+ private:
+  struct Job;
+
+  // Copies the given theory to the shared directory (once per contents)
+  // and returns the path of the copy.
+  std::string StageTheory(const std::string& spthy_file_path);
+
+  // Writes the array script of the given jobs and submits it. The jobs fail
+  // if the submit command fails.
+  void SubmitBatch(const std::vector<std::shared_ptr<Job>>& jobs);
+
+  // Finishes the submitted jobs whose status files appeared, until the
+  // processor is destroyed.
+  void PollResults();
+
+  virtual TamarinOutput DoProcessLemma(const LemmaJob& lemma_job) override;
+
+  std::string run_directory_;
+  std::string submit_command_;
+  int timeout_;
+  std::chrono::seconds queue_grace_period_;
+  int next_batch_;
+  std::set<std::string> staged_theories_; // by hash
+  std::vector<std::shared_ptr<Job>> pending_jobs_;
+  std::vector<std::shared_ptr<Job>> submitted_jobs_;
+  bool is_stopping_;
+  std::mutex mutex_;
+  std::condition_variable batch_full_;
+  std::condition_variable job_finished_;
+  std::condition_variable stopping_;
+  std::thread poller_;
+};
+
+} // namespace uttamarin
+
+#endif
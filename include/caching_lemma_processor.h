@@ -0,0 +1,71 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_CACHING_LEMMA_PROCESSOR_H_
+#define UT_TAMARIN_CACHING_LEMMA_PROCESSOR_H_
+
+#include "lemma_processor.h"
+
+#include <memory>
+#include <string>
+
+namespace uttamarin {
+
+class RemoteResultCache;
+class ResultCache;
+
+// Decorator that answers lemma jobs from a ResultCache if the cache has a
+// result for the same preprocessed theory, lemma, heuristic and Tamarin
+// version. Definitive results of the decoratee are added to the cache,
+// results without a definitive answer (e.g., timeouts) are not.
+class CachingLemmaProcessor : public LemmaProcessor {
+ public:
+  // If a remote cache is given, it is asked for the results that the local
+  // cache does not have, and it receives the definitive results of the
+  // decoratee as well. With a proof directory, the proofs in it (see
+  // BashLemmaProcessor) are shared through the remote cache, too.
+  CachingLemmaProcessor(
+          std::unique_ptr<LemmaProcessor> decoratee,
+          std::shared_ptr<ResultCache> result_cache,
+          const std::string& tamarin_version="",
+          std::shared_ptr<RemoteResultCache> remote_result_cache=nullptr,
+          const std::string& proof_directory="");
+  virtual ~CachingLemmaProcessor() = default;
+
+ private:
+  virtual TamarinOutput DoProcessLemma(const LemmaJob& lemma_job) override;
+
+  // Returns the key of the given job, the SHA-256 hash of the contents of
+  // its (preprocessed) theory file together with its lemma, its heuristic
+  // and the Tamarin version
+  std::string GetCacheKey(const LemmaJob& lemma_job) const;
+
+  std::unique_ptr<LemmaProcessor> decoratee_;
+  std::shared_ptr<ResultCache> result_cache_;
+  std::string tamarin_version_;
+  std::shared_ptr<RemoteResultCache> remote_result_cache_;
+  std::string proof_directory_;
+};
+
+} // namespace uttamarin
+
+#endif
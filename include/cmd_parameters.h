@@ -24,6 +24,7 @@
 #define UT_TAMARIN_CMD_PARAMETERS_H_
 
 #include <string>
+#include <vector>
 
 namespace uttamarin {
 
@@ -33,10 +34,45 @@ struct CmdParameters {
   std::string output_file_path;
   std::string starting_lemma;
   std::string penetration_lemma;
+  std::string optimize_lemma;
   std::string proof_directory;
+  std::string history_file_path;
+  std::string export_heuristics_path;
+  std::string incremental_base;
+  std::string trace_file_path;
+  std::string phase_report_path;
+  std::string metrics_file_path;
+  std::string json_report_path;
+  std::string junit_report_path;
+  std::string tenants_file_path;
+  std::string accounting_file_path;
+  std::string jobserver_path;
+  std::string batch_directory;
+  std::string batch_submit_command;
+  std::string remote_cache_url;
+  std::string remote_cache_token; // empty if the cache is read-only
+  std::string tenant;
+  std::string priority;
+  std::vector<std::string> lemmas;
+  std::vector<std::string> workers;
   int timeout;
+  int jobs;
+  int heuristic_length;
+  int portfolio_slice;
+  int optimize_budget;
+  int sample_interval;
+  int batch_queue_grace_period; // in seconds
+  double regression_threshold;
   bool abort_after_failure;
   bool is_quiet;
+  bool is_portfolio;
+  bool is_incremental;
+  bool fail_on_regression;
+  bool is_phase_report;
+  bool is_gc_statistics;
+  bool is_ordered_output;
+  bool is_watch;
+  bool is_shared_server;
 };
 
 } // namespace uttamarin
@@ -0,0 +1,95 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_DASHBOARD_H_
+#define UT_TAMARIN_DASHBOARD_H_
+
+#include "reporter.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace uttamarin {
+
+class LemmaHistory;
+class ResourceSampler;
+
+// A live status display for terminals (see OutputWriter::SetStatusProvider)
+// with a line per running job (elapsed time, heuristic, CPU utilization and
+// resident memory) and a summary line with the number of queued, running
+// and finished jobs and the estimated time until the run is done. The
+// estimate is based on the durations of past runs of the lemmas in the
+// history (or, for unknown lemmas, on the mean duration of the others).
+class Dashboard : public Reporter {
+ public:
+  // The sampler provides the CPU utilization and memory of the running jobs
+  // (if given), the history the expected durations (if given).
+  Dashboard(int number_of_workers,
+            std::shared_ptr<ResourceSampler> sampler,
+            std::shared_ptr<LemmaHistory> history);
+  virtual ~Dashboard() = default;
+
+  void AddQueuedLemmas(const std::vector<std::string>& lemma_names);
+
+  std::vector<std::string> GetStatusLines();
+
+ private:
+  struct RunningJob {
+    std::string lemma_name;
+    std::string heuristic;
+    double start_time; // in seconds since the epoch
+  };
+
+  virtual void DoReportLemmaStarted(const LemmaJob& lemma_job,
+                                    double time) override;
+
+  virtual void DoReportLemmaFinished(const LemmaJob& lemma_job,
+                                     const TamarinOutput& tamarin_output,
+                                     double time) override;
+
+  // Returns the expected duration of a job of the given lemma in seconds, or
+  // a negative value if it is unknown
+  double GetExpectedDuration(const std::string& lemma_name);
+
+  // Returns the estimated time in seconds until all queued and running jobs
+  // are done, or a negative value if there is no estimate
+  double EstimateRemainingTime(double now);
+
+  int number_of_workers_;
+  std::shared_ptr<ResourceSampler> sampler_;
+  std::shared_ptr<LemmaHistory> history_;
+  std::map<std::string, int> queued_jobs_of_lemma_;
+  std::vector<RunningJob> running_jobs_;
+  std::map<std::string, double> expected_duration_of_lemma_;
+  int verified_jobs_;
+  int falsified_jobs_;
+  int unverified_jobs_;
+  double finished_duration_; // sum of the durations of the finished jobs
+  std::mutex mutex_;
+};
+
+} // namespace uttamarin
+
+#endif
@@ -26,6 +26,7 @@
 #include "lemma_job_generator.h"
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -33,12 +34,23 @@
 
 namespace uttamarin {
 
+class HeuristicBandit;
+class LemmaHistory;
+class TheoryIndex;
+
 class DefaultLemmaJobGenerator : public LemmaJobGenerator {
 
  public:
+  // The lemmas of the theory are read by running Tamarin on it, unless they
+  // are given as 'lemma_names' (e.g., from an earlier run on the same theory).
   DefaultLemmaJobGenerator(const std::string& spthy_file_path,
                            const std::string& starting_lemma,
-                           std::shared_ptr<UtTamarinConfig> config);
+                           std::shared_ptr<UtTamarinConfig> config,
+                           std::shared_ptr<LemmaHistory> history=nullptr,
+                           std::shared_ptr<const TheoryIndex> theory_index=
+                                   nullptr,
+                           std::optional<std::vector<std::string>>
+                                   lemma_names=std::nullopt);
 
   virtual ~DefaultLemmaJobGenerator() = default;
 
@@ -52,6 +64,14 @@ class DefaultLemmaJobGenerator : public LemmaJobGenerator {
   // Tamarin file, a warning message is printed.
   std::vector<std::string> GetNamesOfLemmasToVerify();
 
+  // Returns the heuristic for the given lemma: the heuristic specified in the
+  // config, or (if there is none) the heuristic that was fastest in past runs
+  // on the current version of the theory. Lemmas without both get the
+  // heuristic that the bandit (if any) considers best for them.
+  std::string GetHeuristicForLemma(const std::string& lemma_name,
+                                   const std::string& theory_hash,
+                                   const HeuristicBandit* bandit);
+
   // Takes as input two vectors of lemmas (the initial lemmas and the
   // "allow list", respectively) and removes from the initial lemmas all lemmas
   // that do not occur in the allow list.
@@ -77,6 +97,9 @@ class DefaultLemmaJobGenerator : public LemmaJobGenerator {
   std::string spthy_file_path_;
   std::string starting_lemma_;
   std::shared_ptr<UtTamarinConfig> config_;
+  std::shared_ptr<LemmaHistory> history_;
+  std::shared_ptr<const TheoryIndex> theory_index_;
+  std::optional<std::vector<std::string>> lemma_names_;
 };
 
 } // namespace uttamarin
@@ -0,0 +1,90 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_FACT_ANNOTATION_OPTIMIZER_H_
+#define UT_TAMARIN_FACT_ANNOTATION_OPTIMIZER_H_
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "lemma_processor.h"
+#include "ut_tamarin_config.h"
+
+namespace uttamarin {
+
+class LemmaJob;
+class OutputWriter;
+class TheoryIndex;
+
+// Searches for fact annotations (see FactAnnotations) under which Tamarin
+// proves or disproves a lemma as fast as possible. The search is a local
+// search over the annotation (important, unimportant or neutral) of every
+// fact symbol of the theory: starting from the annotations of the config, it
+// evaluates all assignments that change the annotation of a single fact in
+// parallel and moves to the fastest one (by wall time), until no such
+// assignment is faster or the time budget is used up. Candidates run with
+// the wall time of the best assignment so far (rounded up, plus a margin) as
+// their timeout, since slower ones cannot win, and never beyond the budget.
+class FactAnnotationOptimizer {
+ public:
+  FactAnnotationOptimizer(std::unique_ptr<LemmaProcessor> lemma_processor,
+                          std::shared_ptr<UtTamarinConfig> config,
+                          std::shared_ptr<const TheoryIndex> theory_index,
+                          std::shared_ptr<OutputWriter> output_writer);
+
+  // Optimizes the annotations for the lemma of the given job within the
+  // given time budget (in seconds) and returns the fastest annotations found
+  // as local annotations of the lemma.
+  FactAnnotations Optimize(const LemmaJob& lemma_job, int time_budget);
+
+ private:
+  enum class Annotation { Neutral, Important, Unimportant };
+  using Assignment = std::map<std::string, Annotation>;
+
+  // Returns the annotations that the config assigns to each fact symbol of
+  // the theory for the given lemma.
+  Assignment GetInitialAssignment(const std::string& lemma_name);
+
+  // Preprocesses the theory with the given assignment and runs Tamarin on the
+  // lemma of the job.
+  TamarinOutput Evaluate(const LemmaJob& lemma_job,
+                         const Assignment& assignment,
+                         int timeout);
+
+  // Turns an assignment into local annotations. Neutral facts are only
+  // listed if they are annotated globally.
+  FactAnnotations ToFactAnnotations(const Assignment& assignment);
+
+  void PrintEvaluation(const LemmaJob& lemma_job,
+                       const Assignment& assignment,
+                       const TamarinOutput& output);
+
+  std::unique_ptr<LemmaProcessor> lemma_processor_;
+  std::shared_ptr<UtTamarinConfig> config_;
+  std::shared_ptr<const TheoryIndex> theory_index_;
+  std::shared_ptr<OutputWriter> output_writer_;
+};
+
+} // namespace uttamarin
+
+#endif
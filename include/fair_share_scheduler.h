@@ -0,0 +1,188 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_FAIR_SHARE_SCHEDULER_H_
+#define UT_TAMARIN_FAIR_SHARE_SCHEDULER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "task_control.h"
+
+namespace uttamarin {
+
+class JobserverClient;
+
+// Interactive tasks (e.g., a quick check of a single lemma) always start
+// before batch tasks (e.g., nightly runs of whole theories)
+enum class JobPriority { Interactive, Batch };
+
+std::string ToString(JobPriority priority);
+
+// Returns the priority with the given name ("interactive" or "batch") or no
+// value if there is no such priority.
+std::optional<JobPriority> ToJobPriority(const std::string& name);
+
+// The share of the workers that a tenant (a user or a project) is entitled
+// to and the limits of its resources
+struct TenantQuota {
+  double weight = 1; // relative to the weights of the other tenants
+  int max_cores = 0; // running tasks at a time, 0 means no limit
+  long max_memory = 0; // in KB, 0 means no limit
+  bool may_run_interactive = true; // otherwise, all its tasks are batch tasks
+};
+
+// Runs the tasks of several tenants on a fixed number of workers (cores).
+// Every tenant has a queue per priority. Whenever a worker becomes free, it
+// runs the next task of the highest priority with queued tasks, taken from
+// the tenant that has used the least worker time in relation to its weight
+// (weighted fair share), skipping tenants that are at their core or memory
+// quota. A tenant that becomes active again starts at the usage of the
+// least active tenant, so that idle periods cannot be saved up.
+// If an interactive task is queued while all workers are busy, a running
+// batch task is suspended (see TaskControl) to make room for it, and resumed
+// once a worker becomes free again. Suspended tasks keep their memory and
+// their cores count against the quota of their tenant, but they free their
+// worker.
+// With a jobserver, every task that is not suspended holds a job slot of
+// the jobserver. A suspended task hands its slot over to the interactive
+// task that replaces it and takes the slot of a finished task when it is
+// resumed, so that suspended tasks never keep slots that other processes
+// of the host could use.
+class FairShareScheduler {
+ public:
+  // The quotas file is a JSON object that maps tenants to quotas, e.g.,
+  //   {"default": {"weight": 1, "max_cores": 8},
+  //    "tenants": {"ci": {"weight": 1, "max_cores": 4, "max_memory": 16384,
+  //                       "interactive": false},
+  //                "alice": {"weight": 2}}}
+  // where "max_memory" is given in MB and "interactive": false makes all
+  // tasks of the tenant batch tasks, which cannot suspend others. Tenants
+  // without an entry get the default quota.
+  FairShareScheduler(int number_of_workers,
+                     const std::string& quotas_file_path="",
+                     std::shared_ptr<JobserverClient> jobserver=nullptr);
+
+  // Waits for all submitted tasks to finish.
+  ~FairShareScheduler();
+
+  // Queues a task of the given tenant. The task is expected to need the
+  // given memory (in KB), which counts against the memory quota of the
+  // tenant while the task runs. A tenant without running tasks may always
+  // start a task, even if the task exceeds its quota.
+  void Submit(const std::string& tenant, JobPriority priority, long memory,
+              std::function<void()> task);
+
+  int GetNumberOfWorkers() const;
+
+ private:
+  struct Task {
+    JobPriority priority;
+    long memory;
+    std::function<void()> run;
+  };
+
+  struct RunningTask {
+    std::string tenant;
+    JobPriority priority;
+    long memory;
+    std::chrono::steady_clock::time_point start_time;
+    TaskControl control;
+    bool has_slot = false; // of the jobserver
+  };
+
+  struct Tenant {
+    TenantQuota quota;
+    std::unordered_map<JobPriority, std::deque<Task>> queue_of;
+    int running_tasks = 0; // including the suspended ones
+    long reserved_memory = 0; // of the running tasks, in KB
+    double used_time = 0; // worker time of the finished tasks, in seconds
+  };
+
+  // Starts, suspends and resumes tasks as described above. Called with the
+  // mutex locked whenever a task is queued or finishes.
+  void Schedule();
+
+  // Starts the given task on a thread of its own
+  void Start(const std::string& tenant_name, Task task);
+
+  // Runs the given task and accounts for it once it finished
+  void Run(RunningTask* running_task, std::function<void()> run);
+
+  // Waits for a job slot of the jobserver unless the given task already has
+  // one, e.g., from the task that it replaced
+  void AcquireSlot(RunningTask* running_task);
+
+  // Gives the slots that no task took back to the jobserver
+  void ReleaseSpareSlots();
+
+  // Removes the task of the given priority that should run next from its
+  // queue. Returns false if no queued task of the priority may start.
+  bool PopNextTask(JobPriority priority, std::string& tenant_name,
+                   Task& task);
+
+  // Returns the running batch task that should make room for an interactive
+  // task (the task of the tenant with the highest usage) or nullptr if there
+  // is none
+  RunningTask* FindTaskToSuspend();
+
+  // Returns the worker time used by the tenant, including its running tasks,
+  // divided by its weight
+  double GetWeightedUsage(const std::string& tenant_name,
+                          std::chrono::steady_clock::time_point now) const;
+
+  // Returns the worker time that the given running task has used so far
+  double GetUsedTime(const RunningTask& running_task,
+                     std::chrono::steady_clock::time_point now) const;
+
+  bool MayStart(const Tenant& tenant, const Task& task) const;
+
+  // Returns true if the tenant has queued or running tasks
+  bool IsActive(const Tenant& tenant) const;
+
+  void ReadQuotas(const std::string& quotas_file_path);
+
+  int number_of_workers_;
+  std::shared_ptr<JobserverClient> jobserver_;
+  int spare_slots_; // slots of the jobserver that no task holds
+  TenantQuota default_quota_;
+  std::unordered_map<std::string, TenantQuota> quota_of_;
+  std::unordered_map<std::string, Tenant> tenants_;
+  std::list<RunningTask> running_tasks_;
+  int busy_workers_; // running tasks that are not suspended
+  int unfinished_tasks_;
+  std::mutex mutex_;
+  std::condition_variable all_tasks_finished_;
+};
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,64 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_FILE_WATCHER_H_
+#define UT_TAMARIN_FILE_WATCHER_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace uttamarin {
+
+// Waits for changes of a set of files using inotify. Since many editors save
+// a file by writing a new file and renaming it to the original name, the
+// watcher watches the directories of the files instead of the files
+// themselves.
+class FileWatcher {
+ public:
+  FileWatcher();
+
+  ~FileWatcher();
+
+  // Replaces the watched files by the given files. Returns false if the
+  // files cannot be watched (e.g., because inotify is not available).
+  bool SetFiles(const std::vector<std::string>& file_paths);
+
+  // Blocks until at least one of the watched files changed and then until
+  // no file changed for 'debounce_time' milliseconds (e.g., while an editor
+  // saves several files). Returns the changed files as given to SetFiles.
+  std::vector<std::string> WaitForChanges(int debounce_time);
+
+ private:
+  // Reads the pending events and adds the watched files they concern
+  void ReadEvents(std::vector<std::string>& changed_files);
+
+  int inotify_descriptor_;
+  std::map<std::string, int> watch_of_directory_;
+  // By watch descriptor and file name within the directory of the watch
+  std::map<std::pair<int, std::string>, std::string> file_path_of_;
+};
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,89 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_HEURISTIC_BANDIT_H_
+#define UT_TAMARIN_HEURISTIC_BANDIT_H_
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "lemma_history.h"
+#include "lemma_job.h"
+
+namespace uttamarin {
+
+class OutputWriter;
+
+// A contextual multi-armed bandit that learns from the records of past runs
+// which heuristic should be tried first on a lemma. Each heuristic string is
+// an arm.
+// A record contributes to the statistics of its arm with a weight equal to
+// the similarity (Jaccard index) between the features of its lemma and the
+// features of the lemma in question, so that outcomes of similar lemmas from
+// the whole suite count the most. Records that say little about the
+// heuristic weigh less: crashes and parse errors not at all, and timeouts in
+// proportion to the time the heuristic had.
+class HeuristicBandit {
+ public:
+  HeuristicBandit(const std::vector<LemmaRecord>& records);
+
+  // Returns all heuristics, ordered by the upper confidence bound (UCB1) of
+  // their reward for a lemma with the given features. An untried heuristic
+  // counts like one that proved a lemma in a minute, so it ranks below
+  // heuristics that proved similar lemmas faster but above slower and failing
+  // ones. Ties keep the order of PenetrationLemmaJobGenerator.
+  std::vector<TamarinHeuristic> RankHeuristics(
+          const std::vector<std::string>& features) const;
+
+  // Returns the heuristic string with the highest average reward for a lemma
+  // with the given features, provided there is enough evidence for it.
+  // Returns no value otherwise.
+  std::optional<std::string> GetBestHeuristic(
+          const std::vector<std::string>& features) const;
+
+ private:
+  struct ArmStatistics {
+    double weight = 0.0;
+    double weighted_reward = 0.0;
+  };
+
+  std::unordered_map<std::string, ArmStatistics> GetArmStatistics(
+          const std::vector<std::string>& features) const;
+
+  std::vector<LemmaRecord> records_;
+};
+
+// Prints a report that compares the order in which the bandit tries
+// heuristics with the fixed order of PenetrationLemmaJobGenerator. The
+// comparison replays all lemmas for which the history contains results of
+// several heuristics (e.g., from penetration runs): for both orders, it sums
+// up the recorded wall times until the first heuristic with a definitive
+// result. The bandit is trained without the records of the replayed lemma.
+// Only single goal rankings are replayed.
+void PrintBanditReport(const std::vector<LemmaRecord>& records,
+                       OutputWriter& output_writer);
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,59 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_HISTORY_LEMMA_PROCESSOR_H_
+#define UT_TAMARIN_HISTORY_LEMMA_PROCESSOR_H_
+
+#include "lemma_processor.h"
+
+#include <memory>
+#include <string>
+
+#include "lemma_history.h"
+
+namespace uttamarin {
+
+class TheoryIndex;
+
+// Decorator that stores the result of every processed lemma job in a
+// LemmaHistory. The theory index provides the theory hash and the lemma
+// features of each record, the run info the run id, host and Tamarin version.
+class HistoryLemmaProcessor : public LemmaProcessor {
+ public:
+  HistoryLemmaProcessor(std::unique_ptr<LemmaProcessor> decoratee,
+                        std::shared_ptr<LemmaHistory> history,
+                        std::shared_ptr<const TheoryIndex> theory_index,
+                        const RunInfo& run_info);
+  virtual ~HistoryLemmaProcessor() = default;
+
+ private:
+  virtual TamarinOutput DoProcessLemma(const LemmaJob& lemma_job) override;
+
+  std::unique_ptr<LemmaProcessor> decoratee_;
+  std::shared_ptr<LemmaHistory> history_;
+  std::shared_ptr<const TheoryIndex> theory_index_;
+  RunInfo run_info_;
+};
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,65 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_INCREMENTAL_LEMMA_PROCESSOR_H_
+#define UT_TAMARIN_INCREMENTAL_LEMMA_PROCESSOR_H_
+
+#include "lemma_processor.h"
+
+#include <memory>
+
+namespace uttamarin {
+
+class LemmaHistory;
+class TheoryIndex;
+
+// Decorator that does not run Tamarin on lemmas whose cone of influence (see
+// TheoryIndex::GetLemmaConeHash) did not change since they were verified,
+// i.e., lemmas whose latest definitive result in the history for their
+// current cone hash is a proof, and answers them with that proof instead
+// (marked as unchanged). If a base theory (e.g., the theory at an earlier git
+// revision) is given, the cone hash must also equal the one in the base
+// theory. Falsified lemmas are never skipped, so that a run never passes
+// without proving all of its lemmas. Since the cone over-approximates the
+// dependencies of a lemma only heuristically, skipping is opt-in (see
+// --incremental).
+class IncrementalLemmaProcessor : public LemmaProcessor {
+ public:
+  IncrementalLemmaProcessor(
+          std::unique_ptr<LemmaProcessor> decoratee,
+          std::shared_ptr<const TheoryIndex> theory_index,
+          std::shared_ptr<LemmaHistory> history,
+          std::shared_ptr<const TheoryIndex> base_theory_index);
+  virtual ~IncrementalLemmaProcessor() = default;
+
+ private:
+  virtual TamarinOutput DoProcessLemma(const LemmaJob& lemma_job) override;
+
+  std::unique_ptr<LemmaProcessor> decoratee_;
+  std::shared_ptr<const TheoryIndex> theory_index_;
+  std::shared_ptr<LemmaHistory> history_;
+  std::shared_ptr<const TheoryIndex> base_theory_index_;
+};
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,157 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_JOB_SERVER_H_
+#define UT_TAMARIN_JOB_SERVER_H_
+
+#include <sys/types.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "cmd_parameters.h"
+
+namespace uttamarin {
+
+class LemmaHistory;
+class OutputWriter;
+class RemoteResultCache;
+class ResourceSampler;
+class FairShareScheduler;
+class JobserverClient;
+class ResultCache;
+class TenantAccounting;
+class TheoryIndex;
+
+// The user that runs a client of the server
+struct PeerUser {
+  std::string name;
+  uid_t uid = 0;
+  std::vector<gid_t> groups; // primary and supplementary groups
+};
+
+// Returns the socket of 'uttamarin serve' if no other socket is given:
+// $XDG_RUNTIME_DIR/uttamarin.sock or, if XDG_RUNTIME_DIR is not set,
+// /tmp/uttamarin-<uid>.sock.
+std::string GetDefaultSocketPath();
+
+// A long-running UT Tamarin process ('uttamarin serve') that accepts job
+// requests on a Unix domain socket, so that repeated runs do not pay for
+// starting up. A client sends one request per connection as a JSON object on
+// a single line, e.g.,
+//   {"theory": "/home/alice/protocol.spthy", "config": "", "start": "",
+//    "lemmas": ["secrecy"], "timeout": 600, "abort_after_failure": false,
+//    "ordered_output": false, "tenant": "alice", "priority": "interactive"}
+// where all fields except "theory" are optional and paths must be absolute.
+// The server takes the tenant of a run from the user of the client process
+// (SO_PEERCRED), so that no user can run on the quota of another user, and
+// only reads the files that this user may read. Only the user of the server
+// may connect unless the server is shared (--shared). The
+// declared "tenant" only labels the run within the accounts of that user
+// (e.g., "alice/projectx").
+// The request {"type": "accounting"} asks for the accounting report of all
+// tenants instead (see PrintAccountingReport). The server answers with one
+// JSON object per line: {"event": "output", "text": ...} for every line of
+// the report and, at the end, {"event": "done", "success": ...} or
+// {"event": "error", "message": ...}.
+// Between requests, the server keeps the index and the lemmas of every
+// theory (as long as its contents do not change), the history and the
+// definitive results of earlier requests (see CachingLemmaProcessor), which
+// it also shares through a remote result cache if one is configured. If a
+// client closes its connection (even only for writing) before the end of its
+// run, e.g., on Ctrl+C, the lemma jobs of the run are cancelled. The
+// lemma jobs of all requests are shared fairly between the tenants (users
+// or projects) by a FairShareScheduler, and the resources of every job are
+// charged to its tenant.
+class JobServer {
+ public:
+  // The parameters configure the server (number of workers, history file,
+  // proof directory, tenant quotas, accounting file, ...) and give the
+  // defaults of the requests.
+  JobServer(const std::string& socket_path, const CmdParameters& parameters);
+
+  // Waits for the open connections to be handled.
+  ~JobServer();
+
+  // Accepts and handles requests (one thread per connection) until the
+  // process is terminated. Returns false if the server cannot listen on the
+  // socket.
+  bool Run();
+
+ private:
+  void HandleConnection(int connection);
+
+  // Runs the lemma jobs of the given request of the given user and sends the
+  // report to the connection. Returns true if Tamarin proves all lemmas.
+  bool RunRequest(const nlohmann::json& request, const PeerUser& peer_user,
+                  int connection);
+
+  // Returns the memory (in KB) that Tamarin is expected to need for the
+  // given lemma: the peak memory of its latest runs in the history
+  long EstimateMemory(const std::string& lemma_name) const;
+
+  // Returns the index of the given theory, which is only rebuilt if the
+  // contents of the theory changed since the last request
+  std::shared_ptr<const TheoryIndex> GetTheoryIndex(
+          const std::string& spthy_file_path);
+
+  // Returns the lemmas of the given theory, which Tamarin only reads once
+  // per contents of the theory
+  std::vector<std::string> GetLemmaNames(const std::string& spthy_file_path,
+                                         const std::string& theory_hash);
+
+  std::string socket_path_;
+  CmdParameters parameters_;
+  std::string tamarin_version_;
+  std::shared_ptr<JobserverClient> jobserver_;
+  std::shared_ptr<FairShareScheduler> scheduler_;
+  std::shared_ptr<TenantAccounting> accounting_;
+  std::shared_ptr<LemmaHistory> history_;
+  std::shared_ptr<ResultCache> result_cache_;
+  std::shared_ptr<RemoteResultCache> remote_result_cache_;
+  std::shared_ptr<ResourceSampler> resource_sampler_;
+  std::unordered_map<std::string, std::shared_ptr<const TheoryIndex>>
+          theory_index_of_; // by path
+  std::unordered_map<std::string, std::vector<std::string>>
+          lemma_names_of_; // by theory hash
+  int open_connections_;
+  std::mutex mutex_;
+  std::condition_variable all_connections_closed_;
+};
+
+// Sends the given request (see JobServer) to the server listening on the
+// given socket and writes the report of the server to the output writer.
+// Returns 0 if the server ran the request and 1 otherwise, like the exit
+// status of a local run.
+int SubmitJobRequest(const std::string& socket_path,
+                     const nlohmann::json& request,
+                     OutputWriter& output_writer);
+
+} // namespace uttamarin
+
+#endif
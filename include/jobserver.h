@@ -0,0 +1,109 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_JOBSERVER_H_
+#define UT_TAMARIN_JOBSERVER_H_
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace uttamarin {
+
+// Returns the FIFO of the host-wide jobserver (see RunJobserver) if no other
+// FIFO is given: /tmp/uttamarin-jobserver.fifo.
+std::string GetDefaultJobserverPath();
+
+// A client of a jobserver in the sense of GNU make, which limits the number
+// of processes that run at once across all processes that share it. Every
+// job slot is a token (a single byte) in a pipe or FIFO: a process reads a
+// token before it starts a job and writes the token back once the job ends.
+// When GNU make starts a process (e.g., UT Tamarin in a recipe of
+// 'make -j8'), the process holds one implicit slot for which it needs no
+// token.
+class JobserverClient {
+ public:
+  // Connects to the jobserver of the given FIFO or, if the path is empty, to
+  // the jobserver of GNU make given in MAKEFLAGS ("--jobserver-auth=R,W" with
+  // inherited pipe descriptors or "--jobserver-auth=fifo:PATH"). Returns
+  // nullptr if there is no jobserver to connect to.
+  static std::shared_ptr<JobserverClient> Connect(
+          const std::string& fifo_path);
+
+  // Returns the number of jobs of GNU make (the option -j in MAKEFLAGS), if
+  // any.
+  static std::optional<int> GetMakeJobs();
+
+  // Writes back the tokens that are still held.
+  ~JobserverClient();
+
+  // Blocks until a job slot is free and takes it. Returns false if the
+  // jobserver can no longer be read (e.g., because it was terminated).
+  bool AcquireSlot();
+
+  // Gives back a job slot that AcquireSlot took.
+  void ReleaseSlot();
+
+ private:
+  JobserverClient(int read_descriptor, int write_descriptor,
+                  bool owns_descriptors, bool has_implicit_slot);
+
+  int read_descriptor_;
+  int write_descriptor_;
+  bool owns_descriptors_;
+  bool has_implicit_slot_;
+  bool is_implicit_slot_free_;
+  bool is_broken_; // AcquireSlot failed
+  std::vector<char> tokens_; // read from the jobserver and not written back
+  std::mutex mutex_;
+};
+
+// Holds a job slot of the given jobserver (if any) as long as it exists.
+class JobSlot {
+ public:
+  JobSlot(std::shared_ptr<JobserverClient> jobserver);
+  ~JobSlot();
+
+  JobSlot(const JobSlot&) = delete;
+  JobSlot& operator=(const JobSlot&) = delete;
+
+  // Returns false if the jobserver failed to give a slot.
+  bool IsAcquired() const;
+
+ private:
+  std::shared_ptr<JobserverClient> jobserver_;
+  bool is_acquired_;
+};
+
+// Runs a host-wide jobserver ('uttamarin jobserver') with the given number of
+// slots: creates the FIFO (readable and writable by all users), fills it with
+// one token per slot and keeps it open until the process is terminated, so
+// that UT Tamarin instances (see --jobserver) and GNU make 4.4 or later (with
+// MAKEFLAGS="-jN --jobserver-auth=fifo:PATH") share the slots. Returns
+// false if the FIFO cannot be created.
+bool RunJobserver(const std::string& fifo_path, int slots);
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,54 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_JSON_LINES_REPORTER_H_
+#define UT_TAMARIN_JSON_LINES_REPORTER_H_
+
+#include "reporter.h"
+
+#include <fstream>
+#include <string>
+
+namespace uttamarin {
+
+// Writes one JSON object per line for every start ("event": "start") and
+// every result ("event": "finish") of a lemma job, including all timing and
+// resource fields of the result. Every line is flushed right away.
+class JsonLinesReporter : public Reporter {
+ public:
+  explicit JsonLinesReporter(const std::string& report_file_path);
+  virtual ~JsonLinesReporter() = default;
+
+ private:
+  virtual void DoReportLemmaStarted(const LemmaJob& lemma_job,
+                                    double time) override;
+
+  virtual void DoReportLemmaFinished(const LemmaJob& lemma_job,
+                                     const TamarinOutput& tamarin_output,
+                                     double time) override;
+
+  std::ofstream report_stream_;
+};
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,67 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_JUNIT_REPORTER_H_
+#define UT_TAMARIN_JUNIT_REPORTER_H_
+
+#include "reporter.h"
+
+#include <string>
+#include <vector>
+
+namespace uttamarin {
+
+// Writes a JUnit XML report with one test case per lemma job: falsified
+// lemmas are failures, lemmas without a result (e.g., timeouts) are errors.
+// Since XML cannot be appended to, the report is rewritten (atomically, via
+// a temporary file) after every result.
+class JUnitReporter : public Reporter {
+ public:
+  explicit JUnitReporter(const std::string& report_file_path);
+  virtual ~JUnitReporter() = default;
+
+ private:
+  struct TestCase {
+    std::string suite_name;
+    std::string name;
+    double time; // in seconds
+    std::string xml; // the test case element
+    bool is_failure;
+    bool is_error;
+  };
+
+  virtual void DoReportLemmaStarted(const LemmaJob& lemma_job,
+                                    double time) override;
+
+  virtual void DoReportLemmaFinished(const LemmaJob& lemma_job,
+                                     const TamarinOutput& tamarin_output,
+                                     double time) override;
+
+  void WriteReport();
+
+  std::string report_file_path_;
+  std::vector<TestCase> test_cases_;
+};
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,151 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_LEMMA_HISTORY_H_
+#define UT_TAMARIN_LEMMA_HISTORY_H_
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "lemma_processor.h"
+
+namespace uttamarin {
+
+// A single result of running Tamarin on a lemma.
+struct LemmaRecord {
+  std::string lemma_name;
+  std::string heuristic; // empty for Tamarin's default heuristic
+  ProverResult result;
+  int duration; // in seconds
+  std::string theory_hash;
+  long long timestamp; // seconds since epoch
+  std::vector<std::string> features; // see TheoryIndex::GetLemmaFeatures
+  std::string cone_hash; // see TheoryIndex::GetLemmaConeHash
+  FailureReason failure_reason = FailureReason::None;
+  int steps = -1; // size of the proof or attack (if known)
+  double wall_time = 0; // in seconds
+  double processing_time = -1; // in seconds, as reported by Tamarin
+  double cpu_time = 0; // user and system time of Tamarin, in seconds
+  long max_rss = 0; // peak resident memory of Tamarin, in KB
+  long major_faults = 0; // page faults of Tamarin that required I/O
+  GcStatistics gc_statistics; // see BashLemmaProcessor
+  std::string tamarin_version;
+  std::string host;
+  std::string run_id; // identifies the run of UT Tamarin
+};
+
+// Returns the wall time of the given record in seconds, or its duration for
+// records of older versions of UT Tamarin, which did not store the wall time.
+double GetWallTime(const LemmaRecord& record);
+
+// Describes the current run of UT Tamarin for the records of the history.
+struct RunInfo {
+  std::string run_id;
+  std::string host;
+  std::string tamarin_version;
+};
+
+// Returns a run info with a new run id (e.g., "20241231T235959-4711") and the
+// name of the current host.
+RunInfo CreateRunInfo(const std::string& tamarin_version);
+
+// Stores the results of past runs in a local file (one JSON object per line).
+// Records are appended, so the file can be shared between consecutive runs
+// and different modes (e.g., penetration). The records are indexed by lemma
+// name, so that queries for a lemma only visit its records. Only the latest
+// kMaxRecordsPerLemma records of each lemma (and its latest definitive one)
+// are kept: once the file holds kCompactionFactor times as many records,
+// loading it rewrites it without the others, which bounds the cost of
+// loading. A lock file next to the history file ("<history file>.lock")
+// keeps a compaction from losing the records that other runs append.
+class LemmaHistory {
+ public:
+  // Loads the records from the given file. If the path is empty, the history
+  // is kept in memory only.
+  LemmaHistory(const std::string& history_file_path);
+
+  // Adds a record to the history and appends it to the history file.
+  void AddRecord(const LemmaRecord& record);
+
+  // Appends the resource samples of the run of the given record (see
+  // ResourceSampler) to the samples file next to the history file (the
+  // history file path with the suffix ".samples"), one JSON object per run.
+  // Samples are not loaded back, since they are only meant for analysis.
+  void AddSamples(const LemmaRecord& record,
+                  const std::vector<ResourceSample>& samples);
+
+  std::vector<LemmaRecord> GetRecords() const;
+
+  // Returns the records of the given lemma in the order they were added.
+  std::vector<LemmaRecord> GetRecordsOfLemma(
+          const std::string& lemma_name) const;
+
+  // Returns the heuristic with which Tamarin produced a definitive result
+  // (verified or falsified) for the given lemma in the shortest wall time
+  // (the latest of equally fast records). Only records whose theory hash
+  // equals 'theory_hash' and whose heuristic is valid are considered, so
+  // that stale records of earlier theory versions and damaged records are
+  // ignored. Returns no value if there is no such record.
+  std::optional<std::string> GetFastestHeuristic(
+          const std::string& lemma_name,
+          const std::string& theory_hash) const;
+
+  // Returns the latest record with a definitive result for the given lemma
+  // whose cone hash (see TheoryIndex::GetLemmaConeHash) equals 'cone_hash',
+  // i.e., a result that is still valid for the current theory even if other
+  // parts of the theory changed. Returns no value if there is no such record.
+  std::optional<LemmaRecord> GetLatestDefinitiveRecord(
+          const std::string& lemma_name,
+          const std::string& cone_hash) const;
+
+  // Like GetFastestHeuristic, but for all lemmas with a fresh record.
+  std::unordered_map<std::string, std::string> GetFastestHeuristics(
+          const std::string& theory_hash) const;
+
+ private:
+  // Loads the records and compacts the history file if it has grown too much
+  void LoadRecords();
+
+  // Replaces the in-memory records with those of the history file
+  void ReadRecords();
+
+  // Returns for every record whether it is kept by a compaction
+  std::vector<bool> GetKeptRecords() const;
+
+  // Drops the records that are not kept from memory and the history file
+  void Compact();
+
+  // Adds a record to the in-memory records and the index
+  void IndexRecord(const LemmaRecord& record);
+
+  std::string history_file_path_;
+  std::vector<LemmaRecord> records_;
+  std::unordered_map<std::string, std::vector<size_t>> record_indices_of_;
+  mutable std::mutex mutex_;
+};
+
+} // namespace uttamarin
+
+#endif
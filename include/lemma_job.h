@@ -24,16 +24,32 @@
 #define UTTAMARIN_LEMMA_JOB_H_
 
 #include <string>
+#include <vector>
 
 namespace uttamarin {
 
+// The goal rankings of Tamarin. A heuristic is a string of goal rankings
+// (e.g., "CsI"), which Tamarin uses in a round-robin fashion depending on the
+// proof depth. The empty string stands for Tamarin's default heuristic.
 enum class TamarinHeuristic { S, s, C, c, I, i, P, p, None };
 
+// Returns the command-line representation of a goal ranking (e.g., "S"). The
+// goal ranking 'None' is represented by the empty string.
+std::string ToString(const TamarinHeuristic& heuristic);
+
+// Returns true if the given heuristic string consists only of goal rankings
+// known to Tamarin.
+bool IsValidHeuristic(const std::string& heuristic);
+
 class LemmaJob {
  public:
   LemmaJob(std::string spthy_file_path,
            std::string lemma_name,
-           const TamarinHeuristic& heuristic=TamarinHeuristic::None);
+           const std::string& heuristic="");
+
+  LemmaJob(std::string spthy_file_path,
+           std::string lemma_name,
+           const TamarinHeuristic& heuristic);
 
   const std::string GetSpthyFilePath() const;
   void SetSpthyFilePath(const std::string& spthy_file_path);
@@ -41,15 +57,27 @@ class LemmaJob {
   const std::string GetLemmaName() const;
   void SetLemmaName(const std::string& lemma_name);
 
-  TamarinHeuristic GetHeuristic() const;
-  void SetHeuristic(TamarinHeuristic heuristic);
+  const std::string GetHeuristic() const;
+  void SetHeuristic(const std::string& heuristic);
+
+  // Timeout in seconds for this job. A negative value (the default) means
+  // that the lemma processor uses its own timeout.
+  int GetTimeout() const;
+  void SetTimeout(int timeout);
 
  private:
   std::string spthy_file_path_;
   std::string lemma_name_;
-  TamarinHeuristic heuristic_;
+  std::string heuristic_;
+  int timeout_;
 };
 
+// Returns the jobs of the given lemmas in their original order, or all jobs
+// if no lemmas are given.
+std::vector<LemmaJob> SelectLemmaJobs(
+        const std::vector<LemmaJob>& lemma_jobs,
+        const std::vector<std::string>& lemma_names);
+
 } // namespace uttamarin
 
 #endif
@@ -24,6 +24,7 @@
 #define UT_TAMARIN_LEMMA_PROCESSOR_H_
 
 #include <string>
+#include <vector>
 
 namespace uttamarin {
 
@@ -31,9 +32,51 @@ class LemmaJob;
 
 enum class ProverResult { True, False, Unknown };
 
+// The reason why Tamarin did not produce a definitive result
+enum class FailureReason {
+  None, Timeout, Incomplete, ParseError, Crash, Cancelled
+};
+
+// The resource usage of a running Tamarin process (and its subprocesses) at
+// one point in time, see ResourceSampler
+struct ResourceSample {
+  double time; // in seconds since the start of Tamarin
+  double cpu_utilization; // in cores, since the previous sample
+  long rss; // resident memory, in KB
+  long major_faults; // since the start of Tamarin
+  long long read_bytes; // read from storage since the start of Tamarin
+  long long write_bytes; // written to storage since the start of Tamarin
+};
+
+// Statistics of the GHC runtime of a Tamarin run (see +RTS -t), which show
+// whether Tamarin spent its time proving or collecting garbage
+struct GcStatistics {
+  long long bytes_allocated = -1; // -1 if the statistics are unknown
+  long long max_residency = 0; // largest live heap after a GC, in bytes
+  long long number_of_gcs = 0;
+  double gc_cpu_time = 0; // in seconds
+  double mutator_cpu_time = 0; // in seconds, the time spent outside the GC
+  double gc_time_fraction = 0; // GC time divided by the total CPU time
+  double productivity = 0; // mutator time divided by the total CPU time
+  double parallel_gc_balance = -1; // 0 serial to 1 perfect, -1 if unknown
+};
+
 struct TamarinOutput {
   ProverResult result;
   int duration; // in seconds
+  std::string heuristic; // the heuristic with which the result was obtained
+  FailureReason failure_reason = FailureReason::None;
+  double wall_time = 0; // in seconds, measured by UT Tamarin
+  double processing_time = -1; // in seconds, reported by Tamarin (if known)
+  double cpu_time = 0; // user and system time of Tamarin, in seconds
+  long max_rss = 0; // peak resident memory of Tamarin, in KB
+  long major_faults = 0; // page faults of Tamarin that required I/O
+  int steps = -1; // size of the proof or attack (if known)
+  bool is_unchanged = false; // taken from the history without running Tamarin
+  std::vector<std::string> warnings; // e.g., failed wellformedness checks
+  std::string error; // error output of Tamarin (for parse errors, crashes)
+  std::vector<ResourceSample> samples; // only if a sampler is enabled
+  GcStatistics gc_statistics; // only if GC statistics are collected
 };
 
 class LemmaProcessor {
@@ -44,7 +87,7 @@ class LemmaProcessor {
   // given by the lemma job. Returns some statistics (like Tamarin's result
   // and the execution duration).
   TamarinOutput ProcessLemma(const LemmaJob& lemma_job) {
-    DoProcessLemma(lemma_job);
+    return DoProcessLemma(lemma_job);
   }
 
  private:
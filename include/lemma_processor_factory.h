@@ -0,0 +1,84 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_LEMMA_PROCESSOR_FACTORY_H_
+#define UT_TAMARIN_LEMMA_PROCESSOR_FACTORY_H_
+
+#include "lemma_processor.h"
+
+#include <memory>
+#include <string>
+
+#include "cmd_parameters.h"
+#include "lemma_history.h"
+
+namespace uttamarin {
+
+class JobserverClient;
+class MetricsExporter;
+class RemoteResultCache;
+class ResourceSampler;
+class ResultCache;
+class TenantAccounting;
+class TheoryIndex;
+
+// The parts of the processor chain that live longer than a single run (e.g.,
+// the connections to the workers or the result cache of a server). Parts
+// that are not given are left out of the chain.
+struct LemmaProcessorParts {
+  // Runs the lemma jobs instead of Tamarin on this host (e.g., a
+  // RemoteLemmaProcessor), shared by all chains
+  std::shared_ptr<LemmaProcessor> remote_lemma_processor;
+  std::shared_ptr<LemmaHistory> history;
+  std::shared_ptr<ResourceSampler> resource_sampler;
+  // Not given if the caller takes the slots of the jobserver itself (see
+  // FairShareScheduler)
+  std::shared_ptr<JobserverClient> jobserver;
+  std::shared_ptr<ResultCache> result_cache;
+  std::shared_ptr<RemoteResultCache> remote_result_cache;
+  std::shared_ptr<TenantAccounting> accounting;
+  std::string account; // the tenant charged by the accounting
+  std::shared_ptr<MetricsExporter> metrics_exporter;
+  // The run of the records in the history, whose Tamarin version is also
+  // part of the cache keys
+  RunInfo run_info;
+};
+
+// Creates the processor chain of a run, which main.cc, the server (see
+// JobServer) and watch mode (see TheoryWatcher) share. The base runs Tamarin
+// on the workers, on a batch system (--batch_dir) or on this host, followed
+// by the decorators that the parameters and the given parts ask for, from
+// the inside out: PortfolioLemmaProcessor, HistoryLemmaProcessor (which
+// records a portfolio as a whole), AccountingLemmaProcessor,
+// CachingLemmaProcessor, IncrementalLemmaProcessor (with the given base
+// theory, if any) and MetricsLemmaProcessor. Penetration mode gets no
+// portfolio, and neither penetration mode nor the optimization of
+// annotations skips unchanged lemmas.
+std::unique_ptr<LemmaProcessor> CreateLemmaProcessor(
+        const CmdParameters& parameters,
+        const LemmaProcessorParts& parts,
+        std::shared_ptr<const TheoryIndex> theory_index,
+        std::shared_ptr<const TheoryIndex> base_theory_index=nullptr);
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,50 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef UT_TAMARIN_LEMMA_WORKER_H_
+#define UT_TAMARIN_LEMMA_WORKER_H_
+
+#include <string>
+
+#include "cmd_parameters.h"
+
+namespace uttamarin {
+
+// Runs 'uttamarin worker', which receives theories and lemma jobs from a
+// coordinator (see RemoteLemmaProcessor and worker_protocol.h), runs up to
+// 'parameters.jobs' of them at a time with a BashLemmaProcessor (configured
+// by -p, --gc_statistics and --jobserver) and streams the results back.
+// Without a listen address, the worker talks to its coordinator over the
+// standard input and output (e.g., through ssh) and exits once the
+// coordinator closes the standard input. Otherwise, it listens on the given
+// TCP address ("HOST:PORT") and serves several coordinators at once, whose
+// jobs share the 'parameters.jobs' slots in the order in which they arrive.
+// The jobs of a coordinator that goes away are cancelled. Invalid messages
+// only end the connection of their coordinator. Returns false if the worker
+// cannot listen on the address.
+bool RunLemmaWorker(const CmdParameters& parameters,
+                    const std::string& listen_address);
+
+} // namespace uttamarin
+
+#endif
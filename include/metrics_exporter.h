@@ -0,0 +1,92 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_METRICS_EXPORTER_H_
+#define UT_TAMARIN_METRICS_EXPORTER_H_
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lemma_processor.h"
+
+namespace uttamarin {
+
+// Keeps the progress and results of a run (lemmas queued, running and done,
+// results, durations, worker utilization, memory) and periodically rewrites
+// them to a file in the Prometheus text format, e.g., for the textfile
+// collector of the node exporter. The file is replaced atomically (written
+// to a temporary file that is renamed), so a scrape never sees half a file.
+class MetricsExporter {
+ public:
+  // Takes the path of the metrics file (which should end in ".prom" for the
+  // textfile collector), the number of workers and the interval between two
+  // writes in milliseconds.
+  MetricsExporter(const std::string& metrics_file_path,
+                  int number_of_workers,
+                  int interval=1000);
+
+  // Writes the final metrics and stops the writing thread.
+  ~MetricsExporter();
+
+  MetricsExporter(const MetricsExporter&) = delete;
+  MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+  void AddQueuedLemmas(int number_of_lemmas);
+
+  void StartLemma();
+
+  void FinishLemma(const std::string& lemma_name,
+                   const TamarinOutput& tamarin_output);
+
+  // Writes the current metrics to the metrics file.
+  void Write();
+
+ private:
+  void Run();
+
+  std::string ToPrometheusText();
+
+  std::string metrics_file_path_;
+  int number_of_workers_;
+  int interval_;
+  int queued_lemmas_;
+  int running_lemmas_;
+  int finished_lemmas_;
+  std::map<ProverResult, long long> result_counts_;
+  std::vector<long long> duration_bucket_counts_;
+  double duration_sum_;
+  double busy_time_; // in seconds, summed over the workers
+  std::map<std::string, double> duration_of_lemma_; // latest wall time
+  bool is_stopping_;
+  std::mutex mutex_;
+  std::mutex write_mutex_;
+  std::condition_variable stop_requested_;
+  std::thread thread_;
+};
+
+} // namespace uttamarin
+
+#endif
@@ -20,31 +20,30 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
-#ifndef UT_TAMARIN_VERBOSE_LEMMA_PROCESSOR_H_
-#define UT_TAMARIN_VERBOSE_LEMMA_PROCESSOR_H_
+#ifndef UT_TAMARIN_METRICS_LEMMA_PROCESSOR_H_
+#define UT_TAMARIN_METRICS_LEMMA_PROCESSOR_H_
 
 #include "lemma_processor.h"
 
-#include <future>
-#include <istream>
 #include <memory>
-#include <string>
 
 namespace uttamarin {
 
-class VerboseLemmaProcessor : public LemmaProcessor {
+class MetricsExporter;
+
+// Decorator that reports the start and the result of every processed lemma
+// job to a MetricsExporter.
+class MetricsLemmaProcessor : public LemmaProcessor {
  public:
-  VerboseLemmaProcessor(std::unique_ptr<LemmaProcessor> decoratee);
-  virtual ~VerboseLemmaProcessor() = default;
+  MetricsLemmaProcessor(std::unique_ptr<LemmaProcessor> decoratee,
+                        std::shared_ptr<MetricsExporter> metrics_exporter);
+  virtual ~MetricsLemmaProcessor() = default;
 
  private:
-
-  // Takes as input a tamarin file path and a lemma name and then runs Tamarin
-  // on the given lemma. Returns some output/statistics (like Tamarin's result
-  // and the execution duration). Additionally prints its statistics to cout.
   virtual TamarinOutput DoProcessLemma(const LemmaJob& lemma_job) override;
 
   std::unique_ptr<LemmaProcessor> decoratee_;
+  std::shared_ptr<MetricsExporter> metrics_exporter_;
 };
 
 } // namespace uttamarin
@@ -0,0 +1,83 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_MPSC_QUEUE_H_
+#define UT_TAMARIN_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <utility>
+
+namespace uttamarin {
+
+// An unbounded lock-free queue for many producers and a single consumer
+// (after Dmitry Vyukov's intrusive MPSC queue). Push never blocks and may be
+// called from any thread, Pop and HasNext only from the consumer thread. The
+// value type must be default-constructible.
+template<typename T>
+class MpscQueue {
+ public:
+  MpscQueue() : head_(new Node()), tail_(head_.load()) {}
+
+  ~MpscQueue() {
+    T value;
+    while(Pop(value)) {}
+    delete tail_;
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  void Push(T value) {
+    auto node = new Node();
+    node->value = std::move(value);
+    auto previous = head_.exchange(node);
+    previous->next.store(node);
+  }
+
+  // Moves the oldest value into 'value'. Returns false if the queue is empty
+  // (or the value that was pushed last is not completely linked yet).
+  bool Pop(T& value) {
+    auto next = tail_->next.load();
+    if(next == nullptr) return false;
+    value = std::move(next->value);
+    delete tail_;
+    tail_ = next;
+    return true;
+  }
+
+  bool HasNext() const {
+    return tail_->next.load() != nullptr;
+  }
+
+ private:
+  struct Node {
+    T value;
+    std::atomic<Node*> next{nullptr};
+  };
+
+  std::atomic<Node*> head_; // the node pushed last
+  Node* tail_; // the node popped last (initially a dummy node)
+};
+
+} // namespace uttamarin
+
+#endif
@@ -23,19 +23,50 @@
 #ifndef UT_TAMARIN_OUTPUT_WRITER_H_
 #define UT_TAMARIN_OUTPUT_WRITER_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
 #include <iostream>
 #include <initializer_list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "mpsc_queue.h"
+
 namespace uttamarin {
 
+class LemmaJob;
+class Reporter;
+
+struct TamarinOutput;
+
 enum class TextColor { Red, Green, Yellow };
 
+// The order in which the blocks of output (see OutputWriter::BeginBlock) of
+// concurrent lemma jobs are written
+enum class OutputOrder { Completion, File };
+
+// Writes text to a number of streams (colorized only on std::cout). The
+// output of every thread is collected line by line and passed to a single
+// output thread through a lock-free queue, so lines of concurrent workers do
+// not interleave and the workers never wait for slow streams. The streams
+// are flushed whenever the output thread has written all queued lines. A
+// status display (see SetStatusProvider) is kept below the output.
 class OutputWriter {
  public:
-  OutputWriter(std::vector<std::ostream*> streams);
+  OutputWriter(std::vector<std::ostream*> streams,
+               OutputOrder output_order=OutputOrder::Completion);
+
+  // Writes all queued output and waits until all reporters have received all
+  // events.
+  ~OutputWriter();
 
   template<typename T>
   OutputWriter& operator<<(T input);
@@ -43,39 +74,120 @@ class OutputWriter {
   template<typename T>
   OutputWriter& WriteColorized(T input, TextColor color);
 
+  // Ends the current line of the calling thread and queues it for output.
   void Endl();
 
- private:
+  // Tags the following lines of the calling thread (until EndBlock) as the
+  // block with the given index (e.g., the index of a lemma job in the file).
+  // With OutputOrder::File, blocks are written in the order of their indices
+  // starting from 0, using a reorder buffer for blocks that finish early, so
+  // parallel runs print the same report as sequential ones.
+  void BeginBlock(size_t index);
 
-  template<typename T>
-  OutputWriter& WriteColorized(std::ostream& stream, T input, TextColor color);
+  void EndBlock();
+
+  // Writes all buffered blocks in the order of their indices, even if blocks
+  // with lower indices are missing (e.g., jobs that were never started).
+  // The next block is expected to have the index 0 again.
+  void FlushBlocks();
+
+  OutputOrder GetOutputOrder() const;
+
+  // Adds a machine-readable reporter (e.g., a JUnitReporter). The reporters
+  // receive the events of the lemma jobs on the output thread, so slow
+  // reporters do not hold up the run.
+  void AddReporter(std::shared_ptr<Reporter> reporter);
+
+  // Shows the lines returned by the given function below the output on
+  // std::cout, which must be a terminal (e.g., the Dashboard). The lines are
+  // redrawn by the output thread after every line of output and once per
+  // second, and removed when the writer is destroyed. The function is only
+  // called on the output thread.
+  void SetStatusProvider(
+          std::function<std::vector<std::string>()> status_provider);
+
+  void ReportLemmaStarted(const LemmaJob& lemma_job);
+
+  void ReportLemmaFinished(const LemmaJob& lemma_job,
+                           const TamarinOutput& tamarin_output);
+
+ private:
+  // The unfinished line of a thread
+  struct PendingLine {
+    std::string colorized_text; // for std::cout
+    std::string text; // for all other streams
+    bool is_in_block = false;
+    size_t block_index = 0;
+    // Formats the inputs, keeping manipulators such as std::setw between
+    // insertions like an ordinary stream
+    std::ostringstream format_stream;
+  };
+
+  struct Block {
+    std::vector<std::string> colorized_lines;
+    std::vector<std::string> lines;
+    bool is_ended = false;
+  };
+
+  // Returns the unfinished line of the calling thread
+  PendingLine& GetPendingLine();
+
+  void Append(const std::string& colorized_text, const std::string& text);
+
+  // Queues an event that the output thread executes
+  void Queue(std::function<void()> event);
+
+  // Executes the queued events until the writer is destroyed
+  void RunOutputThread();
+
+  // The following functions are only called on the output thread
+  void WriteLine(const std::string& colorized_line, const std::string& line);
+  void WriteBlockLine(size_t index, const std::string& colorized_line,
+                      const std::string& line);
+  void WriteEndOfBlock(size_t index);
+  void WriteBufferedBlocks();
+  void DrawStatus();
+  void ClearStatus();
 
   std::vector<std::ostream*> streams_;
+  OutputOrder output_order_;
   std::unordered_map<TextColor, std::string> color_code_of_;
+
+  MpscQueue<std::function<void()>> events_;
+  std::atomic<bool> is_output_thread_waiting_;
+  std::atomic<bool> has_status_;
+  bool is_stopping_;
+  std::mutex mutex_;
+  std::condition_variable event_available_;
+  std::unordered_map<std::thread::id, PendingLine> pending_line_of_;
+  std::mutex pending_lines_mutex_;
+
+  // State of the output thread
+  std::vector<std::shared_ptr<Reporter>> reporters_;
+  std::function<std::vector<std::string>()> status_provider_;
+  size_t number_of_status_lines_;
+  std::map<size_t, Block> buffered_blocks_;
+  size_t next_block_index_;
+
+  std::thread output_thread_;
 };
 
 template<typename T>
 OutputWriter& OutputWriter::operator<<(T input) {
-  for(auto stream : streams_){
-    *stream << input;
-  }
+  auto& format_stream = GetPendingLine().format_stream;
+  format_stream.str("");
+  format_stream << input;
+  Append(format_stream.str(), format_stream.str());
   return *this;
 }
 
 template<typename T>
 OutputWriter& OutputWriter::WriteColorized(T input, TextColor color) {
-  for(auto stream : streams_){
-    if(stream == &std::cout) WriteColorized(*stream, input, color);
-    else *stream << input;
-  }
-  return *this;
-}
-
-template<typename T>
-OutputWriter& OutputWriter::WriteColorized(std::ostream& stream,
-                                           T input,
-                                           TextColor color) {
-  stream << "\033[" << color_code_of_[color] << "m" << input << "\033[m";
+  auto& format_stream = GetPendingLine().format_stream;
+  format_stream.str("");
+  format_stream << input;
+  Append("\033[" + color_code_of_.at(color) + "m" + format_stream.str() +
+         "\033[m", format_stream.str());
   return *this;
 }
 
@@ -25,24 +25,39 @@
 
 #include "lemma_job_generator.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace uttamarin {
 
+class LemmaHistory;
+class TheoryIndex;
+
 class PenetrationLemmaJobGenerator : public LemmaJobGenerator {
 
  public:
-  PenetrationLemmaJobGenerator(const std::string& spthy_file_path,
-                               const std::string& lemma_name);
+  // If a history and a theory index are given, the heuristics are ordered by
+  // a HeuristicBandit that is trained on the history. Otherwise, they are
+  // tried in the fixed order of GetAllHeuristics.
+  PenetrationLemmaJobGenerator(
+          const std::string& spthy_file_path,
+          const std::string& lemma_name,
+          std::shared_ptr<LemmaHistory> history=nullptr,
+          std::shared_ptr<const TheoryIndex> theory_index=nullptr);
 
   virtual ~PenetrationLemmaJobGenerator() = default;
 
+  // Returns all heuristics supported by Tamarin in a fixed order.
+  static const std::vector<TamarinHeuristic>& GetAllHeuristics();
+
  private:
   virtual std::vector<LemmaJob> DoGenerateLemmaJobs() override;
 
   std::string spthy_file_path_;
   std::string lemma_name_;
+  std::shared_ptr<LemmaHistory> history_;
+  std::shared_ptr<const TheoryIndex> theory_index_;
 };
 
 } // namespace uttamarin
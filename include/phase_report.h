@@ -0,0 +1,62 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_PHASE_REPORT_H_
+#define UT_TAMARIN_PHASE_REPORT_H_
+
+#include <string>
+#include <vector>
+
+#include "tracing.h"
+
+namespace uttamarin {
+
+class OutputWriter;
+
+// Splits the time of a run into the time spent in Tamarin and the overhead
+// of UT Tamarin itself (setup, lemma discovery, preprocessing, parsing and
+// printing), based on the phase statistics of the spans (see tracing.h).
+struct PhaseBreakdown {
+  double wall_time; // of the whole run, in seconds
+  double prover_time; // sum of all Tamarin runs on lemmas
+  double overhead_time; // sum of all phases except for Tamarin runs
+  double job_wall_time; // wall-clock time of processing the lemma jobs
+  double busy_time; // sum of the time workers spent on lemma jobs
+  double idle_time; // time workers waited while the lemma jobs ran
+  double parallel_efficiency; // busy time / (workers * job wall time)
+  int number_of_workers;
+  std::vector<tracing::PhaseStatistics> phases;
+};
+
+// Computes the breakdown of the run so far from the phase statistics.
+PhaseBreakdown ComputePhaseBreakdown(int number_of_workers);
+
+void PrintPhaseBreakdown(const PhaseBreakdown& breakdown,
+                         OutputWriter& output_writer);
+
+// Writes the breakdown as JSON to the given file.
+void WritePhaseBreakdown(const PhaseBreakdown& breakdown,
+                         const std::string& json_file_path);
+
+} // namespace uttamarin
+
+#endif
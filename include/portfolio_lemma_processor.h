@@ -0,0 +1,67 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_PORTFOLIO_LEMMA_PROCESSOR_H_
+#define UT_TAMARIN_PORTFOLIO_LEMMA_PROCESSOR_H_
+
+#include "lemma_processor.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace uttamarin {
+
+// Decorator that runs a lemma job as a portfolio of heuristics on a single
+// core: it cycles through the heuristics of PenetrationLemmaJobGenerator
+// (starting with the heuristic of the job, if any) and restarts Tamarin with
+// every heuristic for a time slice. The slices grow according to the Luby
+// sequence (1, 1, 2, 1, 1, 2, 4, ...) times the base slice, so that no
+// heuristic is starved for long. The portfolio stops at the first definitive
+// result or when the overall timeout is used up. Its output has the heuristic
+// of the result and the running time and resource usage of all slices, so
+// that decorators around it (e.g., HistoryLemmaProcessor) account for the
+// portfolio as a whole.
+class PortfolioLemmaProcessor : public LemmaProcessor {
+ public:
+  // Both 'base_slice' and 'timeout' are in seconds. A timeout of 0 means that
+  // the portfolio runs until some heuristic produces a definitive result.
+  PortfolioLemmaProcessor(std::unique_ptr<LemmaProcessor> decoratee,
+                          int base_slice,
+                          int timeout);
+  virtual ~PortfolioLemmaProcessor() = default;
+
+ private:
+  virtual TamarinOutput DoProcessLemma(const LemmaJob& lemma_job) override;
+
+  // Returns the heuristics of the portfolio in the order in which they are
+  // tried within a round.
+  std::vector<std::string> GetHeuristicOrder(const LemmaJob& lemma_job);
+
+  std::unique_ptr<LemmaProcessor> decoratee_;
+  int base_slice_;
+  int timeout_;
+};
+
+} // namespace uttamarin
+
+#endif
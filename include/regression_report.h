@@ -0,0 +1,61 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_REGRESSION_REPORT_H_
+#define UT_TAMARIN_REGRESSION_REPORT_H_
+
+#include <string>
+#include <vector>
+
+namespace uttamarin {
+
+class LemmaHistory;
+class OutputWriter;
+
+// A lemma whose result, wall-clock time or number of steps in the current
+// run is worse than in earlier runs.
+struct Regression {
+  std::string lemma_name;
+  std::string metric; // "result", "wall time" or "steps"
+  double baseline; // for "result": 1 if earlier runs were definitive
+  double current;
+};
+
+// Compares the records of the run with the given id with the records of
+// earlier runs in the history. The baseline of a lemma is the median over its
+// last definitive records (of at most five earlier runs). A lemma regressed
+// if it has no definitive result anymore, or if its wall-clock time or its
+// number of steps exceeds the baseline by more than 'threshold' (e.g., 0.2
+// for 20%). Differences in the wall-clock time below one second are ignored.
+std::vector<Regression> FindRegressions(const LemmaHistory& history,
+                                        const std::vector<std::string>& lemmas,
+                                        const std::string& run_id,
+                                        double threshold);
+
+// Prints the given regressions (or that there are none).
+void PrintRegressionReport(const std::vector<Regression>& regressions,
+                           double threshold,
+                           OutputWriter& output_writer);
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,112 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef UT_TAMARIN_REMOTE_LEMMA_PROCESSOR_H_
+#define UT_TAMARIN_REMOTE_LEMMA_PROCESSOR_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "lemma_processor.h"
+
+namespace uttamarin {
+
+// Runs lemma jobs on workers ('uttamarin worker', see RunLemmaWorker), which
+// may run on other machines. A worker is given either by a command that
+// starts a worker speaking over its standard input and output (e.g.,
+// "ssh prover2 uttamarin worker -j 16" or, on one host, "uttamarin worker
+// -j 2") or by the TCP address "HOST:PORT" of a listening worker. Every
+// theory is sent to a worker at most once (see worker_protocol.h).
+// Every worker has a queue of jobs, and a job is queued at the worker with
+// the lowest load, preferring workers that already have its theory. A worker
+// with free slots and an empty queue steals the latest job from the longest
+// queue of another worker. The jobs of a worker that is lost run again on
+// another worker, as do jobs whose Tamarin crashed (on a worker that did not
+// run them yet), up to kMaxAttempts runs per job. Every worker has a writer
+// thread of its own, so a stalled worker only holds up its own jobs, and a
+// TCP worker that accepts no data for a minute is lost.
+class RemoteLemmaProcessor : public LemmaProcessor {
+ public:
+  // Starts or connects to the given workers and waits for them to say hello.
+  // Workers that cannot be reached are left out with a warning. The timeout
+  // (in seconds) applies to lemma jobs without a timeout of their own.
+  RemoteLemmaProcessor(const std::vector<std::string>& workers, int timeout);
+
+  // Disconnects from the workers, which then stop.
+  virtual ~RemoteLemmaProcessor();
+
+  // Returns the number of Tamarin instances that the connected workers run
+  // in parallel, which is the number of jobs worth running at a time.
+  int GetNumberOfSlots() const;
+
+  // Returns the Tamarin version of the first connected worker.
+  std::string GetTamarinVersion() const;
+
+ private:
+  struct Job;
+  struct Worker;
+
+  // Queues the given job at the best connected worker that did not run it
+  // yet. Returns false if there is no such worker.
+  bool Enqueue(std::shared_ptr<Job> job);
+
+  // Sends queued (or stolen) jobs to the workers with free slots.
+  void Dispatch();
+
+  void Cancel(std::shared_ptr<Job> job);
+
+  void Finish(std::shared_ptr<Job> job, const TamarinOutput& tamarin_output);
+
+  // Queues the given message for the writer of the given worker.
+  void Post(Worker* worker, nlohmann::json message);
+
+  // Sends the queued messages of the given worker without holding the lock,
+  // so that a stalled worker only holds up itself, until the worker is lost.
+  void WriteMessages(Worker* worker);
+
+  // Receives the results of the given worker until the connection ends and
+  // then retries its unfinished jobs on the other workers.
+  void ReadResults(Worker* worker);
+
+  virtual TamarinOutput DoProcessLemma(const LemmaJob& lemma_job) override;
+
+  int timeout_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::unordered_map<std::string, std::string> theory_of_; // by hash
+  std::unordered_map<std::string, int> theory_users_; // by hash
+  uint64_t next_job_id_;
+  bool is_stopping_;
+  mutable std::mutex mutex_;
+  std::condition_variable job_finished_;
+};
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,99 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef UT_TAMARIN_REMOTE_RESULT_CACHE_H_
+#define UT_TAMARIN_REMOTE_RESULT_CACHE_H_
+
+#include <atomic>
+#include <optional>
+#include <string>
+
+#include "lemma_processor.h"
+
+namespace uttamarin {
+
+// A result cache on an HTTP server that several users and CI runners share
+// (see CachingLemmaProcessor), in the style of the remote caches of build
+// systems: GET /results/<key> returns the result of a lemma job as JSON (see
+// ToJson in worker_protocol.h) or 404 if the cache has none, and
+// PUT /results/<key> stores it. /proofs/<key> does the same for the proof
+// that Tamarin wrote (see -p). PUT requests carry the write token of the
+// cache as "Authorization: Bearer <token>", since everybody who can store a
+// result can make every reader skip that lemma. Any server that stores the
+// bodies of authorized PUT requests under their path can be the cache;
+// 'uttamarin cache_server' (see RunCacheServer) is a minimal one. If the
+// server cannot be reached, the cache is left out for the rest of the run.
+class RemoteResultCache {
+ public:
+  // The URL has the form "http://HOST[:PORT][/PATH]". Without a write token
+  // (e.g., for a developer whose cache is filled by CI), the cache is
+  // read-only and stores nothing.
+  RemoteResultCache(const std::string& url,
+                    const std::string& write_token="");
+
+  // Returns false if the URL has not the form above.
+  bool IsValid() const;
+
+  // Returns the result stored for the given key or no value if there is none.
+  std::optional<TamarinOutput> Find(const std::string& key);
+
+  void Insert(const std::string& key, const TamarinOutput& tamarin_output);
+
+  // Returns the proof stored for the given key or no value if there is none.
+  std::optional<std::string> FindProof(const std::string& key);
+
+  void InsertProof(const std::string& key, const std::string& proof);
+
+ private:
+  // Sends an HTTP request for the given path (below the path of the URL) and
+  // fills the body of the response. Returns the status code of the response
+  // or -1 if the server cannot be reached.
+  int SendRequest(const std::string& method, const std::string& path,
+                  const std::string& body, std::string& response_body);
+
+  std::string url_;
+  std::string host_;
+  std::string port_;
+  std::string path_;
+  std::string write_token_;
+  bool is_valid_;
+  std::atomic<bool> is_unreachable_;
+  std::atomic<bool> is_refusing_;
+};
+
+// Returns the token in the given file (e.g., a secret of the CI), without
+// surrounding whitespace, or no value if the file cannot be read or is empty.
+std::optional<std::string> ReadCacheToken(const std::string& token_file_path);
+
+// Runs 'uttamarin cache_server', a minimal HTTP server for RemoteResultCache
+// that listens on the given TCP address ("HOST:PORT") and stores results and
+// proofs as files in the given directory. Only PUT requests with the given
+// write token store anything; without a token, the cache is read-only.
+// Returns false if the server cannot listen on the address.
+bool RunCacheServer(const std::string& listen_address,
+                    const std::string& directory,
+                    const std::string& write_token);
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,61 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_REPORTER_H_
+#define UT_TAMARIN_REPORTER_H_
+
+namespace uttamarin {
+
+class LemmaJob;
+
+struct TamarinOutput;
+
+// A machine-readable report of a run that is written incrementally as the
+// lemma jobs start and finish (see OutputWriter::AddReporter), so that a
+// killed run still leaves a valid report of the jobs finished so far. The
+// times are given in seconds since the epoch.
+class Reporter {
+ public:
+  virtual ~Reporter() = default;
+
+  void ReportLemmaStarted(const LemmaJob& lemma_job, double time) {
+    DoReportLemmaStarted(lemma_job, time);
+  }
+
+  void ReportLemmaFinished(const LemmaJob& lemma_job,
+                           const TamarinOutput& tamarin_output,
+                           double time) {
+    DoReportLemmaFinished(lemma_job, tamarin_output, time);
+  }
+
+ private:
+  virtual void DoReportLemmaStarted(const LemmaJob& lemma_job,
+                                    double time) = 0;
+
+  virtual void DoReportLemmaFinished(const LemmaJob& lemma_job,
+                                     const TamarinOutput& tamarin_output,
+                                     double time) = 0;
+};
+
+} // namespace uttamarin
+
+#endif
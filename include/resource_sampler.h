@@ -0,0 +1,105 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_RESOURCE_SAMPLER_H_
+#define UT_TAMARIN_RESOURCE_SAMPLER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lemma_processor.h"
+
+namespace uttamarin {
+
+// Polls the CPU time, resident memory, major faults and I/O of watched
+// processes (and all their subprocesses) from /proc at a fixed interval on a
+// background thread. This shows how the memory of a Tamarin run ramps up and
+// whether Tamarin actually uses the cores it runs on, which the final rusage
+// of a run does not. If tracing is enabled, the samples are also recorded as
+// counters on a track per worker.
+class ResourceSampler {
+ public:
+  // The latest sample of a watched process
+  struct RunningProcess {
+    std::string label;
+    ResourceSample sample;
+  };
+
+  // Takes the sampling interval in milliseconds. Unless 'is_keeping_samples'
+  // is set, only the latest sample of each process is kept (e.g., for live
+  // displays) and Unwatch returns no samples.
+  explicit ResourceSampler(int interval, bool is_keeping_samples=true);
+
+  // Stops the sampling thread.
+  ~ResourceSampler();
+
+  ResourceSampler(const ResourceSampler&) = delete;
+  ResourceSampler& operator=(const ResourceSampler&) = delete;
+
+  // Starts sampling the process with the given id. The samples are recorded
+  // on the trace track of the calling thread. The label (e.g., the lemma
+  // name) identifies the process in GetRunningProcesses.
+  void Watch(int pid, const std::string& label="");
+
+  // Stops sampling the process with the given id and returns its samples.
+  std::vector<ResourceSample> Unwatch(int pid);
+
+  // Returns the latest sample of every watched process that was sampled at
+  // least once.
+  std::vector<RunningProcess> GetRunningProcesses();
+
+ private:
+  struct WatchedProcess {
+    std::string label;
+    std::string counter_suffix; // e.g., " (worker 0)"
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point last_sample_time;
+    long long last_cpu_ticks;
+    std::vector<ResourceSample> samples;
+  };
+
+  void Run();
+
+  // Takes one sample of every watched process
+  void SampleProcesses();
+
+  int interval_;
+  bool is_keeping_samples_;
+  std::map<int, WatchedProcess> watched_processes_;
+  bool is_stopping_;
+  std::mutex mutex_;
+  std::condition_variable stop_requested_;
+  std::thread thread_;
+};
+
+// Returns the resident memory in KB of the given process and all its
+// subprocesses (e.g., of UT Tamarin and all running Tamarin processes).
+long ReadProcessTreeMemory(int pid);
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,52 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_RESULT_CACHE_H_
+#define UT_TAMARIN_RESULT_CACHE_H_
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "lemma_processor.h"
+
+namespace uttamarin {
+
+// A thread-safe in-memory store of Tamarin results, indexed by a key that
+// identifies the theory, the lemma and the heuristic of a lemma job (see
+// CachingLemmaProcessor).
+class ResultCache {
+ public:
+  // Returns the result stored for the given key or no value if there is none.
+  std::optional<TamarinOutput> Find(const std::string& key) const;
+
+  void Insert(const std::string& key, const TamarinOutput& tamarin_output);
+
+ private:
+  std::unordered_map<std::string, TamarinOutput> output_of_;
+  mutable std::mutex mutex_;
+};
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,78 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_TAMARIN_OUTPUT_PARSER_H_
+#define UT_TAMARIN_TAMARIN_OUTPUT_PARSER_H_
+
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "lemma_processor.h"
+
+namespace uttamarin {
+
+// Takes as input a stream of Tamarin output and the name of a lemma and fills
+// the result, the number of steps, the processing time and the warnings from
+// the summary at the end of the output into 'tamarin_output'. Returns false
+// if the output contains no summary (e.g., because Tamarin was killed).
+bool ParseTamarinOutput(std::istream& tamarin_stream,
+                        const std::string& lemma_name,
+                        TamarinOutput& tamarin_output);
+
+// Returns the summary section of the given Tamarin output, i.e., everything
+// from the last line "summary of summaries:" to the end, or an empty view if
+// there is no such line. Since the summary is at the end of the output, the
+// search starts with a small window at the end and doubles it until the
+// summary is found, so proofs preceding the summary are usually not read.
+std::string_view FindSummarySection(std::string_view tamarin_output);
+
+// Returns the summary section (see FindSummarySection) of the Tamarin output
+// in the given file, which is memory-mapped instead of read. Returns no value
+// if the file cannot be read or has no summary.
+std::optional<std::string> ReadSummarySection(
+        const std::string& tamarin_output_path);
+
+// Parses the machine-readable statistics of the GHC runtime (as written by
+// "+RTS -t<file> --machine-readable -RTS") into 'gc_statistics'. Returns false
+// if the stream contains no such statistics.
+bool ParseGcStatistics(std::istream& rts_stream, GcStatistics& gc_statistics);
+
+// Determines why Tamarin did not produce a definitive result, given the
+// result parsed from its output, whether the output contains a summary, the
+// exit code of the command that ran Tamarin (kTimeoutExitCode if it timed
+// out) and Tamarin's error output.
+FailureReason DetermineFailureReason(ProverResult result,
+                                     bool has_summary,
+                                     int exit_code,
+                                     const std::string& error_output);
+
+// Returns a name for the failure reason (e.g., "timeout" or "parse error").
+std::string ToString(const FailureReason& failure_reason);
+
+// Inverse of ToString. Unknown names map to FailureReason::None.
+FailureReason ToFailureReason(const std::string& name);
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,81 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_TASK_CONTROL_H_
+#define UT_TAMARIN_TASK_CONTROL_H_
+
+#include <chrono>
+#include <mutex>
+#include <set>
+
+namespace uttamarin {
+
+// Suspends, resumes and cancels the processes of a task (e.g., a lemma job
+// that a FairShareScheduler runs) as a whole. RunShellCommand starts every
+// command in a process group of its own and adds the group to the control of
+// the calling thread (if any), so that signals reach Tamarin and all its
+// subprocesses. The control keeps the time the task was suspended, so
+// that timeouts only count the time in which the task could run.
+class TaskControl {
+ public:
+  TaskControl();
+
+  // Returns the control of the task that the calling thread executes or
+  // nullptr if the thread does not execute such a task.
+  static TaskControl* GetCurrent();
+
+  // Makes the given control the control of the calling thread.
+  static void SetCurrent(TaskControl* task_control);
+
+  // Stops all processes of the task until Resume is called. Processes that
+  // the task starts in the meantime are stopped right away.
+  void Suspend();
+
+  void Resume();
+
+  bool IsSuspended() const;
+
+  // Kills all processes of the task. Processes that the task starts
+  // afterwards are killed right away.
+  void Cancel();
+
+  bool IsCancelled() const;
+
+  // Returns the time in seconds that the task has been suspended so far.
+  double GetSuspendedTime() const;
+
+  void AddProcessGroup(int process_group);
+
+  void RemoveProcessGroup(int process_group);
+
+ private:
+  std::set<int> process_groups_;
+  bool is_suspended_;
+  bool is_cancelled_;
+  std::chrono::steady_clock::time_point suspend_time_;
+  double suspended_time_; // of the finished suspensions, in seconds
+  mutable std::mutex mutex_;
+};
+
+} // namespace uttamarin
+
+#endif
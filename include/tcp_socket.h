@@ -0,0 +1,48 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef UT_TAMARIN_TCP_SOCKET_H_
+#define UT_TAMARIN_TCP_SOCKET_H_
+
+#include <string>
+
+namespace uttamarin {
+
+// Splits a TCP address "HOST:PORT" (e.g., "prover2:7300" or "[::1]:7300")
+// into its host and port. Returns false if the given string is no such
+// address (e.g., because it is the command of a worker).
+bool SplitAddress(const std::string& address, std::string& host,
+                  std::string& port);
+
+// Returns a socket listening on the given address ("HOST:PORT") or -1 after
+// printing an error.
+int ListenOnAddress(const std::string& listen_address);
+
+// Returns a socket connected to the given host and port or -1. If a timeout
+// (in seconds) is given, connecting, sending and receiving give up after it.
+int ConnectToAddress(const std::string& host, const std::string& port,
+                     int timeout=0);
+
+} // namespace uttamarin
+
+#endif
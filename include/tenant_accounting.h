@@ -0,0 +1,73 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_TENANT_ACCOUNTING_H_
+#define UT_TAMARIN_TENANT_ACCOUNTING_H_
+
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace uttamarin {
+
+class OutputWriter;
+
+struct TamarinOutput;
+
+// The resources that the Tamarin runs of a tenant consumed
+struct TenantUsage {
+  int jobs = 0;
+  double cpu_time = 0; // in seconds
+  double wall_time = 0; // in seconds
+};
+
+// Accounts the resources that the Tamarin runs of every tenant of a
+// JobServer consumed. If an accounting file is given, every job is appended
+// to it as a JSON object per line, and the jobs already in the file are
+// included in the usage, so that the accounts survive restarts.
+class TenantAccounting {
+ public:
+  TenantAccounting(const std::string& accounting_file_path="");
+
+  void AddJob(const std::string& tenant, const std::string& lemma_name,
+              const TamarinOutput& tamarin_output);
+
+  std::map<std::string, TenantUsage> GetUsage() const;
+
+ private:
+  void AddUsage(const std::string& tenant, double cpu_time,
+                double wall_time);
+
+  std::string accounting_file_path_;
+  std::map<std::string, TenantUsage> usage_of_;
+  mutable std::mutex mutex_;
+};
+
+// Prints the jobs, CPU hours and wall-clock hours of each tenant together
+// with its share of all CPU hours.
+void PrintAccountingReport(
+        const std::map<std::string, TenantUsage>& usage_of_tenants,
+        OutputWriter& output_writer);
+
+} // namespace uttamarin
+
+#endif
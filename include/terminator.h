@@ -23,17 +23,25 @@
 #ifndef UT_TAMARIN_TERMINATOR_H_ 
 #define UT_TAMARIN_TERMINATOR_H_
 
-#include <string>
+#include <sys/types.h>
 
 namespace uttamarin::termination {
 
-// Signal handler for SIGINT signal (sent by Ctrl+C)
+// Signal handler for SIGINT (sent by Ctrl+C), SIGTERM and SIGHUP, which
+// stops the registered process groups and then the program
 void sigint_handler(int signal);
 
-// Sets the global 'tamarin_process' name. This is needed for killing Tamarin
-// in case the program receives a SIGINT signal (sent by Ctrl+C).
+// Registers the signal handler for SIGINT, SIGTERM and SIGHUP. This is needed
+// for stopping Tamarin in case the program receives one of these signals.
 void registerSIGINTHandler();
 
+// Registers a process group that is stopped with the program. Only the
+// registered groups are stopped, never Tamarin processes of others.
+void registerProcessGroup(pid_t process_group);
+
+// Removes a process group once it has exited.
+void unregisterProcessGroup(pid_t process_group);
+
 } // namespace uttamarin::termination
 
 #endif
@@ -0,0 +1,155 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_THEORY_INDEX_H_
+#define UT_TAMARIN_THEORY_INDEX_H_
+
+#include <functional>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace uttamarin {
+
+// Returns the contents of the given file or no value if it cannot be read
+using IncludedFileReader =
+        std::function<std::optional<std::string>(const std::string&)>;
+
+struct LemmaInfo {
+  std::string name;
+  std::vector<std::string> attributes; // e.g., "reuse" or "use_induction"
+  bool is_exists_trace;
+  std::string formula;
+  std::string hash; // hash of the whole declaration, including any proof
+};
+
+struct RuleInfo {
+  std::string name;
+  std::set<std::string> premise_facts;
+  std::set<std::string> action_facts;
+  std::set<std::string> conclusion_facts;
+  std::string hash;
+};
+
+struct RestrictionInfo {
+  std::string name;
+  std::string formula;
+  std::string hash;
+};
+
+// A lightweight index of a Tamarin theory file that is built without calling
+// Tamarin. It knows the lemmas of the theory together with their formulas and
+// the fact symbols used by the rules of the theory. Rules, restrictions,
+// lemmas and the signature (builtins, functions, equations, ...) are hashed
+// separately, which allows to tell which lemmas are affected by a change.
+// Files that the theory includes (see GetIncludedFiles) are indexed as part
+// of the theory.
+class TheoryIndex {
+ public:
+  // Reads and indexes the given Tamarin theory file (".spthy").
+  TheoryIndex(const std::string& spthy_file_path);
+
+  // Indexes the given contents of the Tamarin theory file with the given
+  // path, whose included files are read by 'read_file' (by default, from the
+  // file system).
+  static TheoryIndex FromTheoryText(
+          const std::string& theory_text,
+          const std::string& spthy_file_path="",
+          const IncludedFileReader& read_file=nullptr);
+
+  // Returns the hash of the contents of the theory file, including the
+  // contents of the files it includes (see ReadTheoryText).
+  const std::string& GetTheoryHash() const;
+
+  // Returns the lemmas of the theory in the order of their declaration.
+  const std::vector<LemmaInfo>& GetLemmas() const;
+
+  // Returns the lemma with the given name or nullptr if there is no such
+  // lemma.
+  const LemmaInfo* FindLemma(const std::string& lemma_name) const;
+
+  const std::vector<RuleInfo>& GetRules() const;
+
+  const std::vector<RestrictionInfo>& GetRestrictions() const;
+
+  // Returns the fact symbols used in the rules of the theory, except for
+  // Tamarin's built-in facts (like Fr, In and Out), which cannot be renamed.
+  std::set<std::string> GetFactSymbols() const;
+
+  // Returns a list of features of the given lemma, such as its trace
+  // quantifier, its quantifier structure and the fact symbols it uses (e.g.,
+  // "trace:exists", "quantifier:All", "fact:Start"). Features are used for
+  // comparing lemmas of different theories with each other.
+  std::vector<std::string> GetLemmaFeatures(
+          const std::string& lemma_name) const;
+
+  // Returns the names of the rules that the given lemma can depend on: the
+  // rules whose actions or conclusions are used by the lemma or by a
+  // restriction, and, transitively, the rules producing the premises of such
+  // rules. Premises 'In' and adversary knowledge 'K' depend on all rules with
+  // conclusion 'Out'. Rules are returned in the order of their declaration.
+  std::vector<std::string> GetRulesInCone(const std::string& lemma_name) const;
+
+  // Returns a hash of everything the given lemma can depend on: the
+  // signature, all restrictions, the rules in its cone (see GetRulesInCone),
+  // the lemma itself and the preceding lemmas that Tamarin reuses for it
+  // (attributes "reuse" and "sources"). The cone over-approximates the
+  // dependencies syntactically, so a lemma whose hash does not change
+  // between two versions of a theory most likely keeps its result, but this
+  // is a heuristic, not a guarantee (e.g., for changes that the index does
+  // not parse). Returns the empty string if there is no such lemma.
+  std::string GetLemmaConeHash(const std::string& lemma_name) const;
+
+ private:
+  TheoryIndex() = default;
+
+  void ParseTheory(const std::string& theory_text);
+
+  // Parses the rule starting at 'pos' (right after the keyword "rule") and
+  // moves 'pos' to the end of the rule.
+  void ParseRule(const std::string& text, size_t& pos);
+
+  // Parses the restriction (or axiom) starting at 'pos' (right after the
+  // keyword) and moves 'pos' to the end of the restriction.
+  void ParseRestriction(const std::string& text, size_t& pos);
+
+  std::string theory_hash_;
+  std::string signature_hash_;
+  std::vector<LemmaInfo> lemmas_;
+  std::vector<RuleInfo> rules_;
+  std::vector<RestrictionInfo> restrictions_;
+};
+
+// Returns the contents of the given theory file with every #include
+// directive replaced by the contents of the included file, like Tamarin's
+// preprocessor. A change of an included file changes the result.
+std::string ReadTheoryText(const std::string& spthy_file_path);
+
+// Returns the files that the given theory file includes with Tamarin's
+// preprocessor directive #include "file" (relative to the including file),
+// directly or transitively, in the order in which they are included.
+std::vector<std::string> GetIncludedFiles(const std::string& spthy_file_path);
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,92 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_THEORY_WATCHER_H_
+#define UT_TAMARIN_THEORY_WATCHER_H_
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cmd_parameters.h"
+#include "lemma_processor_factory.h"
+
+namespace uttamarin {
+
+class Dashboard;
+class OutputWriter;
+class WatchedJobs;
+
+// Runs the lemmas of a theory again whenever the theory, the files it
+// includes or the config file change ('uttamarin --watch'). Every change
+// starts a new run (see App::RunOnLemmas) that ends the previous one. Jobs
+// of lemmas whose cone (see TheoryIndex::GetLemmaConeHash) changed are
+// cancelled, while the others keep running and keep their results (see
+// WatchedJobs). Changes of the config or of included files affect all
+// lemmas. The affected lemmas run before the lemmas with known results.
+// Every run gets the processor chain of a normal run (see
+// CreateLemmaProcessor).
+class TheoryWatcher {
+ public:
+  // The parts are shared by the processor chains of all runs. The dashboard
+  // (if any) learns the lemmas of every run.
+  TheoryWatcher(const CmdParameters& parameters,
+                const LemmaProcessorParts& lemma_processor_parts,
+                std::shared_ptr<OutputWriter> output_writer,
+                std::shared_ptr<Dashboard> dashboard);
+
+  // Waits for the current run to end.
+  ~TheoryWatcher();
+
+  // Runs the lemmas and watches the files until the process is terminated
+  // (e.g., by Ctrl+C). Returns false if the files cannot be watched.
+  bool Run();
+
+ private:
+  // Ends the current run and starts a run on the current contents of the
+  // files on a thread of its own. The changed files are only reported.
+  void StartRun(const std::vector<std::string>& changed_files);
+
+  // Returns the lemmas of the theory, which Tamarin only reads again if the
+  // declared lemmas or the context (see StartRun) changed
+  std::vector<std::string> GetLemmaNames(
+          const std::vector<std::string>& declared_lemmas,
+          const std::string& context_hash);
+
+  // Returns the files to watch: the theory, the files it includes and the
+  // config file (if any)
+  std::vector<std::string> GetWatchedFiles() const;
+
+  CmdParameters parameters_;
+  LemmaProcessorParts lemma_processor_parts_;
+  std::shared_ptr<OutputWriter> output_writer_;
+  std::shared_ptr<Dashboard> dashboard_;
+  std::shared_ptr<WatchedJobs> watched_jobs_;
+  std::vector<std::string> lemma_names_;
+  std::string lemma_names_source_; // declared lemmas and context hash
+  std::thread run_thread_;
+};
+
+} // namespace uttamarin
+
+#endif
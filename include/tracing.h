@@ -0,0 +1,96 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_TRACING_H_
+#define UT_TAMARIN_TRACING_H_
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace uttamarin::tracing {
+
+// Accumulated durations of all spans with the same name
+struct PhaseStatistics {
+  std::string name;
+  long long count;
+  double total_time; // in seconds
+  double max_time; // in seconds
+};
+
+// Starts recording trace events. At exit, the events are written to the given
+// file in the Trace Event Format, which chrome://tracing and Perfetto
+// (ui.perfetto.dev) can load directly. Without a call to Start, nothing is
+// recorded.
+void Start(const std::string& trace_file_path);
+
+bool IsEnabled();
+
+// Writes the events recorded so far to the trace file. This is called
+// automatically at exit.
+void Write();
+
+// Records the current values of a counter (e.g., {"rss_mb", 512}), which
+// trace viewers show as a graph on a track of its own. Does nothing unless
+// recording was started.
+void RecordCounter(const std::string& name,
+                   const std::vector<std::pair<std::string, double>>& values);
+
+// Starts accumulating statistics over the spans of each name (independently
+// of Start). Returns immediately if statistics are already enabled.
+void EnableStatistics();
+
+// Returns the statistics of all span names seen since EnableStatistics,
+// sorted by name.
+std::vector<PhaseStatistics> GetPhaseStatistics();
+
+// Returns the statistics of the spans with the given name (with count 0 if
+// there are none).
+PhaseStatistics GetPhaseStatistics(const std::string& name);
+
+// Returns the time in seconds since EnableStatistics.
+double GetElapsedTime();
+
+// Records the time from its construction to its destruction as a span on the
+// track of the calling thread: track 0 is the main thread, track i + 1 is
+// worker i of the WorkerPool. The optional detail (e.g., a lemma name) is
+// shown as an argument of the span. Spans also count towards the phase
+// statistics.
+class ScopedSpan {
+ public:
+  explicit ScopedSpan(const std::string& name, const std::string& detail="");
+  ~ScopedSpan();
+
+  ScopedSpan(const ScopedSpan&) = delete;
+  ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+ private:
+  bool is_enabled_;
+  std::string name_;
+  std::string detail_;
+  std::chrono::steady_clock::time_point start_time_;
+};
+
+} // namespace uttamarin::tracing
+
+#endif
@@ -58,13 +58,47 @@ class UtTamarinConfig {
   std::string GetPenetrationLemma() const;
   std::string GetProofDirectory() const;
   int GetTimeout() const;
+  int GetJobs() const;
   bool IsAbortAfterFailure() const;
   const std::vector<std::string>& GetLemmaAllowList() const;
   const std::vector<std::string>& GetLemmaDenyList() const;
   const FactAnnotations& GetGlobalAnnotations() const;
   FactAnnotations GetLocalAnnotations(const std::string& lemma) const;
+  void SetLocalAnnotations(const std::string& lemma,
+                           const FactAnnotations& annotations);
+
+  // Returns the heuristic specified for the given lemma in the section
+  // "lemma_heuristics" of the config file (the empty string if there is no
+  // such heuristic).
+  std::string GetLemmaHeuristic(const std::string& lemma) const;
+  const std::unordered_map<std::string, std::string>& GetLemmaHeuristics()
+  const;
+
+  // Writes the given heuristics as the section "lemma_heuristics" to the JSON
+  // file at 'config_file_path'. If the file already contains a JSON object,
+  // only the section "lemma_heuristics" changes: the given heuristics replace
+  // the entries of their lemmas, and the entries of other lemmas are kept.
+  static void WriteLemmaHeuristics(
+          const std::string& config_file_path,
+          const std::unordered_map<std::string, std::string>& heuristics);
+
+  // Writes the given annotations as the entry for 'lemma_name' in the section
+  // "lemma_annotations" of the JSON file at 'config_file_path'. An existing
+  // entry for the lemma is replaced, all other entries are kept.
+  static void WriteLemmaAnnotations(const std::string& config_file_path,
+                                    const std::string& lemma_name,
+                                    const FactAnnotations& annotations);
+
+  // Returns the JSON representation of a "lemma_annotations" entry.
+  static nlohmann::json ToJsonLemmaAnnotation(
+          const std::string& lemma_name,
+          const FactAnnotations& annotations);
 
  private:
+  // Reads the JSON file at the given path. Returns an empty JSON object if
+  // the file does not exist or does not contain a JSON object.
+  static nlohmann::json ReadJsonObject(const std::string& file_path);
+
   void ParseJsonConfigFile(const std::string& config_file_path);
   static FactAnnotations GetFactAnnotations(nlohmann::json json_annotation);
 
@@ -75,11 +109,13 @@ class UtTamarinConfig {
   std::string penetration_lemma_;
   std::string proof_directory_;
   int timeout_;
+  int jobs_;
   bool abort_after_failure_;
   std::vector<std::string> lemma_allow_list_;
   std::vector<std::string> lemma_deny_list_;
   FactAnnotations global_annotations_;
   std::unordered_map<std::string, FactAnnotations> local_annotations_;
+  std::unordered_map<std::string, std::string> lemma_heuristics_;
 };
 
 } // namespace uttamarin
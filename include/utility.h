@@ -23,6 +23,8 @@
 #ifndef UT_TAMARIN_UTILITY_H_ 
 #define UT_TAMARIN_UTILITY_H_
 
+#include <functional>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -39,10 +41,69 @@ std::string GetStringWithShortestEditDistance(
         const std::vector<std::string>& candidates,
         const std::string& target);
 
+// Exit code of a command that timed out, like that of the command 'timeout'
+const int kTimeoutExitCode = 124;
+
+struct ShellCommandResult {
+  int exit_code; // 128 + signal number if the shell was killed by a signal
+  double duration; // in seconds, without the time the command was suspended
+  double cpu_time; // user and system time of the command, in seconds
+  long max_rss; // peak resident memory of the command's processes, in KB
+  long major_faults; // page faults of the command that required I/O
+};
+
 // Executes a shell command and returns the duration of the execution in
 // seconds.
 int ExecuteShellCommand(const std::string& cmd);
 
+// Executes a shell command and returns its exit code, the duration of the
+// execution and the resources it used (including those of its subprocesses).
+// If given, 'on_start' is called with the process id of the shell right after
+// it was started (e.g., to sample its resource usage while it runs).
+// The command runs in a process group of its own, which is added to the
+// TaskControl of the calling thread (if any) and stopped by the handler of
+// termination::registerSIGINTHandler. The shell is killed if we die. If
+// 'timeout' is positive, the process group is terminated once the command
+// ran for 'timeout' seconds, not counting the time the TaskControl suspended
+// it, and the exit code is kTimeoutExitCode.
+ShellCommandResult RunShellCommand(
+        const std::string& cmd,
+        const std::function<void(int)>& on_start=nullptr,
+        double timeout=0);
+
+// Quotes the given string (e.g., a path) as a single word for the shell
+std::string ShellQuote(const std::string& text);
+
+// Executes a shell command and returns its standard output, or no value if
+// the command fails.
+std::optional<std::string> ReadShellCommandOutput(const std::string& cmd);
+
+// Returns the contents of the given file at the given git revision (e.g.,
+// "HEAD~1" or a branch name) or no value if git cannot provide them.
+std::optional<std::string> ReadFileAtGitRevision(const std::string& file_path,
+                                                 const std::string& revision);
+
+// Computes a 64-bit FNV-1a hash of the given string and returns it as a
+// hexadecimal string.
+std::string HashString(const std::string& input);
+
+// Computes the SHA-256 hash of the given string and returns it as a
+// hexadecimal string. Unlike HashString, it resists collisions that are
+// crafted on purpose, e.g., for keys of a shared cache.
+std::string Sha256String(const std::string& input);
+
+// Returns the hash (see HashString) of the contents of the given file.
+std::string HashFileContents(const std::string& file_path);
+
+// Creates a new, empty file with a unique name in the given directory (by
+// default, the directory for temporary files) and returns its path. The
+// suffix (e.g., ".spthy") is appended to the file name.
+std::string CreateTempFile(const std::string& suffix="",
+                           const std::string& directory="/tmp");
+
+// Removes leading and trailing whitespace from the given string
+std::string Trim(const std::string& text);
+
 // Takes a duration in seconds and converts it into a string saying "duration
 // seconds"
 std::string ToSecondsString(int duration);
@@ -0,0 +1,118 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_WATCH_LEMMA_PROCESSOR_H_
+#define UT_TAMARIN_WATCH_LEMMA_PROCESSOR_H_
+
+#include "lemma_processor.h"
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "task_control.h"
+
+namespace uttamarin {
+
+class TheoryIndex;
+
+// The lemma jobs of a watched theory (see TheoryWatcher) across the runs that
+// follow the changes of the theory. A job is identified by a key (see GetKey)
+// that changes whenever something changes that the result of the job can
+// depend on. Jobs whose key is still current keep running when a new run
+// starts, and their results are reused by later runs.
+class WatchedJobs {
+ public:
+  WatchedJobs();
+
+  // Cancels the running jobs and waits for them to end.
+  ~WatchedJobs();
+
+  // Returns the key of the given job: a hash of the cone of its lemma (see
+  // TheoryIndex::GetLemmaConeHash), its heuristic and the given hash of
+  // everything else the job depends on (e.g., the config and the files that
+  // the theory includes).
+  static std::string GetKey(const TheoryIndex& theory_index,
+                            const std::string& context_hash,
+                            const LemmaJob& lemma_job);
+
+  // Starts a new run whose jobs have the given keys and returns the id of
+  // the run. Running jobs with other keys are stale and get cancelled (their
+  // number is stored in 'cancelled_jobs'). Jobs of earlier runs that are
+  // about to start or wait for a running job end as cancelled.
+  int StartRun(const std::set<std::string>& keys, int& cancelled_jobs);
+
+  bool IsRunning(const std::string& key) const;
+
+  bool HasResult(const std::string& key) const;
+
+  // Returns the result of the job with the given key. Unless the job
+  // already ran or is running, 'process' runs it on a thread of its own, so
+  // that it can outlive the run (see StartRun). Returns a cancelled result
+  // once a later run starts.
+  TamarinOutput Process(int run, const std::string& key,
+                        const LemmaJob& lemma_job,
+                        std::function<TamarinOutput()> process);
+
+ private:
+  struct Job {
+    TaskControl control;
+    std::optional<TamarinOutput> output;
+  };
+
+  int run_;
+  int running_jobs_;
+  std::unordered_map<std::string, std::shared_ptr<Job>> job_of_;
+  mutable std::mutex mutex_;
+  std::condition_variable job_finished_;
+};
+
+// Decorator that runs lemma jobs of watch mode through WatchedJobs, so that
+// jobs of a lemma whose cone did not change are not run again.
+class WatchLemmaProcessor : public LemmaProcessor {
+ public:
+  WatchLemmaProcessor(std::unique_ptr<LemmaProcessor> decoratee,
+                      std::shared_ptr<WatchedJobs> watched_jobs,
+                      int run,
+                      std::shared_ptr<const TheoryIndex> theory_index,
+                      const std::string& context_hash);
+  virtual ~WatchLemmaProcessor() = default;
+
+ private:
+  virtual TamarinOutput DoProcessLemma(const LemmaJob& lemma_job) override;
+
+  // Shared with the threads of the jobs, which may outlive this processor
+  std::shared_ptr<LemmaProcessor> decoratee_;
+  std::shared_ptr<WatchedJobs> watched_jobs_;
+  int run_;
+  std::shared_ptr<const TheoryIndex> theory_index_;
+  std::string context_hash_;
+};
+
+} // namespace uttamarin
+
+#endif
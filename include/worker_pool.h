@@ -0,0 +1,69 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef UT_TAMARIN_WORKER_POOL_H_
+#define UT_TAMARIN_WORKER_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace uttamarin {
+
+// A fixed number of worker threads that execute submitted tasks in the order
+// of their submission.
+class WorkerPool {
+ public:
+  WorkerPool(int number_of_workers);
+
+  // Waits for all submitted tasks to finish and stops the workers.
+  ~WorkerPool();
+
+  void Submit(std::function<void()> task);
+
+  // Blocks until all submitted tasks have finished.
+  void Wait();
+
+  int GetNumberOfWorkers() const;
+
+  // Returns the index (starting at 0) of the worker that executes the calling
+  // thread, or -1 if the calling thread is not a worker.
+  static int GetCurrentWorkerIndex();
+
+ private:
+  void RunWorker(int worker_index);
+
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  int unfinished_tasks_;
+  bool is_stopping_;
+  std::mutex mutex_;
+  std::condition_variable task_available_;
+  std::condition_variable all_tasks_finished_;
+};
+
+} // namespace uttamarin
+
+#endif
@@ -0,0 +1,65 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef UT_TAMARIN_WORKER_PROTOCOL_H_
+#define UT_TAMARIN_WORKER_PROTOCOL_H_
+
+#include "nlohmann/json.hpp"
+
+#include "lemma_processor.h"
+
+namespace uttamarin {
+
+// The protocol between a coordinator (see RemoteLemmaProcessor) and the
+// workers of 'uttamarin worker' (see RunLemmaWorker). Every message is a JSON
+// object preceded by its length in bytes (as a 4-byte big-endian integer),
+// so that it can be sent over pipes (e.g., of 'ssh') as well as sockets.
+// The worker starts with
+//   {"type": "hello", "slots": 4, "tamarin_version": "tamarin-prover 1.8.0"}
+// Theories are sent once per worker and identified by the hash of their
+// contents (see HashString),
+//   {"type": "theory", "hash": "9f3c...", "contents": "theory ..."}
+// followed by lemma jobs on theories that the worker already has,
+//   {"type": "jobs", "theory": "9f3c...", "jobs": [{"id": 7, "lemma":
+//    "secrecy", "heuristic": "C", "timeout": 600}]}
+// and {"type": "cancel", "id": 7} to cancel a job. The worker streams back
+//   {"type": "result", "id": 7, "output": {...}}
+// for every job as soon as it finishes (see ToJson).
+
+// Writes the given message to the given file descriptor. Returns false if
+// the peer is gone.
+bool SendMessage(int file_descriptor, const nlohmann::json& message);
+
+// Reads the next message from the given file descriptor. Returns false at
+// the end of the stream or if the data is not a message.
+bool ReceiveMessage(int file_descriptor, nlohmann::json& message);
+
+// Converts the given output (except its resource samples) to JSON.
+nlohmann::json ToJson(const TamarinOutput& tamarin_output);
+
+// Inverse of ToJson.
+TamarinOutput ToTamarinOutput(const nlohmann::json& json_output);
+
+} // namespace uttamarin
+
+#endif
@@ -22,17 +22,32 @@
 
 #include "app.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <iomanip>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <sstream>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "lemma_job.h"
 #include "lemma_processor.h"
 #include "output_writer.h"
+#include "tamarin_output_parser.h"
+#include "task_control.h"
 #include "theory_preprocessor.h"
+#include "tracing.h"
 #include "ut_tamarin_config.h"
 #include "utility.h"
+#include "worker_pool.h"
 
 using std::shared_ptr;
 using std::string;
@@ -42,14 +57,62 @@ using std::vector;
 
 namespace uttamarin {
 
+namespace {
+
+// Upper bound on the number of heuristics per round of RunHeuristicSearch
+const int kMaxHeuristicsPerRound = 64;
+
+// The probe rounds of RunHeuristicSearch give every heuristic this fraction
+// of the timeout (at least one second), or kProbeTimeout seconds if there is
+// no timeout
+const int kProbeTimeoutDivisor = 8;
+const int kProbeTimeout = 60;
+
+// Returns true if the heuristic is a repetition of a shorter heuristic (e.g.,
+// "CsCs"). Since Tamarin uses the goal rankings of a heuristic in a
+// round-robin fashion, such a heuristic behaves like the shorter one.
+bool IsPeriodic(const string& heuristic) {
+  for(size_t period = 1;period < heuristic.size();++period) {
+    if(heuristic.size() % period != 0) continue;
+    bool repeats = true;
+    for(size_t i = period;i < heuristic.size() && repeats;++i) {
+      repeats = heuristic[i] == heuristic[i - period];
+    }
+    if(repeats) return true;
+  }
+  return false;
+}
+
+// Lemmas that spend more than this fraction of their CPU time in the garbage
+// collector are reported as GC-bound
+const double kGcBoundFraction = 0.5;
+
+// Returns the given number of bytes as a string such as "12.3 MB" or "1.2 GB"
+string ToBytesString(long long bytes) {
+  std::ostringstream bytes_stream;
+  bytes_stream << std::fixed << std::setprecision(1);
+  double megabytes = bytes / (1024.0 * 1024.0);
+  if(megabytes < 1024) bytes_stream << megabytes << " MB";
+  else bytes_stream << megabytes / 1024 << " GB";
+  return bytes_stream.str();
+}
+
+string ToPercentString(double fraction) {
+  return std::to_string(static_cast<int>(fraction * 100 + 0.5)) + "%";
+}
+
+} // namespace
+
 App::App(unique_ptr<LemmaProcessor> lemma_processor,
          unique_ptr<TheoryPreprocessor> theory_preprocessor,
          shared_ptr<UtTamarinConfig> config,
-         shared_ptr<OutputWriter> output_writer) :
+         shared_ptr<OutputWriter> output_writer,
+         LemmaJobSubmitter submit_lemma_job) :
   lemma_processor_(std::move(lemma_processor)),
   theory_preprocessor_(std::move(theory_preprocessor)),
   config_(config),
-  output_writer_(output_writer) {
+  output_writer_(output_writer),
+  submit_lemma_job_(submit_lemma_job) {
 
 }
 
@@ -61,33 +124,273 @@ bool App::RunOnLemmas(const vector<LemmaJob>& lemma_jobs) {
   bool success = true;
   unordered_map<ProverResult, int> count_of;
   int overall_duration = 0;
+  int lemma_number = 0;
+  int cancelled_lemmas = 0;
+  std::set<string> warnings;
+  vector<std::pair<string, GcStatistics>> gc_statistics_of_lemmas;
 
-  for(int i=0;i < lemma_jobs.size();i++) {
-    auto lemma_job = lemma_jobs[i];
-    auto preprocessed_spthy_file =
-            theory_preprocessor_->PreprocessAndReturnPathToResultingFile(
-                    lemma_job.GetSpthyFilePath(), lemma_job.GetLemmaName());
-
-    lemma_job.SetSpthyFilePath(preprocessed_spthy_file);
-    auto output = lemma_processor_->ProcessLemma(lemma_job);
+  bool is_file_order = output_writer_->GetOutputOrder() == OutputOrder::File;
 
-    PrintLemmaResults(lemma_job, output, i+1, lemma_jobs.size());
+  ProcessLemmaJobs(lemma_jobs, [&](size_t job_index,
+                                   const LemmaJob& lemma_job,
+                                   const TamarinOutput& output) {
+    // Cancelled jobs (e.g., of a watched theory that changed) are only
+    // counted, since their results are about to be replaced
+    if(output.failure_reason == FailureReason::Cancelled) {
+      output_writer_->BeginBlock(job_index);
+      output_writer_->EndBlock();
+      ++cancelled_lemmas;
+      success = false;
+      return true;
+    }
+    // In file order, the results are numbered like in a sequential run
+    ++lemma_number;
+    output_writer_->BeginBlock(job_index);
+    PrintLemmaResults(lemma_job, output,
+                      is_file_order ? job_index + 1 : lemma_number,
+                      lemma_jobs.size());
+    output_writer_->EndBlock();
+    warnings.insert(output.warnings.begin(), output.warnings.end());
+    if(output.gc_statistics.bytes_allocated >= 0) {
+      gc_statistics_of_lemmas.emplace_back(lemma_job.GetLemmaName(),
+                                           output.gc_statistics);
+    }
 
     overall_duration += output.duration;
     count_of[output.result]++;
-    std::remove(preprocessed_spthy_file.c_str());
     if(output.result != ProverResult::True) {
       success = false;
-      if(config_->IsAbortAfterFailure()) break;
+      return !config_->IsAbortAfterFailure();
     }
-  }
+    return true;
+  });
 
+  output_writer_->FlushBlocks();
   PrintFooter(count_of[ProverResult::True], count_of[ProverResult::False],
-              count_of[ProverResult::Unknown], overall_duration);
+              count_of[ProverResult::Unknown], cancelled_lemmas,
+              overall_duration);
+  for(const auto& warning : warnings) {
+    output_writer_->WriteColorized(warning, TextColor::Yellow);
+    output_writer_->Endl();
+  }
+  if(!gc_statistics_of_lemmas.empty()) {
+    PrintGcSummary(gc_statistics_of_lemmas);
+  }
 
   return success;
 }
 
+string App::RunHeuristicSearch(const vector<LemmaJob>& lemma_jobs,
+                               int max_heuristic_length) {
+  PrintHeader();
+
+  // The jobs come in the order of the bandit (see
+  // PenetrationLemmaJobGenerator), best goal ranking first
+  string goal_rankings = "";
+  for(const auto& lemma_job : lemma_jobs) {
+    goal_rankings += lemma_job.GetHeuristic();
+  }
+  // Heuristics made of better goal rankings (on average) have a lower score
+  auto get_score = [&goal_rankings](const string& heuristic) {
+    double rank_sum = 0;
+    for(char goal_ranking : heuristic) {
+      rank_sum += goal_rankings.find(goal_ranking);
+    }
+    return rank_sum / std::max<size_t>(heuristic.size(), 1);
+  };
+  auto by_score = [&get_score](const LemmaJob& a, const LemmaJob& b) {
+    auto score_a = get_score(a.GetHeuristic());
+    auto score_b = get_score(b.GetHeuristic());
+    if(score_a != score_b) return score_a < score_b;
+    return a.GetHeuristic().size() < b.GetHeuristic().size();
+  };
+
+  int timeout = config_->GetTimeout();
+  int probe_timeout = timeout > 0 ? std::max(timeout / kProbeTimeoutDivisor, 1)
+                                  : kProbeTimeout;
+  bool has_final_round = timeout <= 0 || probe_timeout < timeout;
+
+  string best_heuristic = "";
+  double best_wall_time = std::numeric_limits<double>::max();
+  // Runs a round of the search with the given timeout (-1 for the timeout of
+  // the config) and returns the candidates that ran into it
+  auto run_round = [&](vector<LemmaJob> candidates, int round_timeout,
+                       size_t dropped_candidates) {
+    *output_writer_ << "\n" << candidates.size() << " heuristic(s) with ";
+    if(round_timeout < 0) *output_writer_ << "the full timeout";
+    else *output_writer_ << "a probe timeout of "
+                         << ToSecondsString(round_timeout);
+    if(dropped_candidates > 0) {
+      *output_writer_ << " (" << dropped_candidates
+                      << " with a worse score dropped)";
+    }
+    *output_writer_ << ":";
+    output_writer_->Endl();
+    for(auto& candidate : candidates) candidate.SetTimeout(round_timeout);
+
+    vector<LemmaJob> timed_out_candidates;
+    int lemma_number = 0;
+    ProcessLemmaJobs(candidates, [&](size_t /*job_index*/,
+                                     const LemmaJob& lemma_job,
+                                     const TamarinOutput& output) {
+      // Heuristics that were cancelled after the first definitive result
+      if(output.failure_reason == FailureReason::Cancelled) return false;
+      PrintLemmaResults(lemma_job, output, ++lemma_number, candidates.size());
+      if(output.result != ProverResult::Unknown) {
+        if(output.wall_time < best_wall_time) {
+          best_wall_time = output.wall_time;
+          best_heuristic = lemma_job.GetHeuristic();
+        }
+        return false;
+      }
+      if(output.failure_reason == FailureReason::Timeout) {
+        timed_out_candidates.emplace_back(lemma_job);
+      }
+      return true;
+    });
+    return timed_out_candidates;
+  };
+
+  // Probe rounds: every heuristic gets the probe timeout, and only those
+  // that ran into it are extended by one more goal ranking. Heuristics that
+  // fail for another reason (e.g., Tamarin crashed) are pruned, and of the
+  // extended heuristics only the kMaxHeuristicsPerRound with the best score
+  // go on.
+  auto candidates = lemma_jobs;
+  size_t dropped_candidates = 0;
+  vector<LemmaJob> finalists;
+  for(int length = 1;!candidates.empty();++length) {
+    auto timed_out_candidates = run_round(
+            candidates, has_final_round ? probe_timeout : -1,
+            dropped_candidates);
+    if(!best_heuristic.empty()) break;
+    finalists.insert(finalists.end(), timed_out_candidates.begin(),
+                     timed_out_candidates.end());
+    if(length >= max_heuristic_length) break;
+
+    vector<LemmaJob> extended_candidates;
+    for(const auto& candidate : timed_out_candidates) {
+      for(char goal_ranking : goal_rankings) {
+        auto heuristic = candidate.GetHeuristic() + goal_ranking;
+        if(IsPeriodic(heuristic)) continue;
+        extended_candidates.emplace_back(LemmaJob(candidate.GetSpthyFilePath(),
+                                                  candidate.GetLemmaName(),
+                                                  heuristic));
+      }
+    }
+    std::stable_sort(extended_candidates.begin(), extended_candidates.end(),
+                     by_score);
+    dropped_candidates = extended_candidates.size() -
+                         std::min<size_t>(extended_candidates.size(),
+                                          kMaxHeuristicsPerRound);
+    extended_candidates.erase(extended_candidates.end() - dropped_candidates,
+                              extended_candidates.end());
+    candidates = extended_candidates;
+  }
+
+  // Final round: the heuristics that survived the probes with the best score
+  // get the full timeout
+  if(best_heuristic.empty() && has_final_round && !finalists.empty()) {
+    std::stable_sort(finalists.begin(), finalists.end(), by_score);
+    dropped_candidates = finalists.size() -
+                         std::min<size_t>(finalists.size(),
+                                          kMaxHeuristicsPerRound);
+    finalists.erase(finalists.end() - dropped_candidates, finalists.end());
+    run_round(finalists, -1, dropped_candidates);
+  }
+
+  *output_writer_ << "\nBest heuristic: ";
+  if(best_heuristic.empty()) {
+    *output_writer_ << "none found";
+  } else {
+    std::ostringstream wall_time_stream;
+    wall_time_stream << std::fixed << std::setprecision(2) << best_wall_time;
+    *output_writer_ << best_heuristic << " (" << wall_time_stream.str()
+                    << " seconds)";
+  }
+  output_writer_->Endl();
+
+  return best_heuristic;
+}
+
+void App::ProcessLemmaJobs(
+        const vector<LemmaJob>& lemma_jobs,
+        const std::function<bool(size_t, const LemmaJob&,
+                                 const TamarinOutput&)>& handle_output) {
+  tracing::ScopedSpan span("process lemma jobs");
+  unique_ptr<WorkerPool> worker_pool;
+  auto submit_lemma_job = submit_lemma_job_;
+  if(!submit_lemma_job) {
+    worker_pool = std::make_unique<WorkerPool>(config_->GetJobs());
+    submit_lemma_job = [&worker_pool](const LemmaJob& /*lemma_job*/,
+                                      std::function<void()> task) {
+      worker_pool->Submit(std::move(task));
+    };
+  }
+  std::mutex mutex;
+  bool is_stopped = false;
+  // Of the jobs that run, which are cancelled once the jobs are stopped
+  std::set<TaskControl*> running_task_controls;
+  // A shared scheduler also runs the jobs of others, so the jobs are counted
+  // here instead of waiting for the workers to become idle
+  size_t unfinished_jobs = lemma_jobs.size();
+  std::condition_variable all_jobs_finished;
+
+  for(size_t job_index = 0;job_index < lemma_jobs.size();++job_index) {
+    submit_lemma_job(lemma_jobs[job_index], [&, job_index] {
+      // The jobs of a shared scheduler already have a control of their own
+      TaskControl own_task_control;
+      auto task_control = TaskControl::GetCurrent();
+      if(task_control == nullptr) {
+        task_control = &own_task_control;
+        TaskControl::SetCurrent(task_control);
+      }
+      bool is_skipped;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        is_skipped = is_stopped;
+        if(!is_skipped) running_task_controls.insert(task_control);
+      }
+      std::optional<TamarinOutput> output;
+      if(!is_skipped) output = ProcessLemmaJob(lemma_jobs[job_index]);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        running_task_controls.erase(task_control);
+        if(output.has_value() &&
+           !handle_output(job_index, lemma_jobs[job_index], output.value()) &&
+           !is_stopped) {
+          is_stopped = true;
+          for(auto running_task_control : running_task_controls) {
+            running_task_control->Cancel();
+          }
+        }
+        --unfinished_jobs;
+        all_jobs_finished.notify_all();
+      }
+      if(task_control == &own_task_control) TaskControl::SetCurrent(nullptr);
+    });
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  all_jobs_finished.wait(lock, [&] { return unfinished_jobs == 0; });
+}
+
+TamarinOutput App::ProcessLemmaJob(LemmaJob lemma_job) {
+  tracing::ScopedSpan span("lemma job", lemma_job.GetLemmaName());
+  output_writer_->ReportLemmaStarted(lemma_job);
+  auto spthy_file_path = lemma_job.GetSpthyFilePath();
+  auto preprocessed_spthy_file =
+          theory_preprocessor_->PreprocessAndReturnPathToResultingFile(
+                  spthy_file_path, lemma_job.GetLemmaName());
+
+  lemma_job.SetSpthyFilePath(preprocessed_spthy_file);
+  auto output = lemma_processor_->ProcessLemma(lemma_job);
+
+  std::remove(preprocessed_spthy_file.c_str());
+  lemma_job.SetSpthyFilePath(spthy_file_path);
+  output_writer_->ReportLemmaFinished(lemma_job, output);
+  return output;
+}
+
 void App::PrintHeader() {
   auto file_name = config_->GetSpthyFilePath();
   if(file_name.find('/') != string::npos) {
@@ -106,6 +409,7 @@ void App::PrintLemmaResults(const LemmaJob& lemma_job,
                             const TamarinOutput& tamarin_output,
                             int lemma_number,
                             int number_of_lemmas) {
+  tracing::ScopedSpan span("print result");
   *output_writer_ << lemma_job.GetLemmaName() << " ";
   if(tamarin_output.result == ProverResult::True) {
     output_writer_->WriteColorized("verified", TextColor::Green);
@@ -114,38 +418,84 @@ void App::PrintLemmaResults(const LemmaJob& lemma_job,
   } else {
     output_writer_->WriteColorized("unverified", TextColor::Yellow);
   }
-  *output_writer_ << " (" << ToSecondsString(tamarin_output.duration) << ")";
-  if(lemma_job.GetHeuristic() != TamarinHeuristic::None) {
-    *output_writer_ << " heuristic="
-                    << ToOutputString(lemma_job.GetHeuristic());
+  *output_writer_ << " (" << ToSecondsString(tamarin_output.duration);
+  if(tamarin_output.result != ProverResult::Unknown &&
+     tamarin_output.steps >= 0) {
+    *output_writer_ << ", " << tamarin_output.steps << " steps";
+  }
+  if(tamarin_output.failure_reason != FailureReason::None) {
+    *output_writer_ << ", " << ToString(tamarin_output.failure_reason);
+  }
+  if(tamarin_output.is_unchanged) *output_writer_ << ", unchanged";
+  *output_writer_ << ")";
+  if(!tamarin_output.heuristic.empty()) {
+    *output_writer_ << " heuristic=" << tamarin_output.heuristic;
   }
   *output_writer_ << " (" << lemma_number << "/" << number_of_lemmas << ")";
   output_writer_->Endl();
+  if(!tamarin_output.error.empty()) {
+    *output_writer_ << tamarin_output.error;
+    output_writer_->Endl();
+  }
 }
 
 void App::PrintFooter(int true_lemmas, int false_lemmas,
-                      int unknown_lemmas, int overall_duration) {
+                      int unknown_lemmas, int cancelled_lemmas,
+                      int overall_duration) {
   *output_writer_ << "\n"
     << "Summary: " << "\n"
     << "verified: " << true_lemmas
     << ", false: " << false_lemmas
-    << ", timeout: " << unknown_lemmas
-    << "\n"
+    << ", timeout: " << unknown_lemmas;
+  if(cancelled_lemmas > 0) {
+    *output_writer_ << ", cancelled: " << cancelled_lemmas;
+  }
+  *output_writer_ << "\n"
     << "Overall duration: " << ToSecondsString(overall_duration);
   output_writer_->Endl();
 }
 
-std::string App::ToOutputString(const TamarinHeuristic& heuristic) {
-  switch(heuristic){
-    case TamarinHeuristic::S: return "S";
-    case TamarinHeuristic::s: return "s";
-    case TamarinHeuristic::I: return "I";
-    case TamarinHeuristic::i: return "i";
-    case TamarinHeuristic::C: return "C";
-    case TamarinHeuristic::c: return "c";
-    case TamarinHeuristic::P: return "P";
-    case TamarinHeuristic::p: return "p";
-    default: return "unknown";
+void App::PrintGcSummary(
+        const vector<std::pair<string, GcStatistics>>&
+                gc_statistics_of_lemmas) {
+  long long bytes_allocated = 0;
+  long long max_residency = 0;
+  double gc_cpu_time = 0;
+  double mutator_cpu_time = 0;
+  vector<std::pair<string, GcStatistics>> gc_bound_lemmas;
+  for(const auto& [lemma_name, gc_statistics] : gc_statistics_of_lemmas) {
+    bytes_allocated += gc_statistics.bytes_allocated;
+    max_residency = std::max(max_residency, gc_statistics.max_residency);
+    gc_cpu_time += gc_statistics.gc_cpu_time;
+    mutator_cpu_time += gc_statistics.mutator_cpu_time;
+    if(gc_statistics.gc_time_fraction > kGcBoundFraction) {
+      gc_bound_lemmas.emplace_back(lemma_name, gc_statistics);
+    }
+  }
+  double cpu_time = gc_cpu_time + mutator_cpu_time;
+  *output_writer_ << "GC: " << ToBytesString(bytes_allocated) << " allocated"
+    << ", max. residency " << ToBytesString(max_residency) << ", "
+    << ToPercentString(cpu_time > 0 ? gc_cpu_time / cpu_time : 0)
+    << " of CPU time in GC (productivity "
+    << ToPercentString(cpu_time > 0 ? mutator_cpu_time / cpu_time : 0)
+    << ")";
+  output_writer_->Endl();
+
+  if(gc_bound_lemmas.empty()) return;
+  std::sort(gc_bound_lemmas.begin(), gc_bound_lemmas.end(),
+            [](const auto& a, const auto& b) {
+              return a.second.gc_time_fraction > b.second.gc_time_fraction;
+            });
+  output_writer_->WriteColorized("GC-bound lemmas (more than " +
+                                 ToPercentString(kGcBoundFraction) +
+                                 " of CPU time in GC):", TextColor::Yellow);
+  output_writer_->Endl();
+  for(const auto& [lemma_name, gc_statistics] : gc_bound_lemmas) {
+    *output_writer_ << "  " << lemma_name << ": "
+      << ToPercentString(gc_statistics.gc_time_fraction) << " in GC, "
+      << ToBytesString(gc_statistics.bytes_allocated) << " allocated, "
+      << "max. residency " << ToBytesString(gc_statistics.max_residency);
+    output_writer_->Endl();
   }
 }
 
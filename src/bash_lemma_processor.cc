@@ -22,97 +22,163 @@
 
 #include "bash_lemma_processor.h"
 
+#include <unistd.h>
+
 #include <algorithm>
 #include <fstream>
+#include <memory>
+#include <sstream>
 #include <string>
 
+#include "jobserver.h"
 #include "lemma_job.h"
+#include "resource_sampler.h"
+#include "tamarin_output_parser.h"
+#include "task_control.h"
+#include "tracing.h"
 #include "utility.h"
 
 using std::ifstream;
-using std::istream;
 using std::string;
 
 namespace uttamarin {
 
-const string kTempPath = "/tmp/uttamarintemp.ut";
+namespace {
+
+// Maximum number of characters of Tamarin's error output that are kept
+const size_t kMaxErrorLength = 512;
 
-BashLemmaProcessor::BashLemmaProcessor(const string& proof_directory,
-                                       const int timeout) :
-                                       proof_directory_(proof_directory),
-                                       timeout_(timeout) {
+} // namespace
+
+BashLemmaProcessor::BashLemmaProcessor(
+        const string& proof_directory,
+        const int timeout,
+        std::shared_ptr<ResourceSampler> sampler,
+        bool collect_gc_statistics,
+        std::shared_ptr<JobserverClient> jobserver) :
+  proof_directory_(proof_directory),
+  timeout_(timeout),
+  sampler_(sampler),
+  collect_gc_statistics_(collect_gc_statistics),
+  jobserver_(jobserver) {
 }
 
-BashLemmaProcessor::~BashLemmaProcessor() {
-  std::remove(kTempPath.c_str());
+BashLemmaProcessor::~BashLemmaProcessor() = default;
+
+string BashLemmaProcessor::GetTamarinVersion() {
+  auto version_output = ReadShellCommandOutput("tamarin-prover --version");
+  if(!version_output.has_value()) return "";
+  auto first_line = version_output->substr(0, version_output->find('\n'));
+  // Skip the copyright notice after the version
+  return Trim(first_line.substr(0, first_line.find(", (C)")));
 }
 
 TamarinOutput BashLemmaProcessor::DoProcessLemma(const LemmaJob& lemma_job) {
-  string cmd = "timeout " + std::to_string(timeout_) + " ";
+  int timeout = lemma_job.GetTimeout() >= 0 ? lemma_job.GetTimeout() : timeout_;
 
   string tamarin_args = "";
 
-  if(lemma_job.GetHeuristic() != TamarinHeuristic::None) {
-    tamarin_args += "--heuristic=" +
-                    GetTamarinHeuristicArgument(lemma_job.GetHeuristic());
+  if(!lemma_job.GetHeuristic().empty()) {
+    tamarin_args += ShellQuote("--heuristic=" + lemma_job.GetHeuristic());
   }
 
+  // Jobs of the same lemma with different heuristics (e.g., of penetration
+  // mode or a portfolio) may run at once, so Tamarin writes to a file of its
+  // own. A definitive result replaces the proof of the lemma, any other
+  // result only takes the place of a missing proof.
+  string partial_proof_path = "";
   if(!proof_directory_.empty()) {
-    tamarin_args += " --output=" + proof_directory_ + "/" +
-                    lemma_job.GetLemmaName() + ".spthy";
+    partial_proof_path = CreateTempFile(".spthy", proof_directory_);
+    tamarin_args += " " + ShellQuote("--output=" + partial_proof_path);
   }
 
-  cmd += "tamarin-prover --prove=" + lemma_job.GetLemmaName() + " "
-         + tamarin_args + " " + lemma_job.GetSpthyFilePath()
-         + " 1> " + kTempPath + " 2> /dev/null";
+  auto tamarin_output_path = CreateTempFile(".ut");
+  auto tamarin_error_path = CreateTempFile(".err");
+  string rts_statistics_path = "";
+  if(collect_gc_statistics_) {
+    rts_statistics_path = CreateTempFile(".rts");
+    tamarin_args += " +RTS " + ShellQuote("-t" + rts_statistics_path) +
+                    " --machine-readable -RTS";
+  }
+  // Tamarin replaces the shell, so that it dies with us (see RunShellCommand)
+  string cmd = "exec tamarin-prover " +
+               ShellQuote("--prove=" + lemma_job.GetLemmaName()) + " " +
+               tamarin_args + " " + ShellQuote(lemma_job.GetSpthyFilePath()) +
+               " 1> " + ShellQuote(tamarin_output_path) +
+               " 2> " + ShellQuote(tamarin_error_path);
+
+  ShellCommandResult command_result;
+  int pid = -1;
+  {
+    auto label = lemma_job.GetLemmaName() +
+                 (lemma_job.GetHeuristic().empty() ? "" :
+                  " --heuristic=" + lemma_job.GetHeuristic());
+    std::unique_ptr<JobSlot> job_slot;
+    if(jobserver_ != nullptr) {
+      tracing::ScopedSpan slot_span("jobserver slot", label);
+      job_slot = std::make_unique<JobSlot>(jobserver_);
+    }
+    tracing::ScopedSpan span("tamarin", label);
+    // The timeout counts running time only, so that lemma jobs that the
+    // scheduler of a JobServer suspends do not time out
+    command_result = RunShellCommand(cmd, [&](int started_pid) {
+      pid = started_pid;
+      if(sampler_) sampler_->Watch(pid, label);
+    }, timeout);
+  }
 
   TamarinOutput tamarin_output;
-  tamarin_output.duration = ExecuteShellCommand(cmd);
-
-  ifstream file_stream {kTempPath, ifstream::in};
-  tamarin_output.result =
-          ExtractResultForLemma(file_stream, lemma_job.GetLemmaName());
-
-  std::remove(kTempPath.c_str());
+  if(sampler_ && pid != -1) tamarin_output.samples = sampler_->Unwatch(pid);
+  tamarin_output.wall_time = command_result.duration;
+  tamarin_output.cpu_time = command_result.cpu_time;
+  tamarin_output.max_rss = command_result.max_rss;
+  tamarin_output.major_faults = command_result.major_faults;
+  tamarin_output.duration = static_cast<int>(command_result.duration);
+  tamarin_output.heuristic = lemma_job.GetHeuristic();
+
+  tracing::ScopedSpan parse_span("parse output");
+  std::istringstream summary_stream {
+          ReadSummarySection(tamarin_output_path).value_or("")};
+  bool has_summary = ParseTamarinOutput(summary_stream,
+                                        lemma_job.GetLemmaName(),
+                                        tamarin_output);
+
+  std::ostringstream error_stream;
+  error_stream << ifstream{tamarin_error_path, ifstream::in}.rdbuf();
+  auto error_output = Trim(error_stream.str());
+  tamarin_output.failure_reason = DetermineFailureReason(
+          tamarin_output.result, has_summary, command_result.exit_code,
+          error_output);
+  auto task_control = TaskControl::GetCurrent();
+  if(tamarin_output.result == ProverResult::Unknown &&
+     task_control != nullptr && task_control->IsCancelled()) {
+    tamarin_output.failure_reason = FailureReason::Cancelled;
+  }
+  if(tamarin_output.failure_reason == FailureReason::ParseError ||
+     tamarin_output.failure_reason == FailureReason::Crash) {
+    tamarin_output.error = error_output.substr(0, kMaxErrorLength);
+  }
 
-  return tamarin_output;
-}
+  if(!rts_statistics_path.empty()) {
+    ifstream rts_stream{rts_statistics_path};
+    ParseGcStatistics(rts_stream, tamarin_output.gc_statistics);
+    std::remove(rts_statistics_path.c_str());
+  }
 
-string BashLemmaProcessor::GetTamarinHeuristicArgument(
-        const TamarinHeuristic& heuristic) {
-  switch(heuristic){
-    case TamarinHeuristic::S: return "S";
-    case TamarinHeuristic::s: return "s";
-    case TamarinHeuristic::I: return "I";
-    case TamarinHeuristic::i: return "i";
-    case TamarinHeuristic::C: return "C";
-    case TamarinHeuristic::c: return "c";
-    case TamarinHeuristic::P: return "P";
-    case TamarinHeuristic::p: return "p";
-    case TamarinHeuristic::None: return "";
-    default: return "";
+  std::remove(tamarin_output_path.c_str());
+  std::remove(tamarin_error_path.c_str());
+  if(!partial_proof_path.empty()) {
+    auto proof_path = proof_directory_ + "/" + lemma_job.GetLemmaName() +
+                      ".spthy";
+    bool is_kept = tamarin_output.result != ProverResult::Unknown ||
+                   access(proof_path.c_str(), F_OK) != 0;
+    if(!is_kept ||
+       std::rename(partial_proof_path.c_str(), proof_path.c_str()) != 0) {
+      std::remove(partial_proof_path.c_str());
+    }
   }
-}
 
-ProverResult BashLemmaProcessor::ExtractResultForLemma(
-        istream& tamarin_stream,
-        const string& lemma_name) {
-  string line;
-
-  // Move stream to begin of lemma name section
-  while(std::getline(tamarin_stream, line) && 
-        (line.size() < 5 || line.substr(0,5) != "====="));
-
-  // Move to result line for the lemma with name equal to lemma_name
-  while(std::getline(tamarin_stream, line) && 
-        (line.find("steps)") == std::string::npos ||
-         line.find(lemma_name) == std::string::npos));
-
-  if(line.find("falsified") != string::npos)
-    return ProverResult::False;
-  else if(line.find("verified") != string::npos)
-    return ProverResult::True;
-  return ProverResult::Unknown;
+  return tamarin_output;
 }
 
 } // namespace uttamarin
@@ -0,0 +1,362 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "batch_lemma_processor.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lemma_job.h"
+#include "tamarin_output_parser.h"
+#include "task_control.h"
+#include "utility.h"
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace uttamarin {
+
+namespace {
+
+// Time that the first job of a batch waits for further jobs
+const std::chrono::milliseconds kBatchDelay(2000);
+
+// Maximum number of jobs per job array (Slurm's default MaxArraySize is
+// 1001)
+const size_t kMaxBatchSize = 1000;
+
+// Interval in which the shared directory is checked for results
+const std::chrono::milliseconds kPollInterval(1000);
+
+// Interval in which a waiting lemma job checks whether its task was cancelled
+const std::chrono::milliseconds kCancelCheckInterval(100);
+
+// Maximum number of characters of Tamarin's error output that are kept
+const size_t kMaxErrorLength = 512;
+
+// Time that the batch system may take beyond the timeout of a job to
+// terminate its task (e.g., Slurm's KillWait) and to write its status
+const std::chrono::seconds kStatusGracePeriod(60);
+
+string GetHostName() {
+  char host_name[256] = "";
+  gethostname(host_name, sizeof(host_name) - 1);
+  return host_name;
+}
+
+// The array tasks run in other working directories
+string GetAbsolutePath(const string& path) {
+  char* absolute_path = realpath(path.c_str(), nullptr);
+  if(absolute_path == nullptr) return path;
+  string result = absolute_path;
+  std::free(absolute_path);
+  return result;
+}
+
+string ReplaceAll(string text, const string& from, const string& to) {
+  for(auto position = text.find(from);position != string::npos;
+      position = text.find(from, position + to.size())) {
+    text.replace(position, from.size(), to);
+  }
+  return text;
+}
+
+TamarinOutput CreateFailedOutput(const string& heuristic,
+                                 FailureReason failure_reason,
+                                 const string& error) {
+  TamarinOutput tamarin_output;
+  tamarin_output.result = ProverResult::Unknown;
+  tamarin_output.duration = 0;
+  tamarin_output.heuristic = heuristic;
+  tamarin_output.failure_reason = failure_reason;
+  tamarin_output.error = error;
+  return tamarin_output;
+}
+
+// Reads the result that the array task of the given job wrote to the files
+// starting with the given path
+TamarinOutput ReadResult(const string& result_path,
+                         const LemmaJob& lemma_job) {
+  int exit_code = 1;
+  double start_time = 0;
+  double end_time = 0;
+  std::ifstream(result_path + ".status") >> exit_code >> start_time
+                                         >> end_time;
+
+  TamarinOutput tamarin_output;
+  tamarin_output.result = ProverResult::Unknown;
+  tamarin_output.wall_time = std::max(end_time - start_time, 0.0);
+  tamarin_output.duration = static_cast<int>(tamarin_output.wall_time);
+  tamarin_output.heuristic = lemma_job.GetHeuristic();
+  std::istringstream summary_stream {
+          ReadSummarySection(result_path + ".out").value_or("")};
+  bool has_summary = ParseTamarinOutput(summary_stream,
+                                        lemma_job.GetLemmaName(),
+                                        tamarin_output);
+  std::ostringstream error_stream;
+  error_stream << std::ifstream(result_path + ".err").rdbuf();
+  auto error_output = Trim(error_stream.str());
+  tamarin_output.failure_reason = DetermineFailureReason(
+          tamarin_output.result, has_summary, exit_code, error_output);
+  if(tamarin_output.failure_reason == FailureReason::ParseError ||
+     tamarin_output.failure_reason == FailureReason::Crash) {
+    tamarin_output.error = error_output.substr(0, kMaxErrorLength);
+  }
+  return tamarin_output;
+}
+
+} // namespace
+
+struct BatchLemmaProcessor::Job {
+  explicit Job(const LemmaJob& lemma_job) : lemma_job(lemma_job) {}
+
+  LemmaJob lemma_job;
+  string theory_path; // staged in the shared directory
+  int timeout = 0;
+  string result_path; // of the submitted job, without extension
+  // The job fails if its status has not appeared by then
+  std::chrono::steady_clock::time_point deadline;
+  bool is_finished = false;
+  TamarinOutput tamarin_output;
+};
+
+BatchLemmaProcessor::BatchLemmaProcessor(const string& shared_directory,
+                                         const string& submit_command,
+                                         int timeout,
+                                         int queue_grace_period) :
+  run_directory_(GetAbsolutePath(shared_directory) + "/uttamarin-" +
+                 GetHostName() + "-" + std::to_string(getpid())),
+  submit_command_(submit_command),
+  timeout_(timeout),
+  queue_grace_period_(queue_grace_period),
+  next_batch_(0),
+  is_stopping_(false) {
+  if(mkdir(run_directory_.c_str(), 0755) != 0 ||
+     mkdir((run_directory_ + "/theories").c_str(), 0755) != 0) {
+    std::cerr << "Error: cannot create the directory '" << run_directory_
+              << "'." << std::endl;
+  }
+  poller_ = std::thread(&BatchLemmaProcessor::PollResults, this);
+}
+
+BatchLemmaProcessor::~BatchLemmaProcessor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  stopping_.notify_all();
+  poller_.join();
+  std::error_code error;
+  std::filesystem::remove_all(run_directory_, error);
+}
+
+string BatchLemmaProcessor::StageTheory(const string& spthy_file_path) {
+  std::ostringstream theory_stream;
+  theory_stream << std::ifstream(spthy_file_path).rdbuf();
+  auto theory_hash = HashString(theory_stream.str());
+  auto theory_path = run_directory_ + "/theories/" + theory_hash + ".spthy";
+  std::lock_guard<std::mutex> lock(mutex_);
+  if(staged_theories_.insert(theory_hash).second) {
+    // Nodes must never see a partial theory
+    std::ofstream(theory_path + ".tmp") << theory_stream.str();
+    std::rename((theory_path + ".tmp").c_str(), theory_path.c_str());
+  }
+  return theory_path;
+}
+
+void BatchLemmaProcessor::SubmitBatch(const vector<shared_ptr<Job>>& jobs) {
+  string batch_directory;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch_directory = run_directory_ + "/batch-" +
+                      std::to_string(next_batch_++);
+  }
+  auto result_directory = batch_directory + "/results";
+  auto script_path = batch_directory + "/lemma_jobs.sh";
+  bool is_submitted =
+          mkdir(batch_directory.c_str(), 0755) == 0 &&
+          mkdir(result_directory.c_str(), 0755) == 0;
+  if(is_submitted) {
+    std::ofstream script(script_path);
+    script << "#!/bin/sh\n"
+           << "# Lemma jobs of UT Tamarin as a job array: array task i runs "
+           << "job i (0 to " << jobs.size() - 1 << ")\n"
+           << "# and writes results/i.out, results/i.err and, at the end, "
+           << "results/i.status.\n"
+           << "index=${UTTAMARIN_ARRAY_INDEX:-${SLURM_ARRAY_TASK_ID:-"
+           << "${PBS_ARRAY_INDEX:-$PBS_ARRAYID}}}\n"
+           << "results=" << ShellQuote(result_directory) << "\n"
+           << "case \"$index\" in\n";
+    for(size_t i = 0;i < jobs.size();++i) {
+      const auto& lemma_job = jobs[i]->lemma_job;
+      script << "  " << i << ") timeout=" << jobs[i]->timeout << "; set -- "
+             << ShellQuote("--prove=" + lemma_job.GetLemmaName()) << " ";
+      if(!lemma_job.GetHeuristic().empty()) {
+        script << ShellQuote("--heuristic=" + lemma_job.GetHeuristic())
+               << " ";
+      }
+      script << ShellQuote(jobs[i]->theory_path) << ";;\n";
+    }
+    script << "  *) echo \"Unknown array index '$index'.\" >&2; exit 1;;\n"
+           << "esac\n"
+           << "# The status is written even if the batch system terminates "
+           << "Tamarin\n"
+           << "trap true TERM\n"
+           << "start=$(date +%s.%N)\n"
+           << "if [ \"$timeout\" -gt 0 ]; then\n"
+           << "  timeout \"$timeout\" tamarin-prover \"$@\"\n"
+           << "else\n"
+           << "  tamarin-prover \"$@\"\n"
+           << "fi > \"$results/$index.out\" 2> \"$results/$index.err\"\n"
+           << "code=$?\n"
+           << "echo \"$code $start $(date +%s.%N)\" > "
+           << "\"$results/$index.status.tmp\"\n"
+           << "mv \"$results/$index.status.tmp\" \"$results/$index.status\"\n";
+    is_submitted = static_cast<bool>(script);
+  }
+  if(is_submitted) {
+    chmod(script_path.c_str(), 0755);
+    auto submit_command = ReplaceAll(
+            ReplaceAll(ReplaceAll(submit_command_, "{script}",
+                                  ShellQuote(script_path)),
+                       "{size}", std::to_string(jobs.size())),
+            "{last}", std::to_string(jobs.size() - 1));
+    is_submitted = RunShellCommand("cd " + ShellQuote(batch_directory) +
+                                   " && " + submit_command +
+                                   " > submit.log 2>&1").exit_code == 0;
+    if(!is_submitted) {
+      std::ostringstream log_stream;
+      log_stream << std::ifstream(batch_directory + "/submit.log").rdbuf();
+      auto log = Trim(log_stream.str());
+      std::cerr << "Error: the submit command '" << submit_command
+                << "' failed" << (log.empty() ? "." : ": " + log)
+                << std::endl;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for(size_t i = 0;i < jobs.size();++i) {
+    if(jobs[i]->is_finished) continue;
+    if(!is_submitted) {
+      jobs[i]->tamarin_output = CreateFailedOutput(
+              jobs[i]->lemma_job.GetHeuristic(), FailureReason::Crash,
+              "cannot submit the job array");
+      jobs[i]->is_finished = true;
+      continue;
+    }
+    jobs[i]->result_path = result_directory + "/" + std::to_string(i);
+    jobs[i]->deadline = std::chrono::steady_clock::now() +
+                        std::chrono::seconds(jobs[i]->timeout) +
+                        queue_grace_period_ + kStatusGracePeriod;
+    submitted_jobs_.emplace_back(jobs[i]);
+  }
+  job_finished_.notify_all();
+}
+
+void BatchLemmaProcessor::PollResults() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while(!is_stopping_) {
+    stopping_.wait_for(lock, kPollInterval);
+    // Jobs that were cancelled in the meantime are finished already
+    submitted_jobs_.erase(
+            std::remove_if(submitted_jobs_.begin(), submitted_jobs_.end(),
+                           [](const shared_ptr<Job>& job) {
+                             return job->is_finished;
+                           }),
+            submitted_jobs_.end());
+    auto jobs = submitted_jobs_;
+    lock.unlock();
+    vector<std::pair<shared_ptr<Job>, TamarinOutput>> results;
+    auto now = std::chrono::steady_clock::now();
+    for(const auto& job : jobs) {
+      if(access((job->result_path + ".status").c_str(), F_OK) == 0) {
+        results.emplace_back(job, ReadResult(job->result_path,
+                                             job->lemma_job));
+      } else if(now > job->deadline) {
+        results.emplace_back(job, CreateFailedOutput(
+                job->lemma_job.GetHeuristic(), FailureReason::Crash,
+                "the array task wrote no result within the timeout and the "
+                "queue grace period (see --batch_queue_grace)"));
+      }
+    }
+    lock.lock();
+    for(auto& [job, tamarin_output] : results) {
+      if(job->is_finished) continue;
+      job->tamarin_output = tamarin_output;
+      job->is_finished = true;
+    }
+    if(!results.empty()) job_finished_.notify_all();
+  }
+}
+
+TamarinOutput BatchLemmaProcessor::DoProcessLemma(const LemmaJob& lemma_job) {
+  auto job = std::make_shared<Job>(lemma_job);
+  job->theory_path = StageTheory(lemma_job.GetSpthyFilePath());
+  job->timeout = lemma_job.GetTimeout() >= 0 ? lemma_job.GetTimeout() :
+                                               timeout_;
+  auto task_control = TaskControl::GetCurrent();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  pending_jobs_.emplace_back(job);
+  if(pending_jobs_.size() == 1) {
+    // The first job of a batch submits it, once the other jobs that are
+    // ready to run joined it
+    batch_full_.wait_for(lock, kBatchDelay, [this] {
+      return pending_jobs_.size() >= kMaxBatchSize;
+    });
+    auto jobs = std::move(pending_jobs_);
+    pending_jobs_.clear();
+    lock.unlock();
+    SubmitBatch(jobs);
+    lock.lock();
+  } else if(pending_jobs_.size() >= kMaxBatchSize) {
+    batch_full_.notify_all();
+  }
+  while(!job->is_finished) {
+    job_finished_.wait_for(lock, kCancelCheckInterval);
+    // The array task keeps running, but its result is ignored
+    if(!job->is_finished && task_control != nullptr &&
+       task_control->IsCancelled()) {
+      job->tamarin_output = CreateFailedOutput(lemma_job.GetHeuristic(),
+                                               FailureReason::Cancelled, "");
+      job->is_finished = true;
+    }
+  }
+  return job->tamarin_output;
+}
+
+} // namespace uttamarin
@@ -0,0 +1,114 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "caching_lemma_processor.h"
+
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "lemma_job.h"
+#include "remote_result_cache.h"
+#include "result_cache.h"
+#include "theory_index.h"
+#include "utility.h"
+
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+
+namespace uttamarin {
+
+namespace {
+
+const string kCachedResultNote =
+        "Note: some results were taken from the result cache.";
+
+} // namespace
+
+CachingLemmaProcessor::CachingLemmaProcessor(
+        unique_ptr<LemmaProcessor> decoratee,
+        shared_ptr<ResultCache> result_cache,
+        const string& tamarin_version,
+        shared_ptr<RemoteResultCache> remote_result_cache,
+        const string& proof_directory) :
+  decoratee_(std::move(decoratee)),
+  result_cache_(result_cache),
+  tamarin_version_(tamarin_version),
+  remote_result_cache_(remote_result_cache),
+  proof_directory_(proof_directory) {
+}
+
+TamarinOutput CachingLemmaProcessor::DoProcessLemma(
+        const LemmaJob& lemma_job) {
+  auto key = GetCacheKey(lemma_job);
+  // The proof that BashLemmaProcessor writes for the lemma
+  auto proof_path = proof_directory_ + "/" + lemma_job.GetLemmaName() +
+                    ".spthy";
+  auto cached_output = result_cache_->Find(key);
+  if(!cached_output.has_value() && remote_result_cache_ != nullptr) {
+    cached_output = remote_result_cache_->Find(key);
+    if(cached_output.has_value() &&
+       cached_output->result == ProverResult::Unknown) {
+      cached_output.reset();
+    }
+    if(cached_output.has_value()) {
+      result_cache_->Insert(key, cached_output.value());
+      auto proof = proof_directory_.empty() ?
+                   std::nullopt : remote_result_cache_->FindProof(key);
+      if(proof.has_value()) std::ofstream(proof_path) << proof.value();
+    }
+  }
+  if(cached_output.has_value()) {
+    cached_output->warnings.emplace_back(kCachedResultNote);
+    return cached_output.value();
+  }
+
+  auto output = decoratee_->ProcessLemma(lemma_job);
+  if(output.result != ProverResult::Unknown) {
+    result_cache_->Insert(key, output);
+    if(remote_result_cache_ != nullptr) {
+      remote_result_cache_->Insert(key, output);
+      std::ifstream proof_stream(proof_path);
+      if(!proof_directory_.empty() && proof_stream) {
+        std::ostringstream proof;
+        proof << proof_stream.rdbuf();
+        remote_result_cache_->InsertProof(key, proof.str());
+      }
+    }
+  }
+  return output;
+}
+
+string CachingLemmaProcessor::GetCacheKey(const LemmaJob& lemma_job) const {
+  // Tamarin reads the included files only after the preprocessing. A hit
+  // counts as a proof, so the key of the shared cache must not collide.
+  auto theory_text = ReadTheoryText(lemma_job.GetSpthyFilePath());
+  return Sha256String(Sha256String(theory_text) + "\n" +
+                      lemma_job.GetLemmaName() + "\n" +
+                      lemma_job.GetHeuristic() + "\n" + tamarin_version_);
+}
+
+} // namespace uttamarin
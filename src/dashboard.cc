@@ -0,0 +1,262 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "dashboard.h"
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "lemma_history.h"
+#include "lemma_job.h"
+#include "lemma_processor.h"
+#include "resource_sampler.h"
+
+using std::string;
+using std::vector;
+
+namespace uttamarin {
+
+namespace {
+
+// Number of latest records of a lemma whose mean is its expected duration
+const size_t kRecordsPerEstimate = 5;
+
+// Width of the progress bar in characters
+const int kProgressBarWidth = 20;
+
+double GetCurrentTime() {
+  return std::chrono::duration<double>(
+          std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Takes a duration in seconds and converts it into a string of the form MM:SS
+// (or H:MM:SS for durations of an hour or more)
+string ToClockString(double duration) {
+  auto seconds = static_cast<long>(std::max(duration, 0.0));
+  std::ostringstream clock;
+  clock << std::setfill('0');
+  if(seconds >= 3600) clock << seconds / 3600 << ":";
+  clock << std::setw(2) << seconds / 60 % 60 << ":"
+        << std::setw(2) << seconds % 60;
+  return clock.str();
+}
+
+// Returns the number of columns of the terminal (or 80 if unknown)
+size_t GetTerminalWidth() {
+  struct winsize window_size;
+  if(ioctl(STDOUT_FILENO, TIOCGWINSZ, &window_size) == 0 &&
+     window_size.ws_col > 0) {
+    return window_size.ws_col;
+  }
+  return 80;
+}
+
+} // namespace
+
+Dashboard::Dashboard(int number_of_workers,
+                     std::shared_ptr<ResourceSampler> sampler,
+                     std::shared_ptr<LemmaHistory> history) :
+  number_of_workers_(number_of_workers),
+  sampler_(sampler),
+  history_(history),
+  verified_jobs_(0),
+  falsified_jobs_(0),
+  unverified_jobs_(0),
+  finished_duration_(0) {
+}
+
+void Dashboard::AddQueuedLemmas(const vector<string>& lemma_names) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for(const auto& lemma_name : lemma_names) {
+    ++queued_jobs_of_lemma_[lemma_name];
+    GetExpectedDuration(lemma_name);
+  }
+}
+
+void Dashboard::DoReportLemmaStarted(const LemmaJob& lemma_job, double time) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = queued_jobs_of_lemma_.find(lemma_job.GetLemmaName());
+  if(it != queued_jobs_of_lemma_.end() && --it->second == 0) {
+    queued_jobs_of_lemma_.erase(it);
+  }
+  running_jobs_.emplace_back(RunningJob{lemma_job.GetLemmaName(),
+                                        lemma_job.GetHeuristic(), time});
+}
+
+void Dashboard::DoReportLemmaFinished(const LemmaJob& lemma_job,
+                                      const TamarinOutput& tamarin_output,
+                                      double time) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = std::find_if(running_jobs_.begin(), running_jobs_.end(),
+                         [&lemma_job](const RunningJob& running_job) {
+                           return running_job.lemma_name ==
+                                  lemma_job.GetLemmaName() &&
+                                  running_job.heuristic ==
+                                  lemma_job.GetHeuristic();
+                         });
+  if(it != running_jobs_.end()) {
+    finished_duration_ += time - it->start_time;
+    running_jobs_.erase(it);
+  }
+  if(tamarin_output.result == ProverResult::True) ++verified_jobs_;
+  else if(tamarin_output.result == ProverResult::False) ++falsified_jobs_;
+  else ++unverified_jobs_;
+}
+
+double Dashboard::GetExpectedDuration(const string& lemma_name) {
+  auto it = expected_duration_of_lemma_.find(lemma_name);
+  if(it != expected_duration_of_lemma_.end()) return it->second;
+  double expected_duration = -1;
+  if(history_ != nullptr) {
+    auto records = history_->GetRecordsOfLemma(lemma_name);
+    auto first = records.size() > kRecordsPerEstimate ?
+                 records.end() - kRecordsPerEstimate : records.begin();
+    double total_duration = 0;
+    for(auto record = first; record != records.end(); ++record) {
+      total_duration += record->wall_time > 0 ? record->wall_time :
+                                                record->duration;
+    }
+    if(first != records.end()) {
+      expected_duration = total_duration / (records.end() - first);
+    }
+  }
+  expected_duration_of_lemma_[lemma_name] = expected_duration;
+  return expected_duration;
+}
+
+double Dashboard::EstimateRemainingTime(double now) {
+  int finished_jobs = verified_jobs_ + falsified_jobs_ + unverified_jobs_;
+  // Lemmas without history are expected to take as long as the others
+  double known_duration = 0;
+  int known_lemmas = 0;
+  for(const auto& [lemma_name, expected_duration] :
+      expected_duration_of_lemma_) {
+    if(expected_duration < 0) continue;
+    known_duration += expected_duration;
+    ++known_lemmas;
+  }
+  double default_duration = known_lemmas > 0 ?
+                            known_duration / known_lemmas :
+                            finished_jobs > 0 ?
+                            finished_duration_ / finished_jobs : -1;
+
+  double remaining_time = 0;
+  auto add_remaining_time = [&](const string& lemma_name, double elapsed) {
+    auto expected_duration = GetExpectedDuration(lemma_name);
+    if(expected_duration < 0) expected_duration = default_duration;
+    if(expected_duration < 0) return false;
+    remaining_time += std::max(expected_duration - elapsed, 0.0);
+    return true;
+  };
+  for(const auto& [lemma_name, queued_jobs] : queued_jobs_of_lemma_) {
+    for(int i = 0; i < queued_jobs; ++i) {
+      if(!add_remaining_time(lemma_name, 0)) return -1;
+    }
+  }
+  for(const auto& running_job : running_jobs_) {
+    if(!add_remaining_time(running_job.lemma_name,
+                           now - running_job.start_time)) return -1;
+  }
+  return remaining_time / number_of_workers_;
+}
+
+vector<string> Dashboard::GetStatusLines() {
+  vector<ResourceSampler::RunningProcess> running_processes;
+  if(sampler_ != nullptr) running_processes = sampler_->GetRunningProcesses();
+  auto now = GetCurrentTime();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  int queued_jobs = 0;
+  for(const auto& [lemma_name, jobs] : queued_jobs_of_lemma_) {
+    queued_jobs += jobs;
+  }
+  int finished_jobs = verified_jobs_ + falsified_jobs_ + unverified_jobs_;
+  int all_jobs = queued_jobs + running_jobs_.size() + finished_jobs;
+  int progress = all_jobs > 0 ?
+                 finished_jobs * kProgressBarWidth / all_jobs : 0;
+  auto remaining_time = EstimateRemainingTime(now);
+
+  if(all_jobs == 0) return {};
+
+  std::ostringstream summary;
+  summary << "[" << string(progress, '#')
+          << string(kProgressBarWidth - progress, '.') << "] "
+          << finished_jobs << "/" << all_jobs << " done, "
+          << running_jobs_.size() << " running, " << queued_jobs
+          << " queued, ETA "
+          << (remaining_time < 0 ? "unknown" : ToClockString(remaining_time))
+          << " (" << verified_jobs_ << " verified, " << falsified_jobs_
+          << " false, " << unverified_jobs_ << " unverified)";
+  vector<string> status_lines = {summary.str()};
+
+  for(const auto& running_job : running_jobs_) {
+    std::ostringstream job_line;
+    job_line << "  " << ToClockString(now - running_job.start_time) << " "
+             << running_job.lemma_name;
+    // Find the Tamarin process of the job (the heuristic of a portfolio job
+    // is only known from its process)
+    auto label = running_job.lemma_name;
+    if(!running_job.heuristic.empty()) {
+      label += " --heuristic=" + running_job.heuristic;
+    }
+    auto process = std::find_if(
+            running_processes.begin(), running_processes.end(),
+            [&](const ResourceSampler::RunningProcess& running_process) {
+              return running_process.label == label ||
+                     (running_job.heuristic.empty() &&
+                      running_process.label.rfind(label + " ", 0) == 0);
+            });
+    if(process != running_processes.end()) {
+      auto heuristic_start = process->label.find("--heuristic=");
+      if(heuristic_start != string::npos) {
+        job_line << " heuristic=" << process->label.substr(
+                heuristic_start + 12);
+      }
+      job_line << std::fixed << std::setprecision(1)
+               << "  CPU " << process->sample.cpu_utilization * 100 << "%"
+               << "  RSS " << process->sample.rss / 1024.0 << " MB";
+    } else if(!running_job.heuristic.empty()) {
+      job_line << " heuristic=" << running_job.heuristic;
+    }
+    status_lines.emplace_back(job_line.str());
+  }
+
+  // Longer lines would wrap and break the redrawing of the status
+  auto terminal_width = GetTerminalWidth();
+  for(auto& status_line : status_lines) {
+    if(status_line.size() >= terminal_width) {
+      status_line.resize(terminal_width - 1);
+    }
+  }
+  return status_lines;
+}
+
+} // namespace uttamarin
@@ -24,10 +24,14 @@
 
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include "heuristic_bandit.h"
+#include "lemma_history.h"
 #include "lemma_name_reader.h"
+#include "theory_index.h"
 #include "utility.h"
 
 using std::shared_ptr;
@@ -39,21 +43,57 @@ namespace uttamarin {
 DefaultLemmaJobGenerator::DefaultLemmaJobGenerator(
                              const string& spthy_file_path,
                              const string& starting_lemma,
-                             shared_ptr<UtTamarinConfig> config) :
+                             shared_ptr<UtTamarinConfig> config,
+                             shared_ptr<LemmaHistory> history,
+                             shared_ptr<const TheoryIndex> theory_index,
+                             std::optional<vector<string>> lemma_names) :
                               spthy_file_path_(spthy_file_path),
-                              config_(config) {
+                              starting_lemma_(starting_lemma),
+                              config_(config),
+                              history_(history),
+                              theory_index_(theory_index),
+                              lemma_names_(lemma_names) {
 }
 
 vector<LemmaJob> DefaultLemmaJobGenerator::DoGenerateLemmaJobs() {
+  auto theory_hash = theory_index_ != nullptr ?
+          theory_index_->GetTheoryHash() :
+          HashString(ReadTheoryText(spthy_file_path_));
+  std::unique_ptr<HeuristicBandit> bandit;
+  if(history_ != nullptr && theory_index_ != nullptr) {
+    bandit = std::make_unique<HeuristicBandit>(history_->GetRecords());
+  }
+
   vector<LemmaJob> lemma_jobs;
   for(auto lemma_name : GetNamesOfLemmasToVerify()) {
-    lemma_jobs.emplace_back(LemmaJob(spthy_file_path_, lemma_name));
+    lemma_jobs.emplace_back(LemmaJob(spthy_file_path_, lemma_name,
+                                     GetHeuristicForLemma(lemma_name,
+                                                          theory_hash,
+                                                          bandit.get())));
   }
   return lemma_jobs;
 }
 
+string DefaultLemmaJobGenerator::GetHeuristicForLemma(
+                                            const string& lemma_name,
+                                            const string& theory_hash,
+                                            const HeuristicBandit* bandit) {
+  // A heuristic of the config is pinned by the user
+  auto configured_heuristic = config_->GetLemmaHeuristic(lemma_name);
+  if(!configured_heuristic.empty()) return configured_heuristic;
+  if(history_ != nullptr) {
+    auto fastest_heuristic = history_->GetFastestHeuristic(lemma_name,
+                                                           theory_hash);
+    if(fastest_heuristic.has_value()) return fastest_heuristic.value();
+  }
+  if(bandit == nullptr) return "";
+  return bandit->GetBestHeuristic(theory_index_->GetLemmaFeatures(lemma_name))
+                .value_or("");
+}
+
 vector<string> DefaultLemmaJobGenerator::GetNamesOfLemmasToVerify() {
-  auto lemmas = ReadLemmaNamesFromSpthyFile(spthy_file_path_);
+  auto lemmas = lemma_names_.has_value() ?
+          lemma_names_.value() : ReadLemmaNamesFromSpthyFile(spthy_file_path_);
   if(!config_->GetLemmaAllowList().empty()) {
     lemmas = GetLemmasInAllowList(lemmas, config_->GetLemmaAllowList());
   }
@@ -0,0 +1,245 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "fact_annotation_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lemma_job.h"
+#include "m4_theory_preprocessor.h"
+#include "output_writer.h"
+#include "theory_index.h"
+#include "utility.h"
+#include "worker_pool.h"
+
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace uttamarin {
+
+namespace {
+
+// Candidates may take this many seconds longer than the best assignment so
+// far, so that the noise of the wall time does not stop them just before
+// they would finish
+constexpr int kTimeoutMargin = 1;
+
+bool Contains(const vector<string>& facts, const string& fact) {
+  return std::find(facts.begin(), facts.end(), fact) != facts.end();
+}
+
+// Returns true if 'output' is a definitive result that is faster than 'best'
+// (by wall time, since most runs take less than a second)
+bool IsBetter(const TamarinOutput& output, const TamarinOutput& best) {
+  return output.result != ProverResult::Unknown &&
+         (best.result == ProverResult::Unknown ||
+          output.wall_time < best.wall_time);
+}
+
+string ToWallTimeString(double wall_time) {
+  std::ostringstream wall_time_stream;
+  wall_time_stream << std::fixed << std::setprecision(2) << wall_time << "s";
+  return wall_time_stream.str();
+}
+
+} // namespace
+
+FactAnnotationOptimizer::FactAnnotationOptimizer(
+        unique_ptr<LemmaProcessor> lemma_processor,
+        shared_ptr<UtTamarinConfig> config,
+        shared_ptr<const TheoryIndex> theory_index,
+        shared_ptr<OutputWriter> output_writer) :
+  lemma_processor_(std::move(lemma_processor)),
+  config_(config),
+  theory_index_(theory_index),
+  output_writer_(output_writer) {
+}
+
+FactAnnotations FactAnnotationOptimizer::Optimize(const LemmaJob& lemma_job,
+                                                  int time_budget) {
+  auto start_time = std::chrono::steady_clock::now();
+  // Returns the given timeout, cut to the rest of the time budget (at least
+  // one second), or 0 if the budget is used up
+  auto get_budget_timeout = [&](int timeout) {
+    std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start_time;
+    double remaining_time = time_budget - elapsed.count();
+    if(remaining_time <= 0) return 0;
+    return std::min(timeout, static_cast<int>(std::ceil(remaining_time)));
+  };
+
+  *output_writer_ << "Optimizing fact annotations for lemma '"
+                  << lemma_job.GetLemmaName() << "' (time budget: "
+                  << ToSecondsString(time_budget) << ")\n";
+  output_writer_->Endl();
+
+  auto best_assignment = GetInitialAssignment(lemma_job.GetLemmaName());
+  auto best_output = Evaluate(lemma_job, best_assignment,
+                              get_budget_timeout(config_->GetTimeout()));
+  PrintEvaluation(lemma_job, best_assignment, best_output);
+
+  bool has_improved = true;
+  while(has_improved && get_budget_timeout(1) > 0) {
+    has_improved = false;
+
+    vector<Assignment> neighbors;
+    for(const auto& [fact, annotation] : best_assignment) {
+      for(auto other_annotation : {Annotation::Neutral, Annotation::Important,
+                                   Annotation::Unimportant}) {
+        if(other_annotation == annotation) continue;
+        auto neighbor = best_assignment;
+        neighbor[fact] = other_annotation;
+        neighbors.emplace_back(neighbor);
+      }
+    }
+
+    int timeout = config_->GetTimeout();
+    if(best_output.result != ProverResult::Unknown) {
+      timeout = std::min(timeout,
+                         static_cast<int>(std::ceil(best_output.wall_time)) +
+                         kTimeoutMargin);
+    }
+    auto round_best_assignment = best_assignment;
+    auto round_best_output = best_output;
+    std::mutex mutex;
+    WorkerPool worker_pool(config_->GetJobs());
+    for(const auto& neighbor : neighbors) {
+      worker_pool.Submit([&, neighbor] {
+        auto budget_timeout = get_budget_timeout(timeout);
+        if(budget_timeout == 0) return;
+        auto output = Evaluate(lemma_job, neighbor, budget_timeout);
+        std::lock_guard<std::mutex> lock(mutex);
+        PrintEvaluation(lemma_job, neighbor, output);
+        if(IsBetter(output, round_best_output)) {
+          round_best_output = output;
+          round_best_assignment = neighbor;
+          has_improved = true;
+        }
+      });
+    }
+    worker_pool.Wait();
+    best_assignment = round_best_assignment;
+    best_output = round_best_output;
+  }
+
+  auto best_annotations = ToFactAnnotations(best_assignment);
+  *output_writer_ << "\nFastest annotations";
+  if(best_output.result != ProverResult::Unknown) {
+    *output_writer_ << " (" << ToWallTimeString(best_output.wall_time) << ")";
+  }
+  *output_writer_ << ":\n" << UtTamarinConfig::ToJsonLemmaAnnotation(
+                                  lemma_job.GetLemmaName(),
+                                  best_annotations).dump(1, '\t');
+  output_writer_->Endl();
+
+  return best_annotations;
+}
+
+FactAnnotationOptimizer::Assignment
+FactAnnotationOptimizer::GetInitialAssignment(const string& lemma_name) {
+  const auto& global_annotations = config_->GetGlobalAnnotations();
+  auto local_annotations = config_->GetLocalAnnotations(lemma_name);
+  Assignment assignment;
+  for(const auto& fact : theory_index_->GetFactSymbols()) {
+    const auto& annotations =
+      config_->FactIsAnnotatedLocally(fact, lemma_name) ? local_annotations
+                                                        : global_annotations;
+    if(Contains(annotations.important_facts, fact)) {
+      assignment[fact] = Annotation::Important;
+    } else if(Contains(annotations.unimportant_facts, fact)) {
+      assignment[fact] = Annotation::Unimportant;
+    } else {
+      assignment[fact] = Annotation::Neutral;
+    }
+  }
+  return assignment;
+}
+
+TamarinOutput FactAnnotationOptimizer::Evaluate(const LemmaJob& lemma_job,
+                                                const Assignment& assignment,
+                                                int timeout) {
+  auto candidate_config = std::make_shared<UtTamarinConfig>(*config_);
+  candidate_config->SetLocalAnnotations(lemma_job.GetLemmaName(),
+                                        ToFactAnnotations(assignment));
+  M4TheoryPreprocessor theory_preprocessor(candidate_config);
+  auto preprocessed_spthy_file =
+          theory_preprocessor.PreprocessAndReturnPathToResultingFile(
+                  lemma_job.GetSpthyFilePath(), lemma_job.GetLemmaName());
+
+  auto candidate_job = lemma_job;
+  candidate_job.SetSpthyFilePath(preprocessed_spthy_file);
+  candidate_job.SetTimeout(timeout);
+  auto output = lemma_processor_->ProcessLemma(candidate_job);
+
+  std::remove(preprocessed_spthy_file.c_str());
+  return output;
+}
+
+FactAnnotations FactAnnotationOptimizer::ToFactAnnotations(
+        const Assignment& assignment) {
+  const auto& global_annotations = config_->GetGlobalAnnotations();
+  FactAnnotations annotations;
+  for(const auto& [fact, annotation] : assignment) {
+    if(annotation == Annotation::Important) {
+      annotations.important_facts.emplace_back(fact);
+    } else if(annotation == Annotation::Unimportant) {
+      annotations.unimportant_facts.emplace_back(fact);
+    } else if(Contains(global_annotations.important_facts, fact) ||
+              Contains(global_annotations.unimportant_facts, fact)) {
+      annotations.neutral_facts.emplace_back(fact);
+    }
+  }
+  return annotations;
+}
+
+void FactAnnotationOptimizer::PrintEvaluation(const LemmaJob& lemma_job,
+                                              const Assignment& assignment,
+                                              const TamarinOutput& output) {
+  *output_writer_ << lemma_job.GetLemmaName() << " ";
+  if(output.result == ProverResult::True) {
+    output_writer_->WriteColorized("verified", TextColor::Green);
+  } else if(output.result == ProverResult::False) {
+    output_writer_->WriteColorized("false", TextColor::Red);
+  } else {
+    output_writer_->WriteColorized("unverified", TextColor::Yellow);
+  }
+  *output_writer_ << " (" << ToWallTimeString(output.wall_time) << ")";
+  for(const auto& [fact, annotation] : assignment) {
+    if(annotation == Annotation::Important) *output_writer_ << " F_" << fact;
+    if(annotation == Annotation::Unimportant) *output_writer_ << " L_" << fact;
+  }
+  output_writer_->Endl();
+}
+
+} // namespace uttamarin
@@ -0,0 +1,343 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "fair_share_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "nlohmann/json.hpp"
+
+#include "jobserver.h"
+#include "tracing.h"
+
+using std::string;
+using json = nlohmann::json;
+using steady_clock = std::chrono::steady_clock;
+
+namespace uttamarin {
+
+namespace {
+
+const JobPriority kPrioritiesInOrder[] = {JobPriority::Interactive,
+                                          JobPriority::Batch};
+
+TenantQuota ToTenantQuota(const json& json_quota,
+                          const TenantQuota& default_quota) {
+  TenantQuota quota = default_quota;
+  if(!json_quota.is_object()) return quota;
+  quota.weight = std::max(json_quota.value("weight", quota.weight), 0.001);
+  quota.max_cores = json_quota.value("max_cores", quota.max_cores);
+  quota.may_run_interactive = json_quota.value("interactive",
+                                               quota.may_run_interactive);
+  if(json_quota.contains("max_memory")) {
+    quota.max_memory = json_quota.value("max_memory", 0L) * 1024;
+  }
+  return quota;
+}
+
+} // namespace
+
+string ToString(JobPriority priority) {
+  return priority == JobPriority::Interactive ? "interactive" : "batch";
+}
+
+std::optional<JobPriority> ToJobPriority(const string& name) {
+  for(auto priority : kPrioritiesInOrder) {
+    if(ToString(priority) == name) return priority;
+  }
+  return std::nullopt;
+}
+
+FairShareScheduler::FairShareScheduler(int number_of_workers,
+                                       const string& quotas_file_path,
+                                       std::shared_ptr<JobserverClient>
+                                               jobserver) :
+  number_of_workers_(std::max(number_of_workers, 1)),
+  jobserver_(jobserver),
+  spare_slots_(0),
+  busy_workers_(0),
+  unfinished_tasks_(0) {
+  if(quotas_file_path != "") ReadQuotas(quotas_file_path);
+}
+
+FairShareScheduler::~FairShareScheduler() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  all_tasks_finished_.wait(lock, [this] { return unfinished_tasks_ == 0; });
+}
+
+void FairShareScheduler::Submit(const string& tenant_name,
+                                JobPriority priority, long memory,
+                                std::function<void()> task) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto is_new_tenant = tenants_.count(tenant_name) == 0;
+  auto& tenant = tenants_[tenant_name];
+  if(is_new_tenant) {
+    tenant.quota = quota_of_.count(tenant_name) > 0 ?
+            quota_of_.at(tenant_name) : default_quota_;
+  }
+  if(!IsActive(tenant)) {
+    // Catch up with the active tenant that used the least worker time
+    auto now = steady_clock::now();
+    auto min_usage = std::numeric_limits<double>::max();
+    for(const auto& [other_name, other_tenant] : tenants_) {
+      if(other_name == tenant_name || !IsActive(other_tenant)) continue;
+      min_usage = std::min(min_usage, GetWeightedUsage(other_name, now));
+    }
+    if(min_usage != std::numeric_limits<double>::max()) {
+      tenant.used_time = std::max(tenant.used_time,
+                                  min_usage * tenant.quota.weight);
+    }
+  }
+  if(!tenant.quota.may_run_interactive) priority = JobPriority::Batch;
+  tenant.queue_of[priority].emplace_back(
+          Task{priority, memory, std::move(task)});
+  ++unfinished_tasks_;
+  Schedule();
+}
+
+int FairShareScheduler::GetNumberOfWorkers() const {
+  return number_of_workers_;
+}
+
+void FairShareScheduler::Schedule() {
+  string tenant_name;
+  Task task;
+  // Interactive tasks take free workers first, then those of batch tasks
+  while(true) {
+    RunningTask* task_to_suspend = nullptr;
+    if(busy_workers_ >= number_of_workers_) {
+      task_to_suspend = FindTaskToSuspend();
+      if(task_to_suspend == nullptr) break;
+    }
+    if(!PopNextTask(JobPriority::Interactive, tenant_name, task)) break;
+    if(task_to_suspend != nullptr) {
+      task_to_suspend->control.Suspend();
+      --busy_workers_;
+      if(task_to_suspend->has_slot) {
+        task_to_suspend->has_slot = false;
+        ++spare_slots_;
+      }
+    }
+    Start(tenant_name, std::move(task));
+  }
+
+  // Suspended tasks continue before new batch tasks start. They must not
+  // wait for a slot with the mutex locked, so they only continue with the
+  // slot of a finished task.
+  for(auto& running_task : running_tasks_) {
+    if(busy_workers_ >= number_of_workers_ ||
+       (jobserver_ != nullptr && spare_slots_ == 0)) {
+      break;
+    }
+    if(running_task.control.IsSuspended()) {
+      if(jobserver_ != nullptr) {
+        running_task.has_slot = true;
+        --spare_slots_;
+      }
+      running_task.control.Resume();
+      ++busy_workers_;
+    }
+  }
+
+  while(busy_workers_ < number_of_workers_ &&
+        PopNextTask(JobPriority::Batch, tenant_name, task)) {
+    Start(tenant_name, std::move(task));
+  }
+  ReleaseSpareSlots();
+}
+
+void FairShareScheduler::Start(const string& tenant_name, Task task) {
+  auto& tenant = tenants_[tenant_name];
+  ++tenant.running_tasks;
+  tenant.reserved_memory += task.memory;
+  ++busy_workers_;
+  running_tasks_.emplace_back();
+  auto& running_task = running_tasks_.back();
+  running_task.tenant = tenant_name;
+  running_task.priority = task.priority;
+  running_task.memory = task.memory;
+  running_task.start_time = steady_clock::now();
+  if(jobserver_ != nullptr && spare_slots_ > 0) {
+    running_task.has_slot = true;
+    --spare_slots_;
+  }
+  std::thread(&FairShareScheduler::Run, this, &running_task,
+              std::move(task.run)).detach();
+}
+
+void FairShareScheduler::Run(RunningTask* running_task,
+                             std::function<void()> run) {
+  AcquireSlot(running_task);
+  TaskControl::SetCurrent(&running_task->control);
+  run();
+  TaskControl::SetCurrent(nullptr);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if(running_task->has_slot) ++spare_slots_;
+  auto& tenant = tenants_[running_task->tenant];
+  --tenant.running_tasks;
+  tenant.reserved_memory -= running_task->memory;
+  tenant.used_time += GetUsedTime(*running_task, steady_clock::now());
+  // A task whose processes are stopped may still finish (e.g., if it was
+  // suspended right when Tamarin exited)
+  if(!running_task->control.IsSuspended()) --busy_workers_;
+  running_tasks_.remove_if([running_task](const RunningTask& other) {
+    return &other == running_task;
+  });
+  --unfinished_tasks_;
+  Schedule();
+  all_tasks_finished_.notify_all();
+}
+
+void FairShareScheduler::AcquireSlot(RunningTask* running_task) {
+  std::shared_ptr<JobserverClient> jobserver;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(jobserver_ == nullptr || running_task->has_slot) return;
+    jobserver = jobserver_;
+  }
+  tracing::ScopedSpan slot_span("jobserver slot");
+  bool is_acquired = jobserver->AcquireSlot();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if(!is_acquired) {
+    // Without the jobserver, only the number of workers limits the tasks
+    jobserver_ = nullptr;
+  } else if(running_task->has_slot || running_task->control.IsSuspended()) {
+    // The task was suspended or resumed with another slot while it waited.
+    // Its processes are stopped as soon as they start.
+    jobserver->ReleaseSlot();
+  } else {
+    running_task->has_slot = true;
+  }
+}
+
+void FairShareScheduler::ReleaseSpareSlots() {
+  if(jobserver_ == nullptr) spare_slots_ = 0;
+  for(;spare_slots_ > 0;--spare_slots_) jobserver_->ReleaseSlot();
+}
+
+bool FairShareScheduler::PopNextTask(JobPriority priority,
+                                     string& tenant_name, Task& task) {
+  auto now = steady_clock::now();
+  Tenant* next_tenant = nullptr;
+  double min_usage = 0;
+  for(auto& [name, tenant] : tenants_) {
+    auto& queue = tenant.queue_of[priority];
+    if(queue.empty() || !MayStart(tenant, queue.front())) continue;
+    auto usage = GetWeightedUsage(name, now);
+    if(next_tenant == nullptr || usage < min_usage) {
+      next_tenant = &tenant;
+      tenant_name = name;
+      min_usage = usage;
+    }
+  }
+  if(next_tenant == nullptr) return false;
+  auto& queue = next_tenant->queue_of[priority];
+  task = std::move(queue.front());
+  queue.pop_front();
+  return true;
+}
+
+FairShareScheduler::RunningTask* FairShareScheduler::FindTaskToSuspend() {
+  auto now = steady_clock::now();
+  RunningTask* task_to_suspend = nullptr;
+  double max_usage = 0;
+  for(auto& running_task : running_tasks_) {
+    if(running_task.priority != JobPriority::Batch ||
+       running_task.control.IsSuspended()) {
+      continue;
+    }
+    auto usage = GetWeightedUsage(running_task.tenant, now);
+    // On a tie, the task that started last has the least work to lose
+    if(task_to_suspend == nullptr || usage >= max_usage) {
+      task_to_suspend = &running_task;
+      max_usage = usage;
+    }
+  }
+  return task_to_suspend;
+}
+
+double FairShareScheduler::GetWeightedUsage(const string& tenant_name,
+                                            steady_clock::time_point now)
+                                            const {
+  const auto& tenant = tenants_.at(tenant_name);
+  auto used_time = tenant.used_time;
+  for(const auto& running_task : running_tasks_) {
+    if(running_task.tenant == tenant_name) {
+      used_time += GetUsedTime(running_task, now);
+    }
+  }
+  return used_time / tenant.quota.weight;
+}
+
+double FairShareScheduler::GetUsedTime(const RunningTask& running_task,
+                                       steady_clock::time_point now) const {
+  return std::chrono::duration<double>(now - running_task.start_time).count() -
+         running_task.control.GetSuspendedTime();
+}
+
+bool FairShareScheduler::MayStart(const Tenant& tenant,
+                                  const Task& task) const {
+  if(tenant.running_tasks == 0) return true;
+  if(tenant.quota.max_cores > 0 &&
+     tenant.running_tasks >= tenant.quota.max_cores) {
+    return false;
+  }
+  return tenant.quota.max_memory <= 0 ||
+         tenant.reserved_memory + task.memory <= tenant.quota.max_memory;
+}
+
+bool FairShareScheduler::IsActive(const Tenant& tenant) const {
+  if(tenant.running_tasks > 0) return true;
+  for(const auto& [priority, queue] : tenant.queue_of) {
+    if(!queue.empty()) return true;
+  }
+  return false;
+}
+
+void FairShareScheduler::ReadQuotas(const string& quotas_file_path) {
+  std::ifstream quotas_file(quotas_file_path);
+  auto json_quotas = json::parse(quotas_file, nullptr, false);
+  if(!json_quotas.is_object()) {
+    std::cerr << "Warning: cannot read the tenant quotas in '"
+              << quotas_file_path << "'." << std::endl;
+    return;
+  }
+  default_quota_ = ToTenantQuota(json_quotas.value("default", json::object()),
+                                 TenantQuota());
+  auto json_tenants = json_quotas.value("tenants", json::object());
+  for(const auto& [tenant_name, json_quota] : json_tenants.items()) {
+    quota_of_[tenant_name] = ToTenantQuota(json_quota, default_quota_);
+  }
+}
+
+} // namespace uttamarin
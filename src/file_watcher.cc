@@ -0,0 +1,115 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "file_watcher.h"
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace uttamarin {
+
+namespace {
+
+const uint32_t kWatchedEvents = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE |
+                                IN_MODIFY;
+
+// Size of the buffer for inotify events, which holds many events with names
+// of up to NAME_MAX characters
+const size_t kEventBufferSize = 64 * 1024;
+
+} // namespace
+
+FileWatcher::FileWatcher() :
+  inotify_descriptor_(inotify_init1(IN_CLOEXEC)) {
+}
+
+FileWatcher::~FileWatcher() {
+  if(inotify_descriptor_ >= 0) close(inotify_descriptor_);
+}
+
+bool FileWatcher::SetFiles(const vector<string>& file_paths) {
+  if(inotify_descriptor_ < 0) return false;
+  for(const auto& [directory, watch] : watch_of_directory_) {
+    inotify_rm_watch(inotify_descriptor_, watch);
+  }
+  watch_of_directory_.clear();
+  file_path_of_.clear();
+  for(const auto& file_path : file_paths) {
+    auto separator = file_path.find_last_of('/');
+    auto directory = separator == string::npos ? string{"."} :
+                     separator == 0 ? string{"/"} :
+                     file_path.substr(0, separator);
+    auto file_name = separator == string::npos ? file_path :
+                     file_path.substr(separator + 1);
+    if(watch_of_directory_.count(directory) == 0) {
+      int watch = inotify_add_watch(inotify_descriptor_, directory.c_str(),
+                                    kWatchedEvents);
+      if(watch < 0) return false;
+      watch_of_directory_[directory] = watch;
+    }
+    file_path_of_[{watch_of_directory_[directory], file_name}] = file_path;
+  }
+  return true;
+}
+
+vector<string> FileWatcher::WaitForChanges(int debounce_time) {
+  vector<string> changed_files;
+  if(inotify_descriptor_ < 0) return changed_files;
+  pollfd poll_descriptor{inotify_descriptor_, POLLIN, 0};
+  while(true) {
+    int timeout = changed_files.empty() ? -1 : debounce_time;
+    int ready = poll(&poll_descriptor, 1, timeout);
+    if(ready < 0 && errno == EINTR) continue;
+    if(ready <= 0) break;
+    ReadEvents(changed_files);
+  }
+  return changed_files;
+}
+
+void FileWatcher::ReadEvents(vector<string>& changed_files) {
+  alignas(inotify_event) char buffer[kEventBufferSize];
+  auto length = read(inotify_descriptor_, buffer, sizeof(buffer));
+  for(ssize_t offset = 0;offset < length;) {
+    auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+    offset += sizeof(inotify_event) + event->len;
+    if(event->len == 0) continue;
+    auto it = file_path_of_.find({event->wd, string{event->name}});
+    if(it == file_path_of_.end()) continue;
+    if(std::find(changed_files.begin(), changed_files.end(), it->second) ==
+       changed_files.end()) {
+      changed_files.emplace_back(it->second);
+    }
+  }
+}
+
+} // namespace uttamarin
@@ -0,0 +1,248 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "heuristic_bandit.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "output_writer.h"
+#include "penetration_lemma_job_generator.h"
+#include "utility.h"
+
+using std::map;
+using std::pair;
+using std::set;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+namespace uttamarin {
+
+namespace {
+
+// Durations (in seconds) at which a definitive result earns half the reward
+const double kRewardTimeScale = 60.0;
+
+// Weight of evidence that an arm needs before GetBestHeuristic trusts it
+const double kMinimumEvidence = 1.0;
+
+// Every arm starts with a pseudo-observation of this reward and weight: the
+// reward of a result after kRewardTimeScale, so that untried heuristics rank
+// below faster proven ones but above slower and failing ones
+const double kPriorReward = 0.5;
+const double kPriorWeight = 1.0;
+
+// Scales the exploration bonus of the upper confidence bound. It is small
+// because trying a bad heuristic first costs a whole timeout.
+const double kExplorationFactor = 0.25;
+
+// Tamarin uses the heuristic 's' if no heuristic is given
+string EffectiveHeuristic(const string& heuristic) {
+  return heuristic.empty() ? ToString(TamarinHeuristic::s) : heuristic;
+}
+
+double Reward(const LemmaRecord& record) {
+  if(record.result == ProverResult::Unknown) return 0.0;
+  return 1.0 / (1.0 + GetWallTime(record) / kRewardTimeScale);
+}
+
+// Returns how much the given record tells about its heuristic. Crashes,
+// parse errors and cancelled runs tell nothing, and a timeout only tells as
+// much as the time the heuristic had (e.g., little for the short timeouts of
+// portfolio slices or probes of the heuristic search).
+double GetEvidence(const LemmaRecord& record) {
+  switch(record.failure_reason) {
+    case FailureReason::Crash:
+    case FailureReason::ParseError:
+    case FailureReason::Cancelled:
+      return 0.0;
+    case FailureReason::Timeout:
+      return std::min(1.0, GetWallTime(record) / kRewardTimeScale);
+    default:
+      return 1.0;
+  }
+}
+
+double JaccardIndex(const set<string>& A, const vector<string>& B) {
+  if(A.empty() && B.empty()) return 1.0;
+  set<string> unique_B(B.begin(), B.end());
+  int intersection = 0;
+  for(const auto& feature : unique_B) intersection += A.count(feature);
+  return static_cast<double>(intersection) /
+         (A.size() + unique_B.size() - intersection);
+}
+
+} // namespace
+
+HeuristicBandit::HeuristicBandit(const vector<LemmaRecord>& records) :
+  records_(records) {
+}
+
+unordered_map<string, HeuristicBandit::ArmStatistics>
+HeuristicBandit::GetArmStatistics(const vector<string>& features) const {
+  set<string> feature_set(features.begin(), features.end());
+  unordered_map<string, ArmStatistics> statistics_of;
+  for(const auto& record : records_) {
+    double weight = JaccardIndex(feature_set, record.features) *
+                    GetEvidence(record);
+    if(weight <= 0.0) continue;
+    auto& statistics = statistics_of[EffectiveHeuristic(record.heuristic)];
+    statistics.weight += weight;
+    statistics.weighted_reward += weight * Reward(record);
+  }
+  return statistics_of;
+}
+
+vector<TamarinHeuristic> HeuristicBandit::RankHeuristics(
+        const vector<string>& features) const {
+  auto statistics_of = GetArmStatistics(features);
+  double total_weight = 0.0;
+  for(const auto& [heuristic, statistics] : statistics_of) {
+    total_weight += statistics.weight;
+  }
+
+  auto upper_confidence_bound = [&](const TamarinHeuristic& heuristic) {
+    auto statistics = statistics_of[ToString(heuristic)];
+    double weight = statistics.weight + kPriorWeight;
+    double mean = (statistics.weighted_reward +
+                   kPriorReward * kPriorWeight) / weight;
+    return mean + kExplorationFactor *
+                  std::sqrt(2.0 * std::log(1.0 + total_weight) / weight);
+  };
+
+  auto heuristics = PenetrationLemmaJobGenerator::GetAllHeuristics();
+  std::stable_sort(heuristics.begin(), heuristics.end(),
+                   [&](const TamarinHeuristic& a, const TamarinHeuristic& b) {
+                     return upper_confidence_bound(a) >
+                            upper_confidence_bound(b);
+                   });
+  return heuristics;
+}
+
+std::optional<string> HeuristicBandit::GetBestHeuristic(
+        const vector<string>& features) const {
+  std::optional<string> best_heuristic;
+  double best_reward = 0.0;
+  for(const auto& [heuristic, statistics] : GetArmStatistics(features)) {
+    if(statistics.weight < kMinimumEvidence) continue;
+    double reward = statistics.weighted_reward / statistics.weight;
+    if(reward > best_reward) {
+      best_reward = reward;
+      best_heuristic = heuristic;
+    }
+  }
+  return best_heuristic;
+}
+
+namespace {
+
+// Returns the sum of the wall times of the heuristics in 'order' up to (and
+// including) the first heuristic with a definitive result. Heuristics without
+// a recorded outcome are skipped.
+double ReplayOrder(const vector<TamarinHeuristic>& order,
+                   const map<string, const LemmaRecord*>& outcome_of) {
+  double wall_time = 0;
+  for(const auto& heuristic : order) {
+    if(outcome_of.count(ToString(heuristic)) == 0) continue;
+    const auto& record = *outcome_of.at(ToString(heuristic));
+    wall_time += GetWallTime(record);
+    if(record.result != ProverResult::Unknown) break;
+  }
+  return wall_time;
+}
+
+string ToWallTimeString(double wall_time) {
+  std::ostringstream wall_time_stream;
+  wall_time_stream << std::fixed << std::setprecision(2) << wall_time << "s";
+  return wall_time_stream.str();
+}
+
+} // namespace
+
+void PrintBanditReport(const vector<LemmaRecord>& records,
+                       OutputWriter& output_writer) {
+  // The latest outcome of each heuristic, per theory version and lemma
+  map<pair<string, string>, map<string, const LemmaRecord*>> outcomes_of;
+  for(const auto& record : records) {
+    if(record.heuristic.size() > 1) continue;
+    auto& outcome = outcomes_of[{record.theory_hash, record.lemma_name}]
+                               [EffectiveHeuristic(record.heuristic)];
+    if(outcome == nullptr || record.timestamp >= outcome->timestamp) {
+      outcome = &record;
+    }
+  }
+
+  output_writer << "Heuristic bandit vs. fixed order "
+                << "(time until first definitive result):";
+  output_writer.Endl();
+  double fixed_total = 0;
+  double bandit_total = 0;
+  int replayed_lemmas = 0;
+  for(const auto& [key, outcome_of] : outcomes_of) {
+    bool has_definitive_result = std::any_of(outcome_of.begin(),
+      outcome_of.end(), [](const auto& outcome) {
+        return outcome.second->result != ProverResult::Unknown;
+      });
+    if(outcome_of.size() < 2 || !has_definitive_result) continue;
+
+    const auto& lemma_name = key.second;
+    vector<LemmaRecord> training_records;
+    std::copy_if(records.begin(), records.end(),
+                 std::back_inserter(training_records),
+                 [&lemma_name](const LemmaRecord& record) {
+                   return record.lemma_name != lemma_name;
+                 });
+    auto features = outcome_of.begin()->second->features;
+    auto bandit_order = HeuristicBandit(training_records).RankHeuristics(
+                                                                 features);
+    double fixed_wall_time = ReplayOrder(
+            PenetrationLemmaJobGenerator::GetAllHeuristics(), outcome_of);
+    double bandit_wall_time = ReplayOrder(bandit_order, outcome_of);
+
+    output_writer << lemma_name << ": first=" << ToString(bandit_order[0])
+                  << " fixed order " << ToWallTimeString(fixed_wall_time)
+                  << ", bandit " << ToWallTimeString(bandit_wall_time);
+    output_writer.Endl();
+    fixed_total += fixed_wall_time;
+    bandit_total += bandit_wall_time;
+    ++replayed_lemmas;
+  }
+
+  output_writer.Endl();
+  output_writer << "Replayed lemmas: " << replayed_lemmas;
+  output_writer.Endl();
+  output_writer << "Fixed order: " << ToWallTimeString(fixed_total)
+                << ", bandit: " << ToWallTimeString(bandit_total);
+  output_writer.Endl();
+}
+
+} // namespace uttamarin
@@ -0,0 +1,81 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "history_lemma_processor.h"
+
+#include <ctime>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "lemma_history.h"
+#include "lemma_job.h"
+#include "theory_index.h"
+
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+
+namespace uttamarin {
+
+HistoryLemmaProcessor::HistoryLemmaProcessor(
+        unique_ptr<LemmaProcessor> decoratee,
+        shared_ptr<LemmaHistory> history,
+        shared_ptr<const TheoryIndex> theory_index,
+        const RunInfo& run_info) :
+  decoratee_(std::move(decoratee)),
+  history_(history),
+  theory_index_(theory_index),
+  run_info_(run_info) {
+}
+
+TamarinOutput HistoryLemmaProcessor::DoProcessLemma(const LemmaJob& lemma_job) {
+  auto output = decoratee_->ProcessLemma(lemma_job);
+  // Cancelled jobs say nothing about the lemma
+  if(output.failure_reason == FailureReason::Cancelled) return output;
+  LemmaRecord record;
+  record.lemma_name = lemma_job.GetLemmaName();
+  // The heuristic that produced the output, e.g., the winner of a portfolio
+  record.heuristic = output.heuristic;
+  record.result = output.result;
+  record.duration = output.duration;
+  record.theory_hash = theory_index_->GetTheoryHash();
+  record.timestamp = static_cast<long long>(std::time(nullptr));
+  record.features = theory_index_->GetLemmaFeatures(lemma_job.GetLemmaName());
+  record.cone_hash = theory_index_->GetLemmaConeHash(lemma_job.GetLemmaName());
+  record.failure_reason = output.failure_reason;
+  record.steps = output.steps;
+  record.wall_time = output.wall_time;
+  record.processing_time = output.processing_time;
+  record.cpu_time = output.cpu_time;
+  record.max_rss = output.max_rss;
+  record.major_faults = output.major_faults;
+  record.gc_statistics = output.gc_statistics;
+  record.tamarin_version = run_info_.tamarin_version;
+  record.host = run_info_.host;
+  record.run_id = run_info_.run_id;
+  history_->AddRecord(record);
+  if(!output.samples.empty()) history_->AddSamples(record, output.samples);
+  return output;
+}
+
+} // namespace uttamarin
@@ -0,0 +1,84 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "incremental_lemma_processor.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "lemma_history.h"
+#include "lemma_job.h"
+#include "theory_index.h"
+
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+
+namespace uttamarin {
+
+namespace {
+
+const string kUnchangedResultNote =
+        "Note: lemmas marked as unchanged were not run again, since nothing "
+        "they depend on changed since they were verified (see "
+        "--incremental).";
+
+} // namespace
+
+IncrementalLemmaProcessor::IncrementalLemmaProcessor(
+        unique_ptr<LemmaProcessor> decoratee,
+        shared_ptr<const TheoryIndex> theory_index,
+        shared_ptr<LemmaHistory> history,
+        shared_ptr<const TheoryIndex> base_theory_index) :
+  decoratee_(std::move(decoratee)),
+  theory_index_(theory_index),
+  history_(history),
+  base_theory_index_(base_theory_index) {
+}
+
+TamarinOutput IncrementalLemmaProcessor::DoProcessLemma(
+        const LemmaJob& lemma_job) {
+  const auto& lemma_name = lemma_job.GetLemmaName();
+  auto cone_hash = theory_index_->GetLemmaConeHash(lemma_name);
+  auto previous_record = history_->GetLatestDefinitiveRecord(lemma_name,
+                                                             cone_hash);
+  // Only a proof is worth keeping: a falsified lemma stays in the run, so
+  // that the run still fails
+  bool is_unchanged = previous_record.has_value() &&
+          previous_record->result == ProverResult::True &&
+          (base_theory_index_ == nullptr ||
+           base_theory_index_->GetLemmaConeHash(lemma_name) == cone_hash);
+  if(!is_unchanged) return decoratee_->ProcessLemma(lemma_job);
+
+  // Tamarin did not run, so the output takes no time
+  TamarinOutput output;
+  output.result = previous_record->result;
+  output.duration = 0;
+  output.heuristic = previous_record->heuristic;
+  output.steps = previous_record->steps;
+  output.is_unchanged = true;
+  output.warnings.emplace_back(kUnchangedResultNote);
+  return output;
+}
+
+} // namespace uttamarin
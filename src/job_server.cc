@@ -0,0 +1,614 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "job_server.h"
+
+#include <fcntl.h>
+#include <grp.h>
+#include <poll.h>
+#include <pwd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "app.h"
+#include "bash_lemma_processor.h"
+#include "default_lemma_job_generator.h"
+#include "fair_share_scheduler.h"
+#include "jobserver.h"
+#include "lemma_history.h"
+#include "lemma_job.h"
+#include "lemma_processor_factory.h"
+#include "lemma_name_reader.h"
+#include "m4_theory_preprocessor.h"
+#include "output_writer.h"
+#include "remote_result_cache.h"
+#include "resource_sampler.h"
+#include "result_cache.h"
+#include "task_control.h"
+#include "tenant_accounting.h"
+#include "theory_index.h"
+#include "utility.h"
+#include "ut_tamarin_config.h"
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+using json = nlohmann::json;
+
+namespace uttamarin {
+
+namespace {
+
+// Number of connections that may wait for the server to accept them
+const int kConnectionBacklog = 16;
+
+// Number of the latest runs of a lemma that its memory estimate is based on
+const size_t kMemoryEstimateRecords = 5;
+
+// Writes the given line and a newline to the socket. Returns false if the
+// peer closed the connection.
+bool SendLine(int connection, const string& line) {
+  auto data = line + "\n";
+  size_t sent = 0;
+  while(sent < data.size()) {
+    auto result = send(connection, data.data() + sent, data.size() - sent,
+                       MSG_NOSIGNAL);
+    if(result <= 0) return false;
+    sent += result;
+  }
+  return true;
+}
+
+// Reads the next line from the socket into 'line', using 'buffer' for the
+// data after the line. Returns false if the connection ends before a line.
+bool ReceiveLine(int connection, string& buffer, string& line) {
+  while(buffer.find('\n') == string::npos) {
+    char data[4096];
+    auto received = recv(connection, data, sizeof(data), 0);
+    if(received <= 0) return false;
+    buffer.append(data, received);
+  }
+  line = buffer.substr(0, buffer.find('\n'));
+  buffer.erase(0, buffer.find('\n') + 1);
+  return true;
+}
+
+// Returns the user that runs the peer of the given connection or no value if
+// the kernel does not tell
+std::optional<PeerUser> GetPeerUser(int connection) {
+  ucred credentials;
+  socklen_t length = sizeof(credentials);
+  if(getsockopt(connection, SOL_SOCKET, SO_PEERCRED, &credentials,
+                &length) != 0) {
+    return std::nullopt;
+  }
+  PeerUser user;
+  user.uid = credentials.uid;
+  user.groups = {credentials.gid};
+  passwd entry;
+  passwd* result = nullptr;
+  vector<char> buffer(16384);
+  if(getpwuid_r(credentials.uid, &entry, buffer.data(), buffer.size(),
+                &result) != 0 || result == nullptr) {
+    user.name = "uid" + std::to_string(credentials.uid);
+    return user;
+  }
+  user.name = result->pw_name;
+  int number_of_groups = 64;
+  vector<gid_t> groups(number_of_groups);
+  if(getgrouplist(result->pw_name, result->pw_gid, groups.data(),
+                  &number_of_groups) < 0) {
+    groups.resize(number_of_groups);
+    getgrouplist(result->pw_name, result->pw_gid, groups.data(),
+                 &number_of_groups);
+  }
+  groups.resize(std::max(number_of_groups, 0));
+  user.groups.insert(user.groups.end(), groups.begin(), groups.end());
+  return user;
+}
+
+// Returns true if the permission bits of the given file grant the given
+// user the permission of 'user_bit' (e.g., S_IRUSR)
+bool IsPermitted(const struct stat& file_status, const PeerUser& user,
+                 mode_t user_bit, mode_t group_bit, mode_t other_bit) {
+  if(user.uid == 0) return true;
+  if(file_status.st_uid == user.uid) return file_status.st_mode & user_bit;
+  if(std::find(user.groups.begin(), user.groups.end(),
+               file_status.st_gid) != user.groups.end()) {
+    return file_status.st_mode & group_bit;
+  }
+  return file_status.st_mode & other_bit;
+}
+
+// Returns the absolute path of the given file without symbolic links if it
+// names a regular file that the given user could read with the permission
+// bits of the file and of the directories on its path (the server itself
+// may be able to read more), or no value otherwise
+std::optional<string> GetPathReadableBy(const string& file_path,
+                                        const PeerUser& user) {
+  if(file_path.empty() || file_path[0] != '/') return std::nullopt;
+  char* real_path = realpath(file_path.c_str(), nullptr);
+  if(real_path == nullptr) return std::nullopt;
+  string path = real_path;
+  std::free(real_path);
+  struct stat file_status;
+  for(size_t slash = 0;slash != string::npos;
+      slash = path.find('/', slash + 1)) {
+    auto directory = slash == 0 ? "/" : path.substr(0, slash);
+    if(stat(directory.c_str(), &file_status) != 0 ||
+       !IsPermitted(file_status, user, S_IXUSR, S_IXGRP, S_IXOTH)) {
+      return std::nullopt;
+    }
+  }
+  if(stat(path.c_str(), &file_status) != 0 ||
+     !S_ISREG(file_status.st_mode) ||
+     !IsPermitted(file_status, user, S_IRUSR, S_IRGRP, S_IROTH)) {
+    return std::nullopt;
+  }
+  return path;
+}
+
+// Calls the given function once the peer of the given connection closes it
+// (e.g., because the user pressed Ctrl+C), until the watcher is destroyed
+class DisconnectWatcher {
+ public:
+  DisconnectWatcher(int connection, std::function<void()> on_disconnect) :
+    connection_(connection),
+    on_disconnect_(std::move(on_disconnect)) {
+    if(pipe2(stop_pipe_, O_CLOEXEC) != 0) stop_pipe_[0] = stop_pipe_[1] = -1;
+    thread_ = std::thread(&DisconnectWatcher::Watch, this);
+  }
+
+  ~DisconnectWatcher() {
+    if(stop_pipe_[1] >= 0) {
+      char stop = 0;
+      while(write(stop_pipe_[1], &stop, 1) < 0 && errno == EINTR) {}
+    }
+    thread_.join();
+    if(stop_pipe_[0] >= 0) close(stop_pipe_[0]);
+    if(stop_pipe_[1] >= 0) close(stop_pipe_[1]);
+  }
+
+ private:
+  void Watch() {
+    if(stop_pipe_[0] < 0) return;
+    pollfd poll_fds[2] = {{connection_, POLLRDHUP, 0},
+                          {stop_pipe_[0], POLLIN, 0}};
+    while(true) {
+      if(poll(poll_fds, 2, -1) < 0) {
+        if(errno == EINTR) continue;
+        return;
+      }
+      if(poll_fds[1].revents != 0) return;
+      if(poll_fds[0].revents & (POLLRDHUP | POLLHUP | POLLERR)) break;
+      // Clients send nothing after their request
+      char data[256];
+      if(poll_fds[0].revents & POLLIN &&
+         recv(connection_, data, sizeof(data), MSG_DONTWAIT) == 0) break;
+    }
+    on_disconnect_();
+  }
+
+  int connection_;
+  std::function<void()> on_disconnect_;
+  int stop_pipe_[2];
+  std::thread thread_;
+};
+
+// The task controls of the running lemma jobs of a request, which are
+// cancelled together if the client goes away
+struct RequestTasks {
+  std::set<TaskControl*> running_task_controls;
+  bool is_cancelled = false;
+  std::mutex mutex;
+
+  void Cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    is_cancelled = true;
+    for(auto task_control : running_task_controls) task_control->Cancel();
+  }
+};
+
+// Fills the address of the given socket. Returns false if the path is too
+// long for a Unix domain socket.
+bool ToSocketAddress(const string& socket_path, sockaddr_un& address) {
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if(socket_path.size() >= sizeof(address.sun_path)) {
+    std::cerr << "Error: the socket path '" << socket_path << "' is too long."
+              << std::endl;
+    return false;
+  }
+  std::strcpy(address.sun_path, socket_path.c_str());
+  return true;
+}
+
+// Stream buffer that sends every line written to it to a client as an
+// "output" event
+class EventStreamBuffer : public std::streambuf {
+ public:
+  explicit EventStreamBuffer(int connection) : connection_(connection) {}
+
+ protected:
+  virtual int_type overflow(int_type c) override {
+    if(c == traits_type::eof()) return traits_type::not_eof(c);
+    if(c != '\n') {
+      line_ += traits_type::to_char_type(c);
+      return c;
+    }
+    // A client that went away gets its run cancelled (see
+    // DisconnectWatcher), until then its output is dropped
+    SendLine(connection_, json{{"event", "output"}, {"text", line_}}.dump());
+    line_.clear();
+    return c;
+  }
+
+ private:
+  int connection_;
+  string line_;
+};
+
+} // namespace
+
+string GetDefaultSocketPath() {
+  auto runtime_directory = std::getenv("XDG_RUNTIME_DIR");
+  if(runtime_directory != nullptr && string(runtime_directory) != "") {
+    return string(runtime_directory) + "/uttamarin.sock";
+  }
+  return "/tmp/uttamarin-" + std::to_string(getuid()) + ".sock";
+}
+
+JobServer::JobServer(const string& socket_path,
+                     const CmdParameters& parameters) :
+  socket_path_(socket_path),
+  parameters_(parameters),
+  tamarin_version_(BashLemmaProcessor::GetTamarinVersion()),
+  jobserver_(JobserverClient::Connect(parameters.jobserver_path)),
+  scheduler_(std::make_shared<FairShareScheduler>(
+          parameters.jobs, parameters.tenants_file_path, jobserver_)),
+  accounting_(std::make_shared<TenantAccounting>(
+          parameters.accounting_file_path)),
+  result_cache_(std::make_shared<ResultCache>()),
+  open_connections_(0) {
+  if(!parameters.history_file_path.empty()) {
+    history_ = std::make_shared<LemmaHistory>(parameters.history_file_path);
+  }
+  if(parameters.sample_interval > 0) {
+    resource_sampler_ =
+            std::make_shared<ResourceSampler>(parameters.sample_interval);
+  }
+  if(parameters.remote_cache_url != "") {
+    remote_result_cache_ = std::make_shared<RemoteResultCache>(
+            parameters.remote_cache_url, parameters.remote_cache_token);
+  }
+}
+
+JobServer::~JobServer() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  all_connections_closed_.wait(lock, [this] { return open_connections_ == 0; });
+}
+
+bool JobServer::Run() {
+  sockaddr_un address;
+  if(!ToSocketAddress(socket_path_, address)) return false;
+  auto server_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(server_socket < 0) {
+    std::cerr << "Error: cannot create a socket." << std::endl;
+    return false;
+  }
+
+  // A socket file that nobody listens on is left over from an earlier server
+  auto probe_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(connect(probe_socket, reinterpret_cast<sockaddr*>(&address),
+             sizeof(address)) == 0) {
+    std::cerr << "Error: another server already listens on '"
+              << socket_path_ << "'." << std::endl;
+    close(probe_socket);
+    close(server_socket);
+    return false;
+  }
+  close(probe_socket);
+  unlink(socket_path_.c_str());
+
+  // Connecting requires the permission to write to the socket file, so only
+  // the user of the server may connect unless the server is shared
+  auto old_umask = umask(parameters_.is_shared_server ? 0111 : 0177);
+  bool is_bound = bind(server_socket, reinterpret_cast<sockaddr*>(&address),
+                       sizeof(address)) == 0;
+  umask(old_umask);
+  if(!is_bound || listen(server_socket, kConnectionBacklog) != 0) {
+    std::cerr << "Error: cannot listen on '" << socket_path_ << "': "
+              << std::strerror(errno) << std::endl;
+    close(server_socket);
+    return false;
+  }
+  std::cout << "Listening on '" << socket_path_ << "' with "
+            << scheduler_->GetNumberOfWorkers() << " worker(s)."
+            << std::endl;
+
+  while(true) {
+    auto connection = accept(server_socket, nullptr, nullptr);
+    if(connection < 0) {
+      if(errno == EINTR) continue;
+      std::cerr << "Error: cannot accept connections: "
+                << std::strerror(errno) << std::endl;
+      close(server_socket);
+      return false;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++open_connections_;
+    }
+    std::thread(&JobServer::HandleConnection, this, connection).detach();
+  }
+}
+
+void JobServer::HandleConnection(int connection) {
+  string buffer;
+  string request_line;
+  auto user = GetPeerUser(connection);
+  if(!user.has_value()) {
+    SendLine(connection, json{{"event", "error"},
+                              {"message", "unknown user"}}.dump());
+  } else if(ReceiveLine(connection, buffer, request_line)) {
+    auto request = json::parse(request_line, nullptr, false);
+    if(request.is_object() && request.value("type", "") == "accounting") {
+      EventStreamBuffer event_stream_buffer(connection);
+      std::ostream event_stream(&event_stream_buffer);
+      {
+        OutputWriter output_writer({&event_stream});
+        PrintAccountingReport(accounting_->GetUsage(), output_writer);
+      }
+      SendLine(connection, json{{"event", "done"}, {"success", true}}.dump());
+    } else if(!request.is_object() || !request.contains("theory") ||
+              !request["theory"].is_string()) {
+      SendLine(connection, json{{"event", "error"},
+                                {"message", "invalid request"}}.dump());
+    } else {
+      try {
+        auto success = RunRequest(request, user.value(), connection);
+        SendLine(connection, json{{"event", "done"},
+                                  {"success", success}}.dump());
+      } catch(const std::exception& exception) {
+        SendLine(connection, json{{"event", "error"},
+                                  {"message", exception.what()}}.dump());
+      }
+    }
+  }
+  close(connection);
+  std::lock_guard<std::mutex> lock(mutex_);
+  --open_connections_;
+  all_connections_closed_.notify_all();
+}
+
+bool JobServer::RunRequest(const json& request, const PeerUser& peer_user,
+                           int connection) {
+  const auto& user = peer_user.name;
+  auto parameters = parameters_;
+  parameters.spthy_file_path = request["theory"].get<string>();
+  parameters.config_file_path = request.value("config", "");
+  parameters.starting_lemma = request.value("start", "");
+  parameters.timeout = request.value("timeout", parameters_.timeout);
+  parameters.abort_after_failure =
+          request.value("abort_after_failure", false);
+  parameters.is_ordered_output = request.value("ordered_output", false);
+  // Runs are scheduled for the user that submits them. The declared tenant
+  // only labels the runs of that user in the accounts.
+  auto label = request.value("tenant", user);
+  auto account = label == "" || label == user ? user : user + "/" + label;
+  auto priority = ToJobPriority(request.value("priority", "batch"));
+  if(!priority.has_value()) {
+    throw std::runtime_error("unknown priority '" +
+                             request.value("priority", "") + "'");
+  }
+  // The server runs with its own permissions, so it only reads the files
+  // that the user of the client may read
+  auto get_readable_path = [&peer_user](const string& file_path) {
+    auto readable_path = GetPathReadableBy(file_path, peer_user);
+    if(!readable_path.has_value()) {
+      throw std::runtime_error("'" + file_path + "' is not the absolute "
+                               "path of a file that you can read");
+    }
+    return readable_path.value();
+  };
+  parameters.spthy_file_path = get_readable_path(parameters.spthy_file_path);
+  if(parameters.config_file_path != "") {
+    parameters.config_file_path =
+            get_readable_path(parameters.config_file_path);
+  }
+  for(const auto& included_file :
+      GetIncludedFiles(parameters.spthy_file_path)) {
+    get_readable_path(included_file);
+  }
+
+  auto config = std::make_shared<UtTamarinConfig>(parameters);
+  auto theory_index = GetTheoryIndex(parameters.spthy_file_path);
+  DefaultLemmaJobGenerator lemma_job_generator(
+          parameters.spthy_file_path, parameters.starting_lemma, config,
+          history_, theory_index,
+          GetLemmaNames(parameters.spthy_file_path,
+                        theory_index->GetTheoryHash()));
+  auto lemma_jobs = lemma_job_generator.GenerateLemmaJobs();
+  lemma_jobs = SelectLemmaJobs(lemma_jobs,
+                               request.value("lemmas", vector<string>{}));
+
+  // The scheduler takes the slots of the jobserver, so that suspended lemma
+  // jobs can hand them over
+  LemmaProcessorParts lemma_processor_parts;
+  lemma_processor_parts.history = history_;
+  lemma_processor_parts.resource_sampler = resource_sampler_;
+  lemma_processor_parts.result_cache = result_cache_;
+  lemma_processor_parts.remote_result_cache = remote_result_cache_;
+  lemma_processor_parts.accounting = accounting_;
+  lemma_processor_parts.account = account;
+  lemma_processor_parts.run_info = CreateRunInfo(tamarin_version_);
+  auto lemma_processor = CreateLemmaProcessor(parameters,
+                                              lemma_processor_parts,
+                                              theory_index);
+
+  // Jobs of a client that goes away are cancelled, including those that
+  // only start afterwards
+  auto request_tasks = std::make_shared<RequestTasks>();
+  DisconnectWatcher disconnect_watcher(connection, [request_tasks] {
+    request_tasks->Cancel();
+  });
+
+  EventStreamBuffer event_stream_buffer(connection);
+  std::ostream event_stream(&event_stream_buffer);
+  auto output_writer = std::make_shared<OutputWriter>(
+          vector<std::ostream*>{&event_stream},
+          parameters.is_ordered_output ? OutputOrder::File :
+                                         OutputOrder::Completion);
+  App app(std::move(lemma_processor),
+          std::make_unique<M4TheoryPreprocessor>(config),
+          config,
+          output_writer,
+          [this, user, priority, request_tasks](
+                  const LemmaJob& lemma_job, std::function<void()> task) {
+            scheduler_->Submit(
+                    user, priority.value(),
+                    EstimateMemory(lemma_job.GetLemmaName()),
+                    [request_tasks, task = std::move(task)] {
+                      auto task_control = TaskControl::GetCurrent();
+                      {
+                        std::lock_guard<std::mutex> lock(
+                                request_tasks->mutex);
+                        request_tasks->running_task_controls.insert(
+                                task_control);
+                        if(request_tasks->is_cancelled) task_control->Cancel();
+                      }
+                      task();
+                      std::lock_guard<std::mutex> lock(request_tasks->mutex);
+                      request_tasks->running_task_controls.erase(task_control);
+                    });
+          });
+  return app.RunOnLemmas(lemma_jobs);
+}
+
+long JobServer::EstimateMemory(const string& lemma_name) const {
+  if(history_ == nullptr) return 0;
+  auto records = history_->GetRecordsOfLemma(lemma_name);
+  long memory = 0;
+  for(size_t i = records.size() > kMemoryEstimateRecords ?
+                 records.size() - kMemoryEstimateRecords : 0;
+      i < records.size();++i) {
+    memory = std::max(memory, records[i].max_rss);
+  }
+  return memory;
+}
+
+shared_ptr<const TheoryIndex> JobServer::GetTheoryIndex(
+        const string& spthy_file_path) {
+  auto theory_hash = HashString(ReadTheoryText(spthy_file_path));
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = theory_index_of_.find(spthy_file_path);
+    if(it != theory_index_of_.end() &&
+       it->second->GetTheoryHash() == theory_hash) {
+      return it->second;
+    }
+  }
+  auto theory_index = std::make_shared<const TheoryIndex>(spthy_file_path);
+  std::lock_guard<std::mutex> lock(mutex_);
+  theory_index_of_[spthy_file_path] = theory_index;
+  return theory_index;
+}
+
+vector<string> JobServer::GetLemmaNames(const string& spthy_file_path,
+                                        const string& theory_hash) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = lemma_names_of_.find(theory_hash);
+    if(it != lemma_names_of_.end()) return it->second;
+  }
+  auto lemma_names = ReadLemmaNamesFromSpthyFile(spthy_file_path);
+  // Tamarin finds no lemmas in theories it cannot parse, which may be fixed
+  // by the next request
+  if(lemma_names.empty()) return lemma_names;
+  std::lock_guard<std::mutex> lock(mutex_);
+  lemma_names_of_[theory_hash] = lemma_names;
+  return lemma_names;
+}
+
+int SubmitJobRequest(const string& socket_path, const json& request,
+                     OutputWriter& output_writer) {
+  sockaddr_un address;
+  if(!ToSocketAddress(socket_path, address)) return 1;
+  auto connection = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(connection < 0 ||
+     connect(connection, reinterpret_cast<sockaddr*>(&address),
+             sizeof(address)) != 0) {
+    std::cerr << "Error: cannot connect to a server on '" << socket_path
+              << "' (see 'uttamarin serve')." << std::endl;
+    if(connection >= 0) close(connection);
+    return 1;
+  }
+
+  int exit_status = 1;
+  bool is_answered = false;
+  string buffer;
+  string line;
+  if(SendLine(connection, request.dump())) {
+    while(!is_answered && ReceiveLine(connection, buffer, line)) {
+      auto event = json::parse(line, nullptr, false);
+      if(!event.is_object()) continue;
+      auto event_type = event.value("event", "");
+      if(event_type == "output") {
+        output_writer << event.value("text", "");
+        output_writer.Endl();
+      } else if(event_type == "done") {
+        exit_status = 0;
+        is_answered = true;
+      } else if(event_type == "error") {
+        std::cerr << "Error: " << event.value("message", "") << std::endl;
+        is_answered = true;
+      }
+    }
+  }
+  if(!is_answered) {
+    std::cerr << "Error: the server closed the connection." << std::endl;
+  }
+  close(connection);
+  return exit_status;
+}
+
+} // namespace uttamarin
@@ -0,0 +1,266 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "jobserver.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/file.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::string;
+
+namespace uttamarin {
+
+namespace {
+
+// The token that GNU make writes for every job slot
+const char kToken = '+';
+
+// Returns the value of the last option "--jobserver-auth" (or of its older
+// name "--jobserver-fds") in the given MAKEFLAGS or the empty string
+string FindJobserverAuth(const string& makeflags) {
+  std::istringstream words(makeflags);
+  string auth = "";
+  for(string word;words >> word;) {
+    for(const char* option : {"--jobserver-auth=", "--jobserver-fds="}) {
+      if(word.rfind(option, 0) == 0) auth = word.substr(string(option).size());
+    }
+  }
+  return auth;
+}
+
+int OpenFifo(const string& fifo_path) {
+  int descriptor = open(fifo_path.c_str(), O_RDWR | O_CLOEXEC);
+  struct stat file_status;
+  if(descriptor >= 0 && (fstat(descriptor, &file_status) != 0 ||
+                         !S_ISFIFO(file_status.st_mode))) {
+    close(descriptor);
+    descriptor = -1;
+  }
+  if(descriptor < 0) {
+    std::cerr << "Warning: cannot open the jobserver FIFO '" << fifo_path
+              << "', running without a jobserver." << std::endl;
+  }
+  return descriptor;
+}
+
+} // namespace
+
+string GetDefaultJobserverPath() {
+  return "/tmp/uttamarin-jobserver.fifo";
+}
+
+std::shared_ptr<JobserverClient> JobserverClient::Connect(
+        const string& fifo_path) {
+  if(fifo_path != "") {
+    int descriptor = OpenFifo(fifo_path);
+    if(descriptor < 0) return nullptr;
+    // Every Tamarin run needs a token, since the host-wide jobserver did not
+    // start this process
+    return std::shared_ptr<JobserverClient>(
+            new JobserverClient(descriptor, descriptor, true, false));
+  }
+
+  const char* makeflags = std::getenv("MAKEFLAGS");
+  if(makeflags == nullptr) return nullptr;
+  auto auth = FindJobserverAuth(makeflags);
+  if(auth == "") return nullptr;
+  if(auth.rfind("fifo:", 0) == 0) {
+    int descriptor = OpenFifo(auth.substr(5));
+    if(descriptor < 0) return nullptr;
+    return std::shared_ptr<JobserverClient>(
+            new JobserverClient(descriptor, descriptor, true, true));
+  }
+  int read_descriptor = -1;
+  int write_descriptor = -1;
+  char separator = 0;
+  std::istringstream auth_stream(auth);
+  auth_stream >> read_descriptor >> separator >> write_descriptor;
+  if(separator != ',' || read_descriptor < 0 || write_descriptor < 0) {
+    return nullptr;
+  }
+  // GNU make closes the pipe for commands it does not consider recursive
+  if(fcntl(read_descriptor, F_GETFD) == -1 ||
+     fcntl(write_descriptor, F_GETFD) == -1) {
+    std::cerr << "Warning: the jobserver of make is not available (prefix "
+              << "the recipe with '+'), running without a jobserver."
+              << std::endl;
+    return nullptr;
+  }
+  return std::shared_ptr<JobserverClient>(
+          new JobserverClient(read_descriptor, write_descriptor, false,
+                              true));
+}
+
+std::optional<int> JobserverClient::GetMakeJobs() {
+  const char* makeflags = std::getenv("MAKEFLAGS");
+  if(makeflags == nullptr) return std::nullopt;
+  std::istringstream words(makeflags);
+  std::optional<int> jobs;
+  for(string word;words >> word;) {
+    if(word.size() > 2 && word.rfind("-j", 0) == 0 &&
+       word.find_first_not_of("0123456789", 2) == string::npos) {
+      jobs = std::stoi(word.substr(2));
+    }
+  }
+  return jobs;
+}
+
+JobserverClient::JobserverClient(int read_descriptor, int write_descriptor,
+                                 bool owns_descriptors,
+                                 bool has_implicit_slot) :
+  read_descriptor_(read_descriptor),
+  write_descriptor_(write_descriptor),
+  owns_descriptors_(owns_descriptors),
+  has_implicit_slot_(has_implicit_slot),
+  is_implicit_slot_free_(has_implicit_slot),
+  is_broken_(false) {
+}
+
+JobserverClient::~JobserverClient() {
+  for(auto token : tokens_) {
+    while(write(write_descriptor_, &token, 1) < 0 && errno == EINTR) {}
+  }
+  if(owns_descriptors_) {
+    close(read_descriptor_);
+    if(write_descriptor_ != read_descriptor_) close(write_descriptor_);
+  }
+}
+
+bool JobserverClient::AcquireSlot() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(is_implicit_slot_free_) {
+      is_implicit_slot_free_ = false;
+      return true;
+    }
+  }
+  // Other processes may take the token between poll and read, and GNU make
+  // may have made the pipe non-blocking
+  char token;
+  while(true) {
+    pollfd poll_descriptor{read_descriptor_, POLLIN, 0};
+    if(poll(&poll_descriptor, 1, -1) < 0 && errno != EINTR) break;
+    auto bytes_read = read(read_descriptor_, &token, 1);
+    if(bytes_read == 1) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tokens_.emplace_back(token);
+      return true;
+    }
+    if(bytes_read == 0 || (errno != EAGAIN && errno != EINTR)) break;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if(!is_broken_) {
+    std::cerr << "Warning: the jobserver is no longer available, running "
+              << "without a job slot." << std::endl;
+    is_broken_ = true;
+  }
+  return false;
+}
+
+void JobserverClient::ReleaseSlot() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if(tokens_.empty()) {
+    is_implicit_slot_free_ = has_implicit_slot_;
+    return;
+  }
+  auto token = tokens_.back();
+  tokens_.pop_back();
+  while(write(write_descriptor_, &token, 1) < 0 && errno == EINTR) {}
+}
+
+JobSlot::JobSlot(std::shared_ptr<JobserverClient> jobserver) :
+  jobserver_(jobserver),
+  is_acquired_(jobserver_ != nullptr && jobserver_->AcquireSlot()) {
+}
+
+JobSlot::~JobSlot() {
+  if(is_acquired_) jobserver_->ReleaseSlot();
+}
+
+bool JobSlot::IsAcquired() const {
+  return is_acquired_;
+}
+
+bool RunJobserver(const string& fifo_path, int slots) {
+  if(mkfifo(fifo_path.c_str(), 0666) != 0 && errno != EEXIST) {
+    std::cerr << "Error: cannot create the FIFO '" << fifo_path << "'."
+              << std::endl;
+    return false;
+  }
+  // Anybody may create the path in /tmp, so it must be a FIFO of this user
+  // before its mode changes
+  int descriptor = open(fifo_path.c_str(), O_RDWR | O_CLOEXEC | O_NOFOLLOW);
+  struct stat file_status;
+  if(descriptor < 0 || fstat(descriptor, &file_status) != 0 ||
+     !S_ISFIFO(file_status.st_mode) || file_status.st_uid != geteuid()) {
+    std::cerr << "Error: '" << fifo_path << "' is not a FIFO of this user."
+              << std::endl;
+    if(descriptor >= 0) close(descriptor);
+    return false;
+  }
+  // The lock is held as long as the jobserver runs, even while clients hold
+  // all of its tokens
+  if(flock(descriptor, LOCK_EX | LOCK_NB) != 0) {
+    std::cerr << "Error: another jobserver is running on '" << fifo_path
+              << "'." << std::endl;
+    close(descriptor);
+    return false;
+  }
+  // The umask must not keep other users from sharing the slots
+  fchmod(descriptor, 0666);
+  // Tokens of an earlier jobserver would add to the slots
+  int queued_tokens = 0;
+  while(ioctl(descriptor, FIONREAD, &queued_tokens) == 0 &&
+        queued_tokens > 0) {
+    string stale_tokens(queued_tokens, kToken);
+    if(read(descriptor, stale_tokens.data(), stale_tokens.size()) <= 0) break;
+  }
+  string tokens(slots, kToken);
+  if(write(descriptor, tokens.data(), tokens.size()) !=
+     static_cast<ssize_t>(tokens.size())) {
+    std::cerr << "Error: cannot write the tokens to '" << fifo_path << "'."
+              << std::endl;
+    return false;
+  }
+  std::cout << "Jobserver with " << slots << " slot(s) on '" << fifo_path
+            << "'. Run UT Tamarin with --jobserver=" << fifo_path
+            << " or export MAKEFLAGS=\"-j" << slots
+            << " --jobserver-auth=fifo:" << fifo_path << "\"." << std::endl;
+  // The tokens only exist while the FIFO is open
+  while(true) pause();
+}
+
+} // namespace uttamarin
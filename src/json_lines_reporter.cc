@@ -0,0 +1,99 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "json_lines_reporter.h"
+
+#include <iostream>
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+#include "lemma_job.h"
+#include "lemma_processor.h"
+#include "tamarin_output_parser.h"
+
+using std::string;
+using json = nlohmann::json;
+
+namespace uttamarin {
+
+namespace {
+
+string ToReportString(ProverResult result) {
+  switch(result) {
+    case ProverResult::True: return "verified";
+    case ProverResult::False: return "falsified";
+    default: return "unknown";
+  }
+}
+
+} // namespace
+
+JsonLinesReporter::JsonLinesReporter(const string& report_file_path) :
+  report_stream_(report_file_path) {
+  if(!report_stream_) {
+    std::cerr << "Warning: cannot write report file '" << report_file_path
+              << "'." << std::endl;
+  }
+}
+
+void JsonLinesReporter::DoReportLemmaStarted(const LemmaJob& lemma_job,
+                                             double time) {
+  report_stream_ << json{{"event", "start"},
+                         {"time", time},
+                         {"theory", lemma_job.GetSpthyFilePath()},
+                         {"lemma", lemma_job.GetLemmaName()},
+                         {"heuristic", lemma_job.GetHeuristic()}}.dump()
+                 << std::endl;
+}
+
+void JsonLinesReporter::DoReportLemmaFinished(
+        const LemmaJob& lemma_job,
+        const TamarinOutput& tamarin_output,
+        double time) {
+  json event{{"event", "finish"},
+             {"time", time},
+             {"theory", lemma_job.GetSpthyFilePath()},
+             {"lemma", lemma_job.GetLemmaName()},
+             {"heuristic", tamarin_output.heuristic},
+             {"result", ToReportString(tamarin_output.result)},
+             {"failure", ToString(tamarin_output.failure_reason)},
+             {"duration", tamarin_output.duration},
+             {"wall_time", tamarin_output.wall_time},
+             {"processing_time", tamarin_output.processing_time},
+             {"cpu_time", tamarin_output.cpu_time},
+             {"max_rss", tamarin_output.max_rss},
+             {"major_faults", tamarin_output.major_faults},
+             {"steps", tamarin_output.steps},
+             {"warnings", tamarin_output.warnings},
+             {"error", tamarin_output.error}};
+  const auto& gc_statistics = tamarin_output.gc_statistics;
+  if(gc_statistics.bytes_allocated >= 0) {
+    event["gc"] = {{"bytes_allocated", gc_statistics.bytes_allocated},
+                   {"max_residency", gc_statistics.max_residency},
+                   {"gc_time_fraction", gc_statistics.gc_time_fraction},
+                   {"productivity", gc_statistics.productivity}};
+  }
+  report_stream_ << event.dump() << std::endl;
+}
+
+} // namespace uttamarin
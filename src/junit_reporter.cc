@@ -0,0 +1,156 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "junit_reporter.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "lemma_job.h"
+#include "lemma_processor.h"
+#include "tamarin_output_parser.h"
+
+using std::string;
+
+namespace uttamarin {
+
+namespace {
+
+string EscapeXml(const string& text) {
+  string escaped;
+  for(auto c : text) {
+    switch(c) {
+      case '&': escaped += "&amp;"; break;
+      case '<': escaped += "&lt;"; break;
+      case '>': escaped += "&gt;"; break;
+      case '"': escaped += "&quot;"; break;
+      case '\'': escaped += "&apos;"; break;
+      default: escaped += c;
+    }
+  }
+  return escaped;
+}
+
+// Returns the file name of the theory without directory and extension,
+// which serves as the name of the test suite
+string GetSuiteName(const string& spthy_file_path) {
+  auto name = spthy_file_path.substr(spthy_file_path.find_last_of('/') + 1);
+  return name.substr(0, name.rfind(".spthy"));
+}
+
+} // namespace
+
+JUnitReporter::JUnitReporter(const string& report_file_path) :
+  report_file_path_(report_file_path) {
+  WriteReport();
+}
+
+void JUnitReporter::DoReportLemmaStarted(const LemmaJob& /*lemma_job*/,
+                                         double /*time*/) {
+}
+
+void JUnitReporter::DoReportLemmaFinished(const LemmaJob& lemma_job,
+                                          const TamarinOutput& tamarin_output,
+                                          double /*time*/) {
+  TestCase test_case{GetSuiteName(lemma_job.GetSpthyFilePath()),
+                     lemma_job.GetLemmaName(), tamarin_output.wall_time, "",
+                     tamarin_output.result == ProverResult::False,
+                     tamarin_output.result == ProverResult::Unknown};
+  // Jobs of a heuristic search share the lemma name
+  if(!lemma_job.GetHeuristic().empty()) {
+    test_case.name += " (heuristic " + lemma_job.GetHeuristic() + ")";
+  }
+
+  std::ostringstream xml;
+  xml << "    <testcase classname=\"" << EscapeXml(test_case.suite_name)
+      << "\" name=\"" << EscapeXml(test_case.name)
+      << "\" time=\"" << test_case.time << "\"";
+  if(test_case.is_failure) {
+    xml << ">\n      <failure type=\"falsified\" message=\"falsified";
+    if(tamarin_output.steps >= 0) {
+      xml << " (" << tamarin_output.steps << " steps)";
+    }
+    xml << "\"/>\n    </testcase>\n";
+  } else if(test_case.is_error) {
+    auto reason = tamarin_output.failure_reason == FailureReason::None ?
+                  "unverified" : ToString(tamarin_output.failure_reason);
+    xml << ">\n      <error type=\"" << EscapeXml(reason)
+        << "\" message=\"" << EscapeXml(reason) << "\">"
+        << EscapeXml(tamarin_output.error) << "</error>\n    </testcase>\n";
+  } else {
+    xml << "/>\n";
+  }
+  test_case.xml = xml.str();
+  test_cases_.emplace_back(test_case);
+  WriteReport();
+}
+
+void JUnitReporter::WriteReport() {
+  struct SuiteTotals {
+    int tests = 0;
+    int failures = 0;
+    int errors = 0;
+    double time = 0;
+    string test_cases_xml;
+  };
+  std::map<string, SuiteTotals> totals_of_suite;
+  SuiteTotals totals;
+  for(const auto& test_case : test_cases_) {
+    for(auto suite_totals : {&totals_of_suite[test_case.suite_name],
+                             &totals}) {
+      ++suite_totals->tests;
+      suite_totals->failures += test_case.is_failure;
+      suite_totals->errors += test_case.is_error;
+      suite_totals->time += test_case.time;
+    }
+    totals_of_suite[test_case.suite_name].test_cases_xml += test_case.xml;
+  }
+
+  auto temp_file_path = report_file_path_ + ".tmp";
+  {
+    std::ofstream report_stream{temp_file_path};
+    report_stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      << "<testsuites name=\"uttamarin\" tests=\"" << totals.tests
+      << "\" failures=\"" << totals.failures << "\" errors=\""
+      << totals.errors << "\" time=\"" << totals.time << "\">\n";
+    for(const auto& [suite_name, suite_totals] : totals_of_suite) {
+      report_stream << "  <testsuite name=\"" << EscapeXml(suite_name)
+        << "\" tests=\"" << suite_totals.tests << "\" failures=\""
+        << suite_totals.failures << "\" errors=\"" << suite_totals.errors
+        << "\" time=\"" << suite_totals.time << "\">\n"
+        << suite_totals.test_cases_xml << "  </testsuite>\n";
+    }
+    report_stream << "</testsuites>\n";
+    if(!report_stream) {
+      std::cerr << "Warning: cannot write report file '" << temp_file_path
+                << "'." << std::endl;
+      return;
+    }
+  }
+  std::rename(temp_file_path.c_str(), report_file_path_.c_str());
+}
+
+} // namespace uttamarin
@@ -0,0 +1,382 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "lemma_history.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "lemma_job.h"
+#include "tamarin_output_parser.h"
+
+using std::string;
+using std::unordered_map;
+using std::vector;
+using json = nlohmann::json;
+
+namespace uttamarin {
+
+namespace {
+
+// Records that are kept per lemma (besides its latest definitive one), which
+// bounds the size of the history after years of nightly runs
+const size_t kMaxRecordsPerLemma = 100;
+
+// The history file is compacted once it holds this many times the records
+// that are kept, so that every record is rewritten only a few times
+const size_t kCompactionFactor = 2;
+
+// Holds a lock on the lock file of a history file (see LemmaHistory)
+class HistoryLock {
+ public:
+  HistoryLock(const string& history_file_path, int operation) :
+    file_descriptor_(open((history_file_path + ".lock").c_str(),
+                          O_RDWR | O_CREAT | O_CLOEXEC, 0644)),
+    is_locked_(file_descriptor_ >= 0 &&
+               flock(file_descriptor_, operation) == 0) {}
+
+  ~HistoryLock() {
+    if(file_descriptor_ >= 0) close(file_descriptor_);
+  }
+
+  bool IsLocked() const {
+    return is_locked_;
+  }
+
+ private:
+  int file_descriptor_;
+  bool is_locked_;
+};
+
+string ToHistoryString(const ProverResult& result) {
+  switch(result) {
+    case ProverResult::True: return "verified";
+    case ProverResult::False: return "falsified";
+    default: return "unknown";
+  }
+}
+
+ProverResult ToProverResult(const string& result) {
+  if(result == "verified") return ProverResult::True;
+  if(result == "falsified") return ProverResult::False;
+  return ProverResult::Unknown;
+}
+
+json ToJson(const GcStatistics& gc_statistics) {
+  return json{{"bytes_allocated", gc_statistics.bytes_allocated},
+              {"max_residency", gc_statistics.max_residency},
+              {"number_of_gcs", gc_statistics.number_of_gcs},
+              {"gc_cpu_time", gc_statistics.gc_cpu_time},
+              {"mutator_cpu_time", gc_statistics.mutator_cpu_time},
+              {"gc_time_fraction", gc_statistics.gc_time_fraction},
+              {"productivity", gc_statistics.productivity},
+              {"parallel_gc_balance", gc_statistics.parallel_gc_balance}};
+}
+
+GcStatistics ToGcStatistics(const json& json_statistics) {
+  GcStatistics gc_statistics;
+  gc_statistics.bytes_allocated =
+          json_statistics.value("bytes_allocated", -1LL);
+  gc_statistics.max_residency = json_statistics.value("max_residency", 0LL);
+  gc_statistics.number_of_gcs = json_statistics.value("number_of_gcs", 0LL);
+  gc_statistics.gc_cpu_time = json_statistics.value("gc_cpu_time", 0.0);
+  gc_statistics.mutator_cpu_time =
+          json_statistics.value("mutator_cpu_time", 0.0);
+  gc_statistics.gc_time_fraction =
+          json_statistics.value("gc_time_fraction", 0.0);
+  gc_statistics.productivity = json_statistics.value("productivity", 0.0);
+  gc_statistics.parallel_gc_balance =
+          json_statistics.value("parallel_gc_balance", -1.0);
+  return gc_statistics;
+}
+
+json ToJson(const LemmaRecord& record) {
+  auto json_record = json{{"lemma", record.lemma_name},
+                          {"heuristic", record.heuristic},
+                          {"result", ToHistoryString(record.result)},
+                          {"duration", record.duration},
+                          {"theory_hash", record.theory_hash},
+                          {"timestamp", record.timestamp},
+                          {"features", record.features},
+                          {"cone_hash", record.cone_hash},
+                          {"failure", ToString(record.failure_reason)},
+                          {"steps", record.steps},
+                          {"wall_time", record.wall_time},
+                          {"processing_time", record.processing_time},
+                          {"cpu_time", record.cpu_time},
+                          {"max_rss", record.max_rss},
+                          {"major_faults", record.major_faults},
+                          {"tamarin_version", record.tamarin_version},
+                          {"host", record.host},
+                          {"run_id", record.run_id}};
+  // Only runs with GC statistics (see --gc_statistics) store them
+  if(record.gc_statistics.bytes_allocated >= 0) {
+    json_record["gc"] = ToJson(record.gc_statistics);
+  }
+  return json_record;
+}
+
+LemmaRecord ToLemmaRecord(const json& json_record) {
+  LemmaRecord record;
+  record.lemma_name = json_record.value("lemma", "");
+  record.heuristic = json_record.value("heuristic", "");
+  record.result = ToProverResult(json_record.value("result", ""));
+  record.duration = json_record.value("duration", 0);
+  record.theory_hash = json_record.value("theory_hash", "");
+  record.timestamp = json_record.value("timestamp", 0LL);
+  record.features = json_record.value("features", vector<string>{});
+  record.cone_hash = json_record.value("cone_hash", "");
+  record.failure_reason = ToFailureReason(json_record.value("failure", ""));
+  record.steps = json_record.value("steps", -1);
+  record.wall_time = json_record.value("wall_time", 0.0);
+  record.processing_time = json_record.value("processing_time", -1.0);
+  record.cpu_time = json_record.value("cpu_time", 0.0);
+  record.max_rss = json_record.value("max_rss", 0L);
+  record.major_faults = json_record.value("major_faults", 0L);
+  record.tamarin_version = json_record.value("tamarin_version", "");
+  record.host = json_record.value("host", "");
+  record.run_id = json_record.value("run_id", "");
+  if(json_record.contains("gc") && json_record["gc"].is_object()) {
+    record.gc_statistics = ToGcStatistics(json_record["gc"]);
+  }
+  return record;
+}
+
+// Returns true if the given record is a definitive result for the given
+// theory hash that can be used as the fastest heuristic of its lemma
+bool IsFastestCandidate(const LemmaRecord& record, const string& theory_hash) {
+  return record.theory_hash == theory_hash &&
+         record.result != ProverResult::Unknown &&
+         IsValidHeuristic(record.heuristic);
+}
+
+// Returns true if the record 'a' was faster than the record 'b' or, if both
+// were equally fast, more recent
+bool IsFaster(const LemmaRecord& a, const LemmaRecord& b) {
+  if(GetWallTime(a) != GetWallTime(b)) return GetWallTime(a) < GetWallTime(b);
+  return a.timestamp >= b.timestamp;
+}
+
+} // namespace
+
+double GetWallTime(const LemmaRecord& record) {
+  return record.wall_time > 0 ? record.wall_time : record.duration;
+}
+
+RunInfo CreateRunInfo(const string& tamarin_version) {
+  char host[256] = "";
+  gethostname(host, sizeof(host) - 1);
+  auto now = std::time(nullptr);
+  char timestamp[32];
+  std::strftime(timestamp, sizeof(timestamp), "%Y%m%dT%H%M%S",
+                std::localtime(&now));
+  return RunInfo{string(timestamp) + "-" + std::to_string(getpid()),
+                 host,
+                 tamarin_version};
+}
+
+LemmaHistory::LemmaHistory(const string& history_file_path) :
+  history_file_path_(history_file_path) {
+  LoadRecords();
+}
+
+void LemmaHistory::LoadRecords() {
+  if(history_file_path_.empty()) return;
+  ReadRecords();
+  auto is_kept = GetKeptRecords();
+  auto kept_records = std::count(is_kept.begin(), is_kept.end(), true);
+  if(records_.size() <= kCompactionFactor * kept_records) return;
+  // Another run that compacts or appends right now compacts next time
+  HistoryLock lock(history_file_path_, LOCK_EX | LOCK_NB);
+  if(!lock.IsLocked()) return;
+  ReadRecords();
+  Compact();
+}
+
+void LemmaHistory::ReadRecords() {
+  records_.clear();
+  record_indices_of_.clear();
+  std::ifstream history_stream{history_file_path_};
+  string line;
+  while(std::getline(history_stream, line)) {
+    auto json_record = json::parse(line, nullptr, false);
+    if(json_record.is_discarded() || !json_record.is_object()) continue;
+    IndexRecord(ToLemmaRecord(json_record));
+  }
+}
+
+vector<bool> LemmaHistory::GetKeptRecords() const {
+  vector<bool> is_kept(records_.size(), false);
+  for(const auto& [lemma_name, indices] : record_indices_of_) {
+    bool has_definitive_record = false;
+    size_t kept_records = 0;
+    for(auto index = indices.rbegin();index != indices.rend();++index) {
+      bool is_definitive = records_[*index].result != ProverResult::Unknown;
+      // Incremental mode may still skip a lemma for its latest definitive
+      // record, however old it is
+      if(kept_records < kMaxRecordsPerLemma ||
+         (is_definitive && !has_definitive_record)) {
+        is_kept[*index] = true;
+        ++kept_records;
+      }
+      has_definitive_record = has_definitive_record || is_definitive;
+    }
+  }
+  return is_kept;
+}
+
+void LemmaHistory::Compact() {
+  auto is_kept = GetKeptRecords();
+  auto records = std::move(records_);
+  records_.clear();
+  record_indices_of_.clear();
+  for(size_t index = 0;index < records.size();++index) {
+    if(is_kept[index]) IndexRecord(records[index]);
+  }
+  // Readers see either the old or the compacted file
+  auto compacted_file_path = history_file_path_ + ".compacted";
+  {
+    std::ofstream history_stream{compacted_file_path};
+    for(const auto& record : records_) {
+      history_stream << ToJson(record).dump() << "\n";
+    }
+    if(!history_stream.flush()) {
+      std::remove(compacted_file_path.c_str());
+      return;
+    }
+  }
+  std::rename(compacted_file_path.c_str(), history_file_path_.c_str());
+}
+
+void LemmaHistory::IndexRecord(const LemmaRecord& record) {
+  record_indices_of_[record.lemma_name].emplace_back(records_.size());
+  records_.emplace_back(record);
+}
+
+void LemmaHistory::AddRecord(const LemmaRecord& record) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  IndexRecord(record);
+  if(history_file_path_.empty()) return;
+  // A compaction must not replace the file while the record is appended
+  HistoryLock file_lock(history_file_path_, LOCK_SH);
+  std::ofstream history_stream{history_file_path_, std::ofstream::app};
+  history_stream << ToJson(record).dump() << "\n";
+}
+
+void LemmaHistory::AddSamples(const LemmaRecord& record,
+                              const vector<ResourceSample>& samples) {
+  if(history_file_path_.empty()) return;
+  auto json_samples = json::array();
+  for(const auto& sample : samples) {
+    json_samples.emplace_back(json{sample.time, sample.cpu_utilization,
+                                   sample.rss, sample.major_faults,
+                                   sample.read_bytes, sample.write_bytes});
+  }
+  json json_run{{"lemma", record.lemma_name},
+                {"heuristic", record.heuristic},
+                {"run_id", record.run_id},
+                {"timestamp", record.timestamp},
+                {"columns", {"time", "cpu_utilization", "rss", "major_faults",
+                             "read_bytes", "write_bytes"}},
+                {"samples", json_samples}};
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ofstream samples_stream{history_file_path_ + ".samples",
+                               std::ofstream::app};
+  samples_stream << json_run.dump() << "\n";
+}
+
+vector<LemmaRecord> LemmaHistory::GetRecords() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return records_;
+}
+
+vector<LemmaRecord> LemmaHistory::GetRecordsOfLemma(
+        const string& lemma_name) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  vector<LemmaRecord> records;
+  auto it = record_indices_of_.find(lemma_name);
+  if(it == record_indices_of_.end()) return records;
+  for(auto index : it->second) records.emplace_back(records_[index]);
+  return records;
+}
+
+std::optional<string> LemmaHistory::GetFastestHeuristic(
+        const string& lemma_name,
+        const string& theory_hash) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = record_indices_of_.find(lemma_name);
+  if(it == record_indices_of_.end()) return std::nullopt;
+  const LemmaRecord* fastest = nullptr;
+  for(auto index : it->second) {
+    const auto& record = records_[index];
+    if(!IsFastestCandidate(record, theory_hash)) continue;
+    if(fastest == nullptr || IsFaster(record, *fastest)) fastest = &record;
+  }
+  if(fastest == nullptr) return std::nullopt;
+  return fastest->heuristic;
+}
+
+std::optional<LemmaRecord> LemmaHistory::GetLatestDefinitiveRecord(
+        const string& lemma_name,
+        const string& cone_hash) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = record_indices_of_.find(lemma_name);
+  if(cone_hash.empty() || it == record_indices_of_.end()) return std::nullopt;
+  const auto& indices = it->second;
+  for(auto index = indices.rbegin();index != indices.rend();++index) {
+    const auto& record = records_[*index];
+    if(record.cone_hash == cone_hash &&
+       record.result != ProverResult::Unknown) return record;
+  }
+  return std::nullopt;
+}
+
+unordered_map<string, string> LemmaHistory::GetFastestHeuristics(
+        const string& theory_hash) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  unordered_map<string, const LemmaRecord*> fastest_record_of;
+  for(const auto& record : records_) {
+    if(!IsFastestCandidate(record, theory_hash)) continue;
+    auto& fastest = fastest_record_of[record.lemma_name];
+    if(fastest == nullptr || IsFaster(record, *fastest)) fastest = &record;
+  }
+  unordered_map<string, string> fastest_heuristic_of;
+  for(const auto& [lemma_name, record] : fastest_record_of) {
+    fastest_heuristic_of[lemma_name] = record->heuristic;
+  }
+  return fastest_heuristic_of;
+}
+
+} // namespace uttamarin
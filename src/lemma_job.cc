@@ -22,18 +22,48 @@
 
 #include "lemma_job.h"
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 using std::string;
+using std::vector;
 
 namespace uttamarin {
 
+string ToString(const TamarinHeuristic& heuristic) {
+  switch(heuristic){
+    case TamarinHeuristic::S: return "S";
+    case TamarinHeuristic::s: return "s";
+    case TamarinHeuristic::I: return "I";
+    case TamarinHeuristic::i: return "i";
+    case TamarinHeuristic::C: return "C";
+    case TamarinHeuristic::c: return "c";
+    case TamarinHeuristic::P: return "P";
+    case TamarinHeuristic::p: return "p";
+    default: return "";
+  }
+}
+
+bool IsValidHeuristic(const string& heuristic) {
+  return heuristic.find_first_not_of("SsIiCcPp") == string::npos;
+}
+
 LemmaJob::LemmaJob(string spthy_file_path,
                    string lemma_name,
-                   const TamarinHeuristic& heuristic)
+                   const string& heuristic)
                    : spthy_file_path_(spthy_file_path),
                      lemma_name_(lemma_name),
-                     heuristic_(heuristic) {
+                     heuristic_(heuristic),
+                     timeout_(-1) {
+
+}
+
+LemmaJob::LemmaJob(string spthy_file_path,
+                   string lemma_name,
+                   const TamarinHeuristic& heuristic)
+                   : LemmaJob(spthy_file_path, lemma_name,
+                              ToString(heuristic)) {
 
 }
 
@@ -53,12 +83,33 @@ void LemmaJob::SetLemmaName(const string& lemma_name) {
   lemma_name_ = lemma_name;
 }
 
-TamarinHeuristic LemmaJob::GetHeuristic() const {
+const string LemmaJob::GetHeuristic() const {
   return heuristic_;
 }
 
-void LemmaJob::SetHeuristic(TamarinHeuristic heuristic) {
+void LemmaJob::SetHeuristic(const string& heuristic) {
   heuristic_ = heuristic;
 }
 
+int LemmaJob::GetTimeout() const {
+  return timeout_;
+}
+
+void LemmaJob::SetTimeout(int timeout) {
+  timeout_ = timeout;
+}
+
+vector<LemmaJob> SelectLemmaJobs(const vector<LemmaJob>& lemma_jobs,
+                                 const vector<string>& lemma_names) {
+  if(lemma_names.empty()) return lemma_jobs;
+  vector<LemmaJob> selected_jobs;
+  for(const auto& lemma_job : lemma_jobs) {
+    if(std::find(lemma_names.begin(), lemma_names.end(),
+                 lemma_job.GetLemmaName()) != lemma_names.end()) {
+      selected_jobs.emplace_back(lemma_job);
+    }
+  }
+  return selected_jobs;
+}
+
 } // namespace uttamarin
@@ -22,10 +22,12 @@
 
 #include "lemma_name_reader.h"
 
-#include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#include "tamarin_output_parser.h"
+#include "tracing.h"
 #include "utility.h"
 
 using std::string;
@@ -33,8 +35,6 @@ using std::vector;
 
 namespace uttamarin {
 
-const string kTamarinTempfilePath = "/tmp/uttamarintemp.ut";
-
 // Takes as input a line of the Tamarin output (a line that shows the Tamarin
 // result for a particular lemma) and returns the name of the lemma.
 string ExtractLemmaName(string line) {
@@ -43,27 +43,26 @@ string ExtractLemmaName(string line) {
 }
 
 vector<string> ReadLemmaNamesFromSpthyFile(const string& spthy_file_path) {
-  string tamarin_command = "tamarin-prover "  + spthy_file_path + 
-    " 1> " + kTamarinTempfilePath + " 2> /dev/null";
+  tracing::ScopedSpan span("lemma discovery");
+  auto tamarin_output_path = CreateTempFile(".ut");
+  string tamarin_command = "tamarin-prover " + ShellQuote(spthy_file_path) +
+    " 1> " + ShellQuote(tamarin_output_path) + " 2> /dev/null";
   ExecuteShellCommand(tamarin_command);
 
-  std::ifstream tamarin_stream {kTamarinTempfilePath, std::ifstream::in};
+  std::istringstream summary_stream {
+          ReadSummarySection(tamarin_output_path).value_or("")};
   vector<string> lemma_names;
   string line;
 
-  // Move stream to begin of lemma name section
-  while(std::getline(tamarin_stream, line) && 
-        (line.size() < 5 || line.substr(0,5) != "====="));
-
-  // Read lemma names
-  while(std::getline(tamarin_stream, line) && 
+  // Read lemma names up to the end of the summary
+  while(std::getline(summary_stream, line) &&
       !(line.size() >= 5 && line.substr(0,5) == "=====")) {
-      if(line.find("steps)") == std::string::npos) continue;
+    if(line.find("steps)") == std::string::npos) continue;
     lemma_names.push_back(ExtractLemmaName(line));
   }
 
   // Remove temp file
-  std::remove(kTamarinTempfilePath.c_str());
+  std::remove(tamarin_output_path.c_str());
 
   return lemma_names;
 }
@@ -0,0 +1,127 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "lemma_processor_factory.h"
+
+#include <memory>
+#include <utility>
+
+#include "accounting_lemma_processor.h"
+#include "bash_lemma_processor.h"
+#include "batch_lemma_processor.h"
+#include "caching_lemma_processor.h"
+#include "history_lemma_processor.h"
+#include "incremental_lemma_processor.h"
+#include "metrics_lemma_processor.h"
+#include "portfolio_lemma_processor.h"
+#include "result_cache.h"
+
+using std::shared_ptr;
+using std::unique_ptr;
+
+namespace uttamarin {
+
+namespace {
+
+// Hands the jobs of one chain to a processor that several chains share
+class SharedLemmaProcessor : public LemmaProcessor {
+ public:
+  SharedLemmaProcessor(shared_ptr<LemmaProcessor> lemma_processor) :
+    lemma_processor_(lemma_processor) {
+  }
+
+ private:
+  virtual TamarinOutput DoProcessLemma(const LemmaJob& lemma_job) override {
+    return lemma_processor_->ProcessLemma(lemma_job);
+  }
+
+  shared_ptr<LemmaProcessor> lemma_processor_;
+};
+
+} // namespace
+
+unique_ptr<LemmaProcessor> CreateLemmaProcessor(
+        const CmdParameters& parameters,
+        const LemmaProcessorParts& parts,
+        shared_ptr<const TheoryIndex> theory_index,
+        shared_ptr<const TheoryIndex> base_theory_index) {
+  unique_ptr<LemmaProcessor> lemma_processor;
+  if(parts.remote_lemma_processor != nullptr) {
+    lemma_processor = std::make_unique<SharedLemmaProcessor>(
+            parts.remote_lemma_processor);
+  } else if(parameters.batch_directory != "") {
+    lemma_processor = std::make_unique<BatchLemmaProcessor>(
+            parameters.batch_directory, parameters.batch_submit_command,
+            parameters.timeout, parameters.batch_queue_grace_period);
+  } else {
+    lemma_processor = std::make_unique<BashLemmaProcessor>(
+            parameters.proof_directory, parameters.timeout,
+            parts.resource_sampler, parameters.is_gc_statistics,
+            parts.jobserver);
+  }
+
+  // Penetration mode tries the heuristics itself
+  if(parameters.is_portfolio && parameters.penetration_lemma == "") {
+    lemma_processor = std::make_unique<PortfolioLemmaProcessor>(
+            std::move(lemma_processor),
+            parameters.portfolio_slice,
+            parameters.timeout);
+  }
+
+  // The history records a portfolio as a whole, not its slices
+  if(parts.history != nullptr) {
+    lemma_processor = std::make_unique<HistoryLemmaProcessor>(
+            std::move(lemma_processor), parts.history, theory_index,
+            parts.run_info);
+  }
+
+  if(parts.accounting != nullptr) {
+    lemma_processor = std::make_unique<AccountingLemmaProcessor>(
+            std::move(lemma_processor), parts.accounting, parts.account);
+  }
+
+  if(parts.result_cache != nullptr || parts.remote_result_cache != nullptr) {
+    lemma_processor = std::make_unique<CachingLemmaProcessor>(
+            std::move(lemma_processor),
+            parts.result_cache != nullptr ? parts.result_cache :
+                                            std::make_shared<ResultCache>(),
+            parts.run_info.tamarin_version, parts.remote_result_cache,
+            parameters.proof_directory);
+  }
+
+  // Lemmas that did not change are reported with the results of the others,
+  // except in the modes that compare runs of the same lemma
+  if(parameters.is_incremental && parts.history != nullptr &&
+     parameters.penetration_lemma == "" && parameters.optimize_lemma == "") {
+    lemma_processor = std::make_unique<IncrementalLemmaProcessor>(
+            std::move(lemma_processor), theory_index, parts.history,
+            base_theory_index);
+  }
+
+  if(parts.metrics_exporter != nullptr) {
+    lemma_processor = std::make_unique<MetricsLemmaProcessor>(
+            std::move(lemma_processor), parts.metrics_exporter);
+  }
+  return lemma_processor;
+}
+
+} // namespace uttamarin
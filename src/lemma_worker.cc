@@ -0,0 +1,283 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "lemma_worker.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "nlohmann/json.hpp"
+
+#include "bash_lemma_processor.h"
+#include "jobserver.h"
+#include "lemma_job.h"
+#include "task_control.h"
+#include "tcp_socket.h"
+#include "utility.h"
+#include "worker_pool.h"
+#include "worker_protocol.h"
+
+using std::shared_ptr;
+using std::string;
+using json = nlohmann::json;
+
+namespace uttamarin {
+
+namespace {
+
+// Lemma names end up in the command line of Tamarin
+bool IsValidLemmaName(const string& lemma_name) {
+  return !lemma_name.empty() &&
+         std::all_of(lemma_name.begin(), lemma_name.end(), [](char c) {
+           return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+         });
+}
+
+// Whether the given host of a listen address only accepts connections from
+// the same machine
+bool IsLoopbackHost(const string& host) {
+  return host == "localhost" || host == "::1" ||
+         host.compare(0, 4, "127.") == 0;
+}
+
+// The connection to one coordinator: the jobs of the coordinator run on the
+// pool of the worker, which all coordinators share, and the theories live in
+// temporary files until the coordinator goes away
+class WorkerSession {
+ public:
+  WorkerSession(const CmdParameters& parameters,
+                shared_ptr<JobserverClient> jobserver,
+                shared_ptr<WorkerPool> worker_pool,
+                int input,
+                int output) :
+    lemma_processor_(parameters.proof_directory, parameters.timeout, nullptr,
+                     parameters.is_gc_statistics, jobserver),
+    worker_pool_(worker_pool),
+    input_(input),
+    output_(output),
+    unfinished_jobs_(0) {}
+
+  // Cancels the jobs that still run, waits for them and removes the
+  // theories.
+  ~WorkerSession() {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      for(auto& [id, task_control] : task_control_of_) task_control->Cancel();
+      all_jobs_finished_.wait(lock, [this] { return unfinished_jobs_ == 0; });
+    }
+    for(const auto& [hash, theory_path] : theory_path_of_) {
+      std::remove(theory_path.c_str());
+    }
+  }
+
+  // Handles the messages of the coordinator until it closes the
+  // connection. Returns false if the coordinator breaks the protocol.
+  bool Run() {
+    Send({{"type", "hello"},
+          {"slots", worker_pool_->GetNumberOfWorkers()},
+          {"tamarin_version", BashLemmaProcessor::GetTamarinVersion()}});
+    json message;
+    while(ReceiveMessage(input_, message)) {
+      // Fields of an unexpected type make the json library throw
+      try {
+        if(!HandleMessage(message)) return false;
+      } catch(const std::exception&) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  // Returns false if the message is invalid.
+  bool HandleMessage(const json& message) {
+    auto type = message.value("type", "");
+    if(type == "theory" && message.contains("hash") &&
+       message["hash"].is_string() && message.contains("contents") &&
+       message["contents"].is_string()) {
+      AddTheory(message["hash"].get<string>(),
+                message["contents"].get<string>());
+    } else if(type == "jobs" && message.contains("theory") &&
+              message["theory"].is_string() && message.contains("jobs") &&
+              message["jobs"].is_array()) {
+      auto it = theory_path_of_.find(message["theory"].get<string>());
+      if(it == theory_path_of_.end()) return false;
+      for(const auto& job : message["jobs"]) {
+        if(!job.is_object() || !job.contains("id") ||
+           !job["id"].is_number_unsigned() || !job.contains("lemma") ||
+           !job["lemma"].is_string() ||
+           !IsValidLemmaName(job["lemma"].get<string>()) ||
+           !job.value("heuristic", json("")).is_string() ||
+           !IsValidHeuristic(job.value("heuristic", "")) ||
+           !job.value("timeout", json(-1)).is_number_integer()) {
+          return false;
+        }
+        LemmaJob lemma_job(it->second, job["lemma"].get<string>(),
+                           job.value("heuristic", ""));
+        lemma_job.SetTimeout(job.value("timeout", -1));
+        StartJob(job["id"].get<uint64_t>(), lemma_job);
+      }
+    } else if(type == "cancel" && message.contains("id") &&
+              message["id"].is_number_unsigned()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = task_control_of_.find(message["id"].get<uint64_t>());
+      if(it != task_control_of_.end()) it->second->Cancel();
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  void AddTheory(const string& hash, const string& contents) {
+    if(theory_path_of_.count(hash) > 0) return;
+    auto theory_path = CreateTempFile(".spthy");
+    std::ofstream(theory_path) << contents;
+    theory_path_of_[hash] = theory_path;
+  }
+
+  void StartJob(uint64_t id, const LemmaJob& lemma_job) {
+    auto task_control = std::make_shared<TaskControl>();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      task_control_of_[id] = task_control;
+      ++unfinished_jobs_;
+    }
+    worker_pool_->Submit([this, id, lemma_job, task_control] {
+      TamarinOutput tamarin_output;
+      if(task_control->IsCancelled()) {
+        tamarin_output.result = ProverResult::Unknown;
+        tamarin_output.duration = 0;
+        tamarin_output.heuristic = lemma_job.GetHeuristic();
+        tamarin_output.failure_reason = FailureReason::Cancelled;
+      } else {
+        TaskControl::SetCurrent(task_control.get());
+        tamarin_output = lemma_processor_.ProcessLemma(lemma_job);
+        TaskControl::SetCurrent(nullptr);
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_control_of_.erase(id);
+      }
+      Send({{"type", "result"}, {"id", id},
+            {"output", ToJson(tamarin_output)}});
+      std::lock_guard<std::mutex> lock(mutex_);
+      --unfinished_jobs_;
+      all_jobs_finished_.notify_all();
+    });
+  }
+
+  void Send(const json& message) {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    SendMessage(output_, message);
+  }
+
+  BashLemmaProcessor lemma_processor_;
+  shared_ptr<WorkerPool> worker_pool_;
+  int input_;
+  int output_;
+  std::unordered_map<string, string> theory_path_of_; // by hash
+  std::unordered_map<uint64_t, shared_ptr<TaskControl>> task_control_of_;
+  int unfinished_jobs_; // of this session on the shared pool
+  std::condition_variable all_jobs_finished_;
+  std::mutex mutex_;
+  std::mutex send_mutex_;
+};
+
+} // namespace
+
+bool RunLemmaWorker(const CmdParameters& parameters,
+                    const string& listen_address) {
+  // A coordinator that goes away must not kill the worker
+  std::signal(SIGPIPE, SIG_IGN);
+  auto jobserver = JobserverClient::Connect(parameters.jobserver_path);
+  auto worker_pool = std::make_shared<WorkerPool>(parameters.jobs);
+
+  if(listen_address == "") {
+    // Everything else that the worker prints goes to the standard error, so
+    // that the standard output only carries messages
+    int output = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 0);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    bool is_valid = WorkerSession(parameters, jobserver, worker_pool,
+                                  STDIN_FILENO, output).Run();
+    if(!is_valid) {
+      std::cerr << "Error: invalid message from the coordinator."
+                << std::endl;
+    }
+    close(output);
+    return is_valid;
+  }
+
+  auto server_socket = ListenOnAddress(listen_address);
+  if(server_socket < 0) return false;
+  string host;
+  string port;
+  if(SplitAddress(listen_address, host, port) && !IsLoopbackHost(host)) {
+    std::cerr << "Warning: the worker does not authenticate coordinators, "
+              << "so anyone who can connect to '" << listen_address
+              << "' may run Tamarin on it. Listen on 127.0.0.1 behind an ssh "
+              << "tunnel unless the network is trusted." << std::endl;
+  }
+  std::cerr << "Listening on '" << listen_address << "' with "
+            << std::max(parameters.jobs, 1) << " slot(s)." << std::endl;
+  while(true) {
+    auto connection = accept4(server_socket, nullptr, nullptr, SOCK_CLOEXEC);
+    if(connection < 0) {
+      if(errno == EINTR) continue;
+      std::cerr << "Error: cannot accept connections: "
+                << std::strerror(errno) << std::endl;
+      close(server_socket);
+      return false;
+    }
+    // Every coordinator has a thread of its own, and their jobs share the
+    // slots of the worker
+    std::thread([parameters, jobserver, worker_pool, connection] {
+      if(!WorkerSession(parameters, jobserver, worker_pool, connection,
+                        connection).Run()) {
+        std::cerr << "Error: invalid message from the coordinator."
+                  << std::endl;
+      }
+      close(connection);
+    }).detach();
+  }
+}
+
+} // namespace uttamarin
@@ -26,6 +26,7 @@
 #include <memory>
 #include <string>
 
+#include "tracing.h"
 #include "ut_tamarin_config.h"
 #include "utility.h"
 
@@ -36,12 +37,8 @@ using std::vector;
 
 namespace uttamarin {
 
-const string kPreprocessedTempfilePath = "/tmp/preprocessed.spthy";
-const string kM4TempfilePath = "/tmp/temp.m4";
-
 M4TheoryPreprocessor::M4TheoryPreprocessor(
         std::shared_ptr<UtTamarinConfig> config) : config_(config) {
-  std::remove(kM4TempfilePath.c_str());
 }
 
 M4TheoryPreprocessor::~M4TheoryPreprocessor() {
@@ -51,28 +48,39 @@ M4TheoryPreprocessor::~M4TheoryPreprocessor() {
 std::string M4TheoryPreprocessor::DoPreprocessAndReturnPathToResultingFile(
                   const std::string& spthy_file_path,
                   const std::string& lemma_name) {
+  tracing::ScopedSpan span("preprocessing", lemma_name);
 
-  ofstream tempfile_m4{kM4TempfilePath};
+  auto m4_tempfile_path = CreateTempFile(".m4");
+  auto preprocessed_file_path = CreateTempFile(".spthy");
 
-  // Change quotes for M4, otherwise single quotes in spthy file lead to M4 bugs
-  tempfile_m4 << "changequote(<!,!>)" << std::endl;
-  tempfile_m4 << "changecom(<!/*!>, <!*/!>)" << std::endl;
+  {
+    tracing::ScopedSpan write_span("write m4 input");
+    ofstream tempfile_m4{m4_tempfile_path};
 
-  for(auto m4_command : GetM4Commands(lemma_name)) {
-    tempfile_m4 << m4_command << std::endl;
-  }
+    // Change quotes for M4, otherwise single quotes in spthy file lead to M4
+    // bugs
+    tempfile_m4 << "changequote(<!,!>)" << std::endl;
+    tempfile_m4 << "changecom(<!/*!>, <!*/!>)" << std::endl;
+
+    for(auto m4_command : GetM4Commands(lemma_name)) {
+      tempfile_m4 << m4_command << std::endl;
+    }
 
-  ifstream spthy_file{spthy_file_path};
-  string spthy_file_line = "";
-  while(std::getline(spthy_file, spthy_file_line))
-    tempfile_m4 << spthy_file_line << std::endl;
+    ifstream spthy_file{spthy_file_path};
+    string spthy_file_line = "";
+    while(std::getline(spthy_file, spthy_file_line))
+      tempfile_m4 << spthy_file_line << std::endl;
+  }
 
-  ExecuteShellCommand("m4 " + kM4TempfilePath + " > " +
-                      kPreprocessedTempfilePath);
+  {
+    tracing::ScopedSpan m4_span("m4");
+    ExecuteShellCommand("m4 " + ShellQuote(m4_tempfile_path) + " > " +
+                        ShellQuote(preprocessed_file_path));
+  }
 
-  std::remove(kM4TempfilePath.c_str());
+  std::remove(m4_tempfile_path.c_str());
 
-  return kPreprocessedTempfilePath;
+  return preprocessed_file_path;
 }
 
 vector<string> M4TheoryPreprocessor::GetM4Commands(const string& lemma_name) {
@@ -20,37 +20,140 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "cli11/CLI11.hpp"
+#include "nlohmann/json.hpp"
 
 #include "app.h"
 #include "bash_lemma_processor.h"
 #include "cmd_parameters.h"
+#include "dashboard.h"
 #include "default_lemma_job_generator.h"
+#include "fact_annotation_optimizer.h"
+#include "fair_share_scheduler.h"
+#include "heuristic_bandit.h"
+#include "job_server.h"
+#include "jobserver.h"
+#include "json_lines_reporter.h"
+#include "junit_reporter.h"
+#include "lemma_history.h"
+#include "lemma_job.h"
+#include "lemma_name_reader.h"
+#include "lemma_processor_factory.h"
+#include "lemma_worker.h"
 #include "m4_theory_preprocessor.h"
+#include "metrics_exporter.h"
 #include "output_writer.h"
 #include "penetration_lemma_job_generator.h"
+#include "phase_report.h"
+#include "regression_report.h"
+#include "remote_lemma_processor.h"
+#include "remote_result_cache.h"
+#include "resource_sampler.h"
 #include "terminator.h"
+#include "theory_index.h"
+#include "theory_watcher.h"
+#include "tracing.h"
+#include "utility.h"
 #include "ut_tamarin_config.h"
-#include "verbose_lemma_processor.h"
 
 using namespace uttamarin;
 
+// Sampling interval in milliseconds for the CPU and memory of the dashboard
+const int kDashboardSampleInterval = 1000;
+
+// Number of lemma jobs that are submitted to a batch system at a time,
+// unless -j is given
+const int kBatchJobs = 256;
+
 std::unique_ptr<LemmaJobGenerator> CreateLemmaJobGenerator(
         const CmdParameters& parameters,
-        std::shared_ptr<UtTamarinConfig> config) {
+        std::shared_ptr<UtTamarinConfig> config,
+        std::shared_ptr<LemmaHistory> history,
+        std::shared_ptr<const TheoryIndex> theory_index) {
   if(parameters.penetration_lemma != ""){
     return std::make_unique<PenetrationLemmaJobGenerator>(
             parameters.spthy_file_path,
-            parameters.penetration_lemma);
+            parameters.penetration_lemma,
+            history,
+            theory_index);
   }
   return std::make_unique<DefaultLemmaJobGenerator>(parameters.spthy_file_path,
                                                     parameters.starting_lemma,
-                                                    config);
+                                                    config,
+                                                    history,
+                                                    theory_index);
+}
+
+// Returns the absolute path of the given file, which a server with another
+// working directory can open as well
+std::string GetAbsolutePath(const std::string& file_path) {
+  if(file_path == "") return file_path;
+  char* absolute_path = realpath(file_path.c_str(), nullptr);
+  if(absolute_path == nullptr) return file_path;
+  std::string result = absolute_path;
+  std::free(absolute_path);
+  return result;
+}
+
+// Submits the run (or, if 'is_accounting_report' is set, a request for the
+// accounting report) to the server on the given socket instead of running
+// Tamarin locally and prints the report of the server
+int SubmitToServer(const CmdParameters& parameters,
+                   const std::string& socket_path,
+                   bool is_accounting_report) {
+  // Ctrl+C stops the client, which closes the connection, and the server
+  // then cancels the run
+  std::signal(SIGINT, SIG_DFL);
+  std::vector<std::ostream*> output_streams = std::vector{&std::cout};
+  std::ofstream output_file_stream;
+  if(parameters.output_file_path != "") {
+    output_file_stream.open(parameters.output_file_path);
+    output_streams.emplace_back(&output_file_stream);
+  }
+  OutputWriter output_writer(output_streams);
+  if(is_accounting_report) {
+    return SubmitJobRequest(socket_path, {{"type", "accounting"}},
+                            output_writer);
+  }
+  nlohmann::json request{
+          {"theory", GetAbsolutePath(parameters.spthy_file_path)},
+          {"config", GetAbsolutePath(parameters.config_file_path)},
+          {"start", parameters.starting_lemma},
+          {"lemmas", parameters.lemmas},
+          {"timeout", parameters.timeout},
+          {"abort_after_failure", parameters.abort_after_failure},
+          {"ordered_output", parameters.is_ordered_output},
+          {"tenant", parameters.tenant},
+          {"priority", parameters.priority}};
+  return SubmitJobRequest(socket_path, request, output_writer);
+}
+
+// Prints and/or writes the phase breakdown of the run if requested
+void ReportPhases(const CmdParameters& parameters,
+                  OutputWriter& output_writer) {
+  if(!parameters.is_phase_report && parameters.phase_report_path == "") {
+    return;
+  }
+  auto breakdown = ComputePhaseBreakdown(parameters.jobs);
+  if(parameters.is_phase_report) {
+    PrintPhaseBreakdown(breakdown, output_writer);
+  }
+  if(parameters.phase_report_path != "") {
+    WritePhaseBreakdown(breakdown, parameters.phase_report_path);
+  }
 }
 
 int main (int argc, char *argv[])
@@ -67,7 +170,207 @@ int main (int argc, char *argv[])
   parameters.spthy_file_path = "";
   cli.add_option("spthy_file", parameters.spthy_file_path,
                  "Path to a .spthy file containing a Tamarin theory."
-  )->required()->check(CLI::ExistingFile);
+  )->check(CLI::ExistingFile);
+
+  auto serve_command = cli.add_subcommand(
+          "serve",
+          "Runs UT Tamarin as a server that accepts runs of clients (see "
+          "--server) on a Unix domain socket. The server keeps theory "
+          "indices, discovered lemmas, the history and the results of "
+          "earlier runs between runs, and runs the lemmas of all clients on "
+          "one pool of workers (see -j), which is shared fairly between "
+          "the tenants of the runs (see --tenant). The options -j, -p, "
+          "--history_file, --gc_statistics and --sample_interval configure "
+          "the server.");
+  serve_command->fallthrough();
+  std::string socket_path = GetDefaultSocketPath();
+  serve_command->add_option("--socket", socket_path,
+                            "Socket on which the server listens (default: " +
+                            socket_path + ").");
+
+  parameters.is_shared_server = false;
+  serve_command->add_flag(
+          "--shared", parameters.is_shared_server,
+          "Lets all users of the host connect to the socket (by default, only "
+          "the user of the server may). The server only reads the files "
+          "that the user of a client may read, but it preprocesses theories "
+          "with m4 as its own user, so only share it with trusted users.");
+
+  parameters.tenants_file_path = "";
+  serve_command->add_option(
+          "--tenants", parameters.tenants_file_path,
+          "JSON file with the weight, the maximum number of cores and the "
+          "maximum memory (in MB) of each tenant (the user of a client), "
+          "and whether it may run interactive lemmas, e.g., {\"default\": "
+          "{\"weight\": 1}, \"tenants\": {\"ci\": {\"weight\": 1, "
+          "\"max_cores\": 4, \"max_memory\": 16384, \"interactive\": "
+          "false}}}."
+  )->check(CLI::ExistingFile);
+
+  parameters.accounting_file_path = "";
+  serve_command->add_option(
+          "--accounting_file", parameters.accounting_file_path,
+          "File in which the server accounts the CPU and wall-clock time of "
+          "every job per tenant (one JSON object per line), so that the "
+          "accounting report (see --accounting_report) survives restarts.");
+
+  auto jobserver_command = cli.add_subcommand(
+          "jobserver",
+          "Runs a host-wide jobserver that limits the number of Tamarin "
+          "processes of all UT Tamarin instances that use it (see "
+          "--jobserver) to the given number of slots. GNU make 4.4 or "
+          "later shares the slots as well (with the printed MAKEFLAGS).");
+  int jobserver_slots = std::max(1U, std::thread::hardware_concurrency());
+  jobserver_command->add_option("--slots", jobserver_slots,
+                                "Number of slots (default: the number of "
+                                "cores).")
+  ->check(CLI::Range(1, 4096));
+  std::string jobserver_fifo_path = GetDefaultJobserverPath();
+  jobserver_command->add_option("--fifo", jobserver_fifo_path,
+                                "FIFO of the jobserver (default: " +
+                                jobserver_fifo_path + ").");
+
+  auto worker_command = cli.add_subcommand(
+          "worker",
+          "Runs lemma jobs for a coordinator (see --worker), possibly on "
+          "another machine, and streams the results back. The worker talks "
+          "to the coordinator over its standard input and output, unless "
+          "it listens on a TCP address (see --listen). The options -j "
+          "(default: the number of cores), -p, --gc_statistics and "
+          "--jobserver configure the worker.");
+  worker_command->fallthrough();
+  std::string worker_listen_address = "";
+  worker_command->add_option("--listen", worker_listen_address,
+                             "TCP address HOST:PORT (e.g., 127.0.0.1:7300) "
+                             "on which the worker accepts coordinators, "
+                             "which share its slots. There is no "
+                             "authentication: anyone who can connect may "
+                             "run Tamarin on the worker, so listen on the "
+                             "loopback interface and reach it through an "
+                             "ssh tunnel, or only on a trusted network.");
+
+  cli.add_option("--worker", parameters.workers,
+                 "Runs the lemmas on the given worker (see 'uttamarin "
+                 "worker') instead of locally (can be given several times): "
+                 "either a command that starts a worker, e.g., \"ssh prover2 "
+                 "uttamarin worker\", or the address HOST:PORT of a listening "
+                 "worker. Jobs are balanced between the workers, and the jobs "
+                 "of lost workers are retried on the others. -j defaults to "
+                 "the slots of all workers.");
+
+  parameters.batch_directory = "";
+  cli.add_option("--batch_dir", parameters.batch_directory,
+                 "Runs the lemmas on a cluster through its batch system "
+                 "instead of locally: the theories are staged in the given "
+                 "directory, which the nodes of the cluster must share, and "
+                 "the lemmas that are ready to run are submitted as one job "
+                 "array (see --batch_submit), whose results are collected "
+                 "from the directory. -j defaults to " +
+                 std::to_string(kBatchJobs) + "."
+  )->check(CLI::ExistingDirectory);
+
+  parameters.batch_submit_command = "sbatch --array=0-{last} {script}";
+  cli.add_option("--batch_submit", parameters.batch_submit_command,
+                 "Command that submits the array script {script} with the "
+                 "jobs 0 to {last} ({size} jobs) to the batch system "
+                 "(default: " + parameters.batch_submit_command + "). Array "
+                 "tasks find their index in $SLURM_ARRAY_TASK_ID, "
+                 "$PBS_ARRAY_INDEX or $UTTAMARIN_ARRAY_INDEX.");
+
+  parameters.batch_queue_grace_period = 6 * 3600;
+  cli.add_option("--batch_queue_grace", parameters.batch_queue_grace_period,
+                 "Seconds that a lemma may wait in the queue of the batch "
+                 "system (see --batch_dir) on top of its timeout before it "
+                 "fails as a lost array task (default: " +
+                 std::to_string(parameters.batch_queue_grace_period) + ")."
+  )->check(CLI::Range(0, 30 * 24 * 3600));
+
+  auto cache_server_command = cli.add_subcommand(
+          "cache_server",
+          "Runs a minimal HTTP server for the remote result cache (see "
+          "--remote_cache), which stores the results and proofs in a "
+          "directory.");
+  std::string cache_listen_address = "127.0.0.1:7400";
+  cache_server_command->add_option("--listen", cache_listen_address,
+                                   "TCP address HOST:PORT on which the "
+                                   "server listens (default: " +
+                                   cache_listen_address + "). Anyone who "
+                                   "can connect may read the results.");
+  std::string cache_directory = ".uttamarin_cache";
+  cache_server_command->add_option("--dir", cache_directory,
+                                   "Directory of the results and proofs "
+                                   "(default: " + cache_directory + ").");
+  std::string cache_token_file_path = "";
+  cache_server_command->add_option("--token_file", cache_token_file_path,
+                                   "File with the token that clients need "
+                                   "to store results (see "
+                                   "--remote_cache_token). Without it, the "
+                                   "cache is read-only."
+  )->check(CLI::ExistingFile);
+
+  parameters.remote_cache_url = "";
+  cli.add_option("--remote_cache", parameters.remote_cache_url,
+                 "Takes the results of lemmas whose preprocessed theory, "
+                 "heuristic and Tamarin version did not change from the "
+                 "given remote result cache (e.g., http://cache:7400, see "
+                 "'uttamarin cache_server'). With --remote_cache_token, "
+                 "also stores new definitive results and their proofs (see "
+                 "-p) there."
+  )->check([](const std::string& url) -> std::string {
+    return RemoteResultCache(url).IsValid() ?
+           "" : "The remote cache must be a URL http://HOST[:PORT][/PATH]";
+  });
+
+  std::string remote_cache_token_file_path = "";
+  cli.add_option("--remote_cache_token", remote_cache_token_file_path,
+                 "File with the write token of the remote result cache (see "
+                 "--remote_cache), e.g., a secret of the CI. Only runs with "
+                 "the token store results, since every stored result is "
+                 "trusted by all readers."
+  )->check(CLI::ExistingFile);
+
+  bool is_remote_cache_read_only = false;
+  cli.add_flag("--remote_cache_read_only", is_remote_cache_read_only,
+               "Stores no results in the remote result cache, even with "
+               "--remote_cache_token (the default without a token).");
+
+  parameters.jobserver_path = "";
+  cli.add_option("--jobserver", parameters.jobserver_path,
+                 "Takes a slot of the host-wide jobserver (see 'uttamarin "
+                 "jobserver') with the given FIFO (e.g., " +
+                 GetDefaultJobserverPath() + ") for every Tamarin run. "
+                 "Without this option, UT Tamarin takes the slots from the "
+                 "jobserver of GNU make if it runs in a recipe of "
+                 "'make -jN' (see MAKEFLAGS).");
+
+  std::string server_socket_path = "";
+  cli.add_option("--server", server_socket_path,
+                 "Submits the run to the server (see 'uttamarin serve') "
+                 "listening on the given socket and prints its report "
+                 "instead of running Tamarin locally. The options -a, -c, "
+                 "-o, -s, -t, --lemma, --ordered_output, --tenant and "
+                 "--priority apply to the run.");
+
+  parameters.tenant = "";
+  cli.add_option("--tenant", parameters.tenant,
+                 "Project to which the server (see --server) charges the "
+                 "run within the accounts of the current user, who is the "
+                 "tenant of the run (default: no project).");
+
+  parameters.priority = "batch";
+  cli.add_option("--priority", parameters.priority,
+                 "Priority of the run on the server (see --server): the "
+                 "lemmas of 'interactive' runs start before those of "
+                 "'batch' runs (default: batch)."
+  )->check([](const std::string& priority) -> std::string {
+    return ToJobPriority(priority).has_value() ?
+           "" : "Priority must be 'interactive' or 'batch'";
+  });
+
+  bool is_accounting_report = false;
+  cli.add_flag("--accounting_report", is_accounting_report,
+               "Prints the jobs, CPU hours and wall-clock hours that each "
+               "tenant used on the server (see --server) and exits.");
 
   parameters.abort_after_failure = true;
   cli.add_flag("-a,--abort_after_failure",
@@ -77,7 +380,7 @@ int main (int argc, char *argv[])
   parameters.is_quiet = false;
   cli.add_flag("-q,--quiet",
                parameters.is_quiet,
-               "Disables the timer on the command line.");
+               "Disables the live dashboard on the command line.");
 
   parameters.config_file_path = "";
   cli.add_option("-c,--config_file", parameters.config_file_path,
@@ -96,28 +399,361 @@ int main (int argc, char *argv[])
   cli.add_option("--penetration_lemma", parameters.penetration_lemma,
                  "Lemma to penetrate.");
 
+  parameters.optimize_lemma = "";
+  cli.add_option("--optimize_lemma", parameters.optimize_lemma,
+                 "Lemma whose fact annotations should be optimized. The "
+                 "fastest annotations are stored in the config file.");
+
+  parameters.optimize_budget = 3600;
+  cli.add_option("--optimize_budget", parameters.optimize_budget,
+                 "Time budget in seconds for optimizing fact annotations "
+                 "(default: 3600 seconds)."
+  )->check(CLI::Range(1, 1000000));
+
   parameters.starting_lemma = "";
   cli.add_option("-s,--start", parameters.starting_lemma,
                  "Name of the first lemma that should be verified.");
 
+  cli.add_option("--lemma", parameters.lemmas,
+                 "Only verifies the given lemma (can be given several "
+                 "times).");
+
+  parameters.history_file_path = ".uttamarin_history.jsonl";
+  cli.add_option("--history_file", parameters.history_file_path,
+                 "File in which the results of all runs are stored "
+                 "(default: .uttamarin_history.jsonl).");
+
+  bool no_history = false;
+  cli.add_flag("--no_history", no_history,
+               "Neither reads nor writes the history of past runs.");
+
+  parameters.export_heuristics_path = "";
+  cli.add_option("--export_heuristics", parameters.export_heuristics_path,
+                 "Writes the fastest heuristic of each lemma (according to "
+                 "the history) into the section 'lemma_heuristics' of the "
+                 "given JSON file, keeping the entries of other lemmas, and "
+                 "exits.");
+
+  bool print_bandit_report = false;
+  cli.add_flag("--bandit_report", print_bandit_report,
+               "Compares the heuristic order learned from the history with "
+               "the fixed penetration order and exits.");
+
+  parameters.is_incremental = false;
+  cli.add_flag("--incremental", parameters.is_incremental,
+               "Only runs Tamarin on lemmas whose dependencies (the rules "
+               "they can depend on, restrictions, equations, reused lemmas) "
+               "changed since they were last verified according to the "
+               "history. The others are reported with their last proof and "
+               "marked as unchanged. The dependencies are determined "
+               "syntactically, so this is a heuristic, not a guarantee.");
+
+  parameters.incremental_base = "";
+  cli.add_option("--incremental_base", parameters.incremental_base,
+                 "Git revision (e.g., HEAD~1) to compare the theory with in "
+                 "incremental mode: lemmas whose dependencies changed since "
+                 "this revision are run even if the history has a proof for "
+                 "them. Implies --incremental.");
+
+  parameters.regression_threshold = 0;
+  cli.add_option("--regression_threshold", parameters.regression_threshold,
+                 "Reports lemmas whose wall-clock time or number of steps "
+                 "exceeds that of earlier runs in the history by more than "
+                 "the given percentage (e.g., 20), or that lost their "
+                 "definitive result."
+  )->check(CLI::Range(0.0, 1000000.0));
+
+  parameters.fail_on_regression = false;
+  cli.add_flag("--fail_on_regression", parameters.fail_on_regression,
+               "Exits with status 1 if the regression report (see "
+               "--regression_threshold) finds a regression.");
+
+  parameters.trace_file_path = "";
+  cli.add_option("--trace_file", parameters.trace_file_path,
+                 "Records a timeline of the run (lemma discovery, "
+                 "preprocessing, Tamarin runs, ...) with one track per "
+                 "worker and writes it to the given file as JSON, which "
+                 "chrome://tracing and Perfetto can load.");
+
+  parameters.is_phase_report = false;
+  cli.add_flag("--phase_report", parameters.is_phase_report,
+               "Prints how the time of the run splits into Tamarin and the "
+               "overhead of UT Tamarin (per phase), as well as the parallel "
+               "efficiency of the workers.");
+
+  parameters.phase_report_path = "";
+  cli.add_option("--phase_report_json", parameters.phase_report_path,
+                 "Writes the phase breakdown (see --phase_report) as JSON to "
+                 "the given file.");
+
+  parameters.sample_interval = 0;
+  cli.add_option("--sample_interval", parameters.sample_interval,
+                 "Samples the CPU utilization, memory, major faults and I/O "
+                 "of every Tamarin run at the given interval in milliseconds "
+                 "(e.g., 250) and stores the samples in the samples file next "
+                 "to the history file and in the trace (0 means no sampling, "
+                 "default: 0)."
+  )->check(CLI::Range(0, 3600000));
+
+  parameters.is_ordered_output = false;
+  cli.add_flag("--ordered_output", parameters.is_ordered_output,
+               "Prints the results of the lemmas in the order of the lemmas "
+               "in the theory instead of the order in which they finish, so "
+               "that parallel runs (see -j) print the same report as "
+               "sequential ones.");
+
+  parameters.is_watch = false;
+  cli.add_flag("--watch", parameters.is_watch,
+               "Keeps running and verifies the lemmas again whenever the "
+               "theory, the files it includes or the config file change. "
+               "Only lemmas whose dependencies (see --incremental) changed "
+               "run again (first), stale Tamarin runs are cancelled.");
+
+  parameters.json_report_path = "";
+  cli.add_option("--json_report", parameters.json_report_path,
+                 "Writes an event per start and result of a lemma job (with "
+                 "all timing and resource fields) to the given file as JSON "
+                 "Lines while the run progresses.");
+
+  parameters.junit_report_path = "";
+  cli.add_option("--junit_report", parameters.junit_report_path,
+                 "Writes the results as a JUnit XML report to the given file, "
+                 "updated after every lemma.");
+
+  parameters.metrics_file_path = "";
+  cli.add_option("--metrics_file", parameters.metrics_file_path,
+                 "Keeps the progress and results of the run (lemmas queued, "
+                 "running and done, results, durations, worker utilization, "
+                 "memory) up to date in the given file in the Prometheus "
+                 "text format (e.g., for the textfile collector of the node "
+                 "exporter, which requires the suffix .prom).");
+
+  parameters.is_gc_statistics = false;
+  cli.add_flag("--gc_statistics", parameters.is_gc_statistics,
+               "Collects the statistics of Tamarin's GHC runtime (bytes "
+               "allocated, maximum residency, GC time, productivity) for "
+               "every lemma, stores them in the history and summarizes them "
+               "after the results.");
+
   parameters.timeout = 600;
   cli.add_option("-t,--timeout", parameters.timeout,
                  "Per-lemma timeout in seconds "
                  "(0 means no timeout, default: 600 seconds).");
 
+  parameters.jobs = 1;
+  auto jobs_option = cli.add_option(
+          "-j,--jobs", parameters.jobs,
+          "Number of Tamarin instances that run in parallel (default: 1, "
+          "or the jobs of make or the number of cores if there is a "
+          "jobserver, see --jobserver)."
+  )->check(CLI::Range(1, 1024));
+
+  parameters.is_portfolio = false;
+  cli.add_flag("--portfolio", parameters.is_portfolio,
+               "Runs each lemma as a portfolio of heuristics on a single "
+               "core, restarting Tamarin with every heuristic in time slices "
+               "that grow according to the Luby sequence. The timeout is the "
+               "overall time budget per lemma.");
+
+  parameters.portfolio_slice = 2;
+  cli.add_option("--portfolio_slice", parameters.portfolio_slice,
+                 "Base time slice of the portfolio in seconds (default: 2).")
+  ->check(CLI::Range(1, 3600));
+
+  parameters.heuristic_length = 1;
+  cli.add_option("--heuristic_length", parameters.heuristic_length,
+                 "Maximum length of the heuristic strings (e.g., 'CsI') that "
+                 "penetration mode tries (default: 1). The best heuristic is "
+                 "stored in the config file."
+  )->check(CLI::Range(1, 1024));
+
   CLI11_PARSE(cli, argc, argv);
 
-  auto config = std::make_shared<UtTamarinConfig>(parameters);
+  if(no_history) parameters.history_file_path = "";
+  if(parameters.incremental_base != "") parameters.is_incremental = true;
+
+  if(jobserver_command->parsed()) {
+    return RunJobserver(jobserver_fifo_path, jobserver_slots) ? 0 : 1;
+  }
+  // With a jobserver, the jobserver limits the number of Tamarin runs
+  if(jobs_option->count() == 0) {
+    auto make_jobs = JobserverClient::GetMakeJobs();
+    if(make_jobs.has_value()) {
+      parameters.jobs = std::clamp(make_jobs.value(), 1, 1024);
+    } else if(parameters.jobserver_path != "") {
+      parameters.jobs = jobserver_slots;
+    } else if(worker_command->parsed()) {
+      parameters.jobs = std::max(1U, std::thread::hardware_concurrency());
+    }
+  }
+
+  if(worker_command->parsed()) {
+    return RunLemmaWorker(parameters, worker_listen_address) ? 0 : 1;
+  }
+  for(const auto& token_file_path : {cache_token_file_path,
+                                      remote_cache_token_file_path}) {
+    if(token_file_path != "" && !ReadCacheToken(token_file_path)) {
+      std::cerr << "Error: the token file '" << token_file_path
+                << "' must contain a single line." << std::endl;
+      return 1;
+    }
+  }
+  if(remote_cache_token_file_path != "" && !is_remote_cache_read_only) {
+    parameters.remote_cache_token =
+            ReadCacheToken(remote_cache_token_file_path).value();
+  }
+  if(cache_server_command->parsed()) {
+    return RunCacheServer(cache_listen_address, cache_directory,
+                          ReadCacheToken(cache_token_file_path)
+                                  .value_or("")) ? 0 : 1;
+  }
+
+  if(serve_command->parsed()) {
+    JobServer job_server(socket_path, parameters);
+    return job_server.Run() ? 0 : 1;
+  }
+  if(parameters.spthy_file_path == "" && !is_accounting_report) {
+    std::cerr << "Error: spthy_file is required." << std::endl
+              << "Run with --help for more information." << std::endl;
+    return 1;
+  }
+  if(server_socket_path != "") {
+    return SubmitToServer(parameters, server_socket_path,
+                          is_accounting_report);
+  }
+  if(is_accounting_report) {
+    std::cerr << "Error: the accounting report requires a server "
+              << "(--server)." << std::endl;
+    return 1;
+  }
+  if(parameters.is_watch && (parameters.penetration_lemma != "" ||
+                             parameters.optimize_lemma != "")) {
+    std::cerr << "Error: watch mode cannot be combined with penetration "
+              << "mode or the optimization of annotations." << std::endl;
+    return 1;
+  }
+  if(!parameters.workers.empty() && parameters.batch_directory != "") {
+    std::cerr << "Error: lemmas run either on workers (--worker) or on a "
+              << "batch system (--batch_dir)." << std::endl;
+    return 1;
+  }
+  if(parameters.batch_directory != "" && jobs_option->count() == 0) {
+    parameters.jobs = kBatchJobs;
+  }
+
+  std::shared_ptr<RemoteLemmaProcessor> remote_lemma_processor;
+  if(!parameters.workers.empty()) {
+    remote_lemma_processor = std::make_shared<RemoteLemmaProcessor>(
+            parameters.workers, parameters.timeout);
+    if(remote_lemma_processor->GetNumberOfSlots() == 0) {
+      std::cerr << "Error: none of the workers can be reached." << std::endl;
+      return 1;
+    }
+    if(jobs_option->count() == 0) {
+      parameters.jobs = std::min(remote_lemma_processor->GetNumberOfSlots(),
+                                 1024);
+    }
+  }
+
+  if(parameters.trace_file_path != "") {
+    tracing::Start(parameters.trace_file_path);
+  }
+  if(parameters.is_phase_report || parameters.phase_report_path != "") {
+    tracing::EnableStatistics();
+  }
+
+  std::shared_ptr<UtTamarinConfig> config;
+  {
+    tracing::ScopedSpan span("config parsing");
+    config = std::make_shared<UtTamarinConfig>(parameters);
+  }
+  std::shared_ptr<LemmaHistory> history;
+  if(!parameters.history_file_path.empty()) {
+    tracing::ScopedSpan span("history loading");
+    history = std::make_shared<LemmaHistory>(parameters.history_file_path);
+  }
+  std::shared_ptr<const TheoryIndex> theory_index;
+  {
+    tracing::ScopedSpan span("theory indexing");
+    theory_index =
+          std::make_shared<const TheoryIndex>(parameters.spthy_file_path);
+  }
 
-  std::unique_ptr<LemmaProcessor> lemma_processor =
-          std::make_unique<BashLemmaProcessor>(parameters.proof_directory,
-                                               parameters.timeout);
+  std::shared_ptr<const TheoryIndex> base_theory_index = nullptr;
+  if(parameters.incremental_base != "") {
+    auto base_theory_text = ReadFileAtGitRevision(parameters.spthy_file_path,
+                                                  parameters.incremental_base);
+    if(!base_theory_text.has_value()) {
+      std::cerr << "Error: cannot read '" << parameters.spthy_file_path
+                << "' at git revision '" << parameters.incremental_base
+                << "'." << std::endl;
+      return 1;
+    }
+    base_theory_index = std::make_shared<const TheoryIndex>(
+            TheoryIndex::FromTheoryText(
+                    base_theory_text.value(), parameters.spthy_file_path,
+                    [&parameters](const std::string& file_path) {
+                      return ReadFileAtGitRevision(
+                              file_path, parameters.incremental_base);
+                    }));
+  }
+  if(parameters.is_incremental && history == nullptr) {
+    std::cerr << "Error: incremental mode requires a history file, which "
+              << "knows the lemmas that were verified." << std::endl;
+    return 1;
+  }
 
-  if(!parameters.is_quiet) {
-    lemma_processor =
-          std::make_unique<VerboseLemmaProcessor>(std::move(lemma_processor));
+  if(parameters.export_heuristics_path != "") {
+    if(history == nullptr) {
+      std::cerr << "Error: exporting heuristics requires a history file."
+                << std::endl;
+      return 1;
+    }
+    UtTamarinConfig::WriteLemmaHeuristics(
+            parameters.export_heuristics_path,
+            history->GetFastestHeuristics(theory_index->GetTheoryHash()));
+    return 0;
   }
 
+  // The live dashboard needs a terminal, otherwise the output stays plain
+  bool is_dashboard = !parameters.is_quiet && isatty(STDOUT_FILENO);
+  std::shared_ptr<ResourceSampler> resource_sampler;
+  if(parameters.sample_interval > 0) {
+    resource_sampler =
+            std::make_shared<ResourceSampler>(parameters.sample_interval);
+  } else if(is_dashboard) {
+    resource_sampler = std::make_shared<ResourceSampler>(
+            kDashboardSampleInterval, false);
+  }
+  LemmaProcessorParts lemma_processor_parts;
+  lemma_processor_parts.remote_lemma_processor = remote_lemma_processor;
+  lemma_processor_parts.history = history;
+  lemma_processor_parts.resource_sampler = resource_sampler;
+  lemma_processor_parts.jobserver =
+          JobserverClient::Connect(parameters.jobserver_path);
+  if(parameters.remote_cache_url != "") {
+    lemma_processor_parts.remote_result_cache =
+            std::make_shared<RemoteResultCache>(
+                    parameters.remote_cache_url,
+                    parameters.remote_cache_token);
+  }
+  std::shared_ptr<MetricsExporter> metrics_exporter;
+  if(parameters.metrics_file_path != "") {
+    metrics_exporter = std::make_shared<MetricsExporter>(
+            parameters.metrics_file_path, parameters.jobs);
+    lemma_processor_parts.metrics_exporter = metrics_exporter;
+  }
+  auto run_info = CreateRunInfo("");
+  if(remote_lemma_processor != nullptr) {
+    run_info.tamarin_version = remote_lemma_processor->GetTamarinVersion();
+  } else if(history != nullptr || parameters.remote_cache_url != "") {
+    run_info.tamarin_version = BashLemmaProcessor::GetTamarinVersion();
+  }
+  lemma_processor_parts.run_info = run_info;
+  auto lemma_processor = CreateLemmaProcessor(parameters,
+                                              lemma_processor_parts,
+                                              theory_index, base_theory_index);
+
   auto theory_preprocessor = std::make_unique<M4TheoryPreprocessor>(config);
 
   std::vector<std::ostream*> output_streams = std::vector{&std::cout};
@@ -126,16 +762,105 @@ int main (int argc, char *argv[])
     output_file_stream.open(parameters.output_file_path);
     output_streams.emplace_back(&output_file_stream);
   }
-  auto output_writer = std::make_shared<OutputWriter>(output_streams);
+  auto output_writer = std::make_shared<OutputWriter>(
+          output_streams,
+          parameters.is_ordered_output ? OutputOrder::File :
+                                         OutputOrder::Completion);
+  if(parameters.json_report_path != "") {
+    output_writer->AddReporter(
+            std::make_unique<JsonLinesReporter>(parameters.json_report_path));
+  }
+  if(parameters.junit_report_path != "") {
+    output_writer->AddReporter(
+            std::make_unique<JUnitReporter>(parameters.junit_report_path));
+  }
+
+  if(print_bandit_report) {
+    PrintBanditReport(history != nullptr ? history->GetRecords() :
+                                           std::vector<LemmaRecord>{},
+                      *output_writer);
+    return 0;
+  }
+
+  if(parameters.optimize_lemma != "") {
+    auto lemma_name = GetStringWithShortestEditDistance(
+            ReadLemmaNamesFromSpthyFile(parameters.spthy_file_path),
+            parameters.optimize_lemma);
+    FactAnnotationOptimizer optimizer(std::move(lemma_processor), config,
+                                      theory_index, output_writer);
+    auto annotations = optimizer.Optimize(
+            LemmaJob(parameters.spthy_file_path, lemma_name,
+                     config->GetLemmaHeuristic(lemma_name)),
+            parameters.optimize_budget);
+    if(parameters.config_file_path != "") {
+      UtTamarinConfig::WriteLemmaAnnotations(parameters.config_file_path,
+                                             lemma_name, annotations);
+    }
+    return 0;
+  }
+
+  std::shared_ptr<Dashboard> dashboard;
+  if(is_dashboard) {
+    dashboard = std::make_shared<Dashboard>(parameters.jobs, resource_sampler,
+                                            history);
+    output_writer->AddReporter(dashboard);
+    output_writer->SetStatusProvider([dashboard] {
+      return dashboard->GetStatusLines();
+    });
+  }
+
+  if(parameters.is_watch) {
+    TheoryWatcher theory_watcher(parameters, lemma_processor_parts,
+                                 output_writer, dashboard);
+    return theory_watcher.Run() ? 0 : 1;
+  }
 
   App app (std::move(lemma_processor),
            std::move(theory_preprocessor),
            config,
            output_writer);
 
-  auto lemma_job_generator = CreateLemmaJobGenerator(parameters, config);
+  auto lemma_job_generator = CreateLemmaJobGenerator(parameters, config,
+                                                     history, theory_index);
+
+  auto lemma_jobs = SelectLemmaJobs(lemma_job_generator->GenerateLemmaJobs(),
+                                    parameters.lemmas);
+  if(metrics_exporter) metrics_exporter->AddQueuedLemmas(lemma_jobs.size());
+  if(dashboard) {
+    std::vector<std::string> lemma_names;
+    for(const auto& lemma_job : lemma_jobs) {
+      lemma_names.emplace_back(lemma_job.GetLemmaName());
+    }
+    dashboard->AddQueuedLemmas(lemma_names);
+  }
 
-  app.RunOnLemmas(lemma_job_generator->GenerateLemmaJobs());
+  if(parameters.penetration_lemma != "" && parameters.heuristic_length > 1 &&
+     !lemma_jobs.empty()) {
+    auto best_heuristic = app.RunHeuristicSearch(lemma_jobs,
+                                                 parameters.heuristic_length);
+    if(best_heuristic != "" && parameters.config_file_path != "") {
+      UtTamarinConfig::WriteLemmaHeuristics(
+              parameters.config_file_path,
+              {{lemma_jobs.front().GetLemmaName(), best_heuristic}});
+    }
+    ReportPhases(parameters, *output_writer);
+    return 0;
+  }
+
+  app.RunOnLemmas(lemma_jobs);
+  ReportPhases(parameters, *output_writer);
+
+  if(parameters.regression_threshold > 0 && history != nullptr) {
+    std::vector<std::string> lemmas;
+    for(const auto& lemma_job : lemma_jobs) {
+      lemmas.emplace_back(lemma_job.GetLemmaName());
+    }
+    auto regressions = FindRegressions(*history, lemmas, run_info.run_id,
+                                       parameters.regression_threshold / 100);
+    PrintRegressionReport(regressions, parameters.regression_threshold / 100,
+                          *output_writer);
+    if(parameters.fail_on_regression && !regressions.empty()) return 1;
+  }
 
   return 0;
 }
@@ -0,0 +1,219 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "metrics_exporter.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "resource_sampler.h"
+
+using std::string;
+
+namespace uttamarin {
+
+namespace {
+
+// Upper bounds (in seconds) of the buckets of the lemma duration histogram
+const std::vector<double> kDurationBuckets = {1, 5, 10, 30, 60, 300, 600,
+                                              1800, 3600};
+
+string ToMetricsString(ProverResult result) {
+  switch(result) {
+    case ProverResult::True: return "verified";
+    case ProverResult::False: return "falsified";
+    default: return "unknown";
+  }
+}
+
+// Escapes a label value of the Prometheus text format
+string EscapeLabelValue(const string& value) {
+  string escaped;
+  for(auto c : value) {
+    if(c == '\\' || c == '"') escaped += '\\';
+    if(c == '\n') escaped += "\\n";
+    else escaped += c;
+  }
+  return escaped;
+}
+
+void WriteMetricHeader(std::ostream& stream, const string& name,
+                       const string& type, const string& help) {
+  stream << "# HELP " << name << " " << help << "\n"
+         << "# TYPE " << name << " " << type << "\n";
+}
+
+} // namespace
+
+MetricsExporter::MetricsExporter(const string& metrics_file_path,
+                                 int number_of_workers,
+                                 int interval) :
+  metrics_file_path_(metrics_file_path),
+  number_of_workers_(number_of_workers),
+  interval_(interval),
+  queued_lemmas_(0),
+  running_lemmas_(0),
+  finished_lemmas_(0),
+  duration_bucket_counts_(kDurationBuckets.size(), 0),
+  duration_sum_(0),
+  busy_time_(0),
+  is_stopping_(false) {
+  thread_ = std::thread(&MetricsExporter::Run, this);
+}
+
+MetricsExporter::~MetricsExporter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  stop_requested_.notify_all();
+  thread_.join();
+  Write();
+}
+
+void MetricsExporter::AddQueuedLemmas(int number_of_lemmas) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  queued_lemmas_ += number_of_lemmas;
+}
+
+void MetricsExporter::StartLemma() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Jobs that were not queued before (e.g., of a heuristic search) are
+  // counted as running only
+  if(queued_lemmas_ > 0) --queued_lemmas_;
+  ++running_lemmas_;
+}
+
+void MetricsExporter::FinishLemma(const string& lemma_name,
+                                  const TamarinOutput& tamarin_output) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  --running_lemmas_;
+  ++finished_lemmas_;
+  ++result_counts_[tamarin_output.result];
+  for(size_t i = 0; i < kDurationBuckets.size(); ++i) {
+    if(tamarin_output.wall_time <= kDurationBuckets[i]) {
+      ++duration_bucket_counts_[i];
+    }
+  }
+  duration_sum_ += tamarin_output.wall_time;
+  busy_time_ += tamarin_output.wall_time;
+  duration_of_lemma_[lemma_name] = tamarin_output.wall_time;
+}
+
+void MetricsExporter::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while(!is_stopping_) {
+    stop_requested_.wait_for(lock, std::chrono::milliseconds(interval_));
+    if(is_stopping_) break;
+    lock.unlock();
+    Write();
+    lock.lock();
+  }
+}
+
+void MetricsExporter::Write() {
+  std::lock_guard<std::mutex> write_lock(write_mutex_);
+  auto metrics_text = ToPrometheusText();
+  auto temp_file_path = metrics_file_path_ + ".tmp";
+  {
+    std::ofstream temp_file{temp_file_path};
+    temp_file << metrics_text;
+    if(!temp_file) {
+      std::cerr << "Warning: cannot write metrics file '" << temp_file_path
+                << "'." << std::endl;
+      return;
+    }
+  }
+  if(std::rename(temp_file_path.c_str(), metrics_file_path_.c_str()) != 0) {
+    std::cerr << "Warning: cannot replace metrics file '"
+              << metrics_file_path_ << "'." << std::endl;
+  }
+}
+
+string MetricsExporter::ToPrometheusText() {
+  // Reading /proc takes a while, so it happens outside of the lock
+  long long memory = ReadProcessTreeMemory(getpid()) * 1024LL;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ostringstream text;
+  WriteMetricHeader(text, "uttamarin_lemmas", "gauge",
+                    "Lemma jobs by state.");
+  text << "uttamarin_lemmas{state=\"queued\"} " << queued_lemmas_ << "\n"
+       << "uttamarin_lemmas{state=\"running\"} " << running_lemmas_ << "\n"
+       << "uttamarin_lemmas{state=\"done\"} " << finished_lemmas_ << "\n";
+
+  WriteMetricHeader(text, "uttamarin_lemma_results_total", "counter",
+                    "Finished lemma jobs by result.");
+  for(auto result : {ProverResult::True, ProverResult::False,
+                     ProverResult::Unknown}) {
+    text << "uttamarin_lemma_results_total{result=\""
+         << ToMetricsString(result) << "\"} " << result_counts_[result]
+         << "\n";
+  }
+
+  WriteMetricHeader(text, "uttamarin_lemma_duration_seconds", "histogram",
+                    "Wall time of the finished lemma jobs.");
+  for(size_t i = 0; i < kDurationBuckets.size(); ++i) {
+    text << "uttamarin_lemma_duration_seconds_bucket{le=\""
+         << kDurationBuckets[i] << "\"} " << duration_bucket_counts_[i]
+         << "\n";
+  }
+  text << "uttamarin_lemma_duration_seconds_bucket{le=\"+Inf\"} "
+       << finished_lemmas_ << "\n"
+       << "uttamarin_lemma_duration_seconds_sum " << duration_sum_ << "\n"
+       << "uttamarin_lemma_duration_seconds_count " << finished_lemmas_
+       << "\n";
+
+  WriteMetricHeader(text, "uttamarin_lemma_last_duration_seconds", "gauge",
+                    "Wall time of the latest job of each lemma.");
+  for(const auto& [lemma_name, duration] : duration_of_lemma_) {
+    text << "uttamarin_lemma_last_duration_seconds{lemma=\""
+         << EscapeLabelValue(lemma_name) << "\"} " << duration << "\n";
+  }
+
+  WriteMetricHeader(text, "uttamarin_workers", "gauge",
+                    "Number of workers.");
+  text << "uttamarin_workers " << number_of_workers_ << "\n";
+  WriteMetricHeader(text, "uttamarin_worker_utilization", "gauge",
+                    "Fraction of the workers that run a lemma job.");
+  text << "uttamarin_worker_utilization "
+       << static_cast<double>(running_lemmas_) / number_of_workers_ << "\n";
+  WriteMetricHeader(text, "uttamarin_worker_busy_seconds_total", "counter",
+                    "Time the workers spent on finished lemma jobs.");
+  text << "uttamarin_worker_busy_seconds_total " << busy_time_ << "\n";
+
+  WriteMetricHeader(text, "uttamarin_memory_bytes", "gauge",
+                    "Resident memory of UT Tamarin and its Tamarin "
+                    "processes.");
+  text << "uttamarin_memory_bytes " << memory << "\n";
+  return text.str();
+}
+
+} // namespace uttamarin
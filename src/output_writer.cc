@@ -22,25 +22,233 @@
 
 #include "output_writer.h"
 
+#include <chrono>
+#include <functional>
 #include <initializer_list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "lemma_job.h"
+#include "lemma_processor.h"
+#include "reporter.h"
+
 using std::string;
 
 namespace uttamarin {
 
-OutputWriter::OutputWriter(std::vector<std::ostream*> streams) :
+namespace {
+
+const std::chrono::seconds kStatusInterval(1);
+
+} // namespace
+
+OutputWriter::OutputWriter(std::vector<std::ostream*> streams,
+                           OutputOrder output_order) :
   streams_(streams),
+  output_order_(output_order),
   color_code_of_({{TextColor::Red, "31"},
                   {TextColor::Green, "32"},
-                  {TextColor::Yellow, "33"}}){
+                  {TextColor::Yellow, "33"}}),
+  is_output_thread_waiting_(false),
+  has_status_(false),
+  is_stopping_(false),
+  number_of_status_lines_(0),
+  next_block_index_(0) {
+  output_thread_ = std::thread(&OutputWriter::RunOutputThread, this);
+}
+
+OutputWriter::~OutputWriter() {
+  auto& pending_line = GetPendingLine();
+  if(!pending_line.text.empty()) Endl();
+  FlushBlocks();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  event_available_.notify_all();
+  output_thread_.join();
+}
+
+OutputWriter::PendingLine& OutputWriter::GetPendingLine() {
+  // Each thread collects its lines separately, so that lines of concurrent
+  // threads cannot interleave. The lines live as long as the writer, and
+  // only the calling thread uses its line, which insertions do not move.
+  std::lock_guard<std::mutex> lock(pending_lines_mutex_);
+  return pending_line_of_[std::this_thread::get_id()];
+}
+
+void OutputWriter::Append(const string& colorized_text, const string& text) {
+  auto& pending_line = GetPendingLine();
+  pending_line.colorized_text += colorized_text;
+  pending_line.text += text;
 }
 
 void OutputWriter::Endl() {
-  for(auto stream : streams_){
-    *stream << std::endl;
+  auto& pending_line = GetPendingLine();
+  auto colorized_line = std::move(pending_line.colorized_text);
+  auto line = std::move(pending_line.text);
+  pending_line.colorized_text.clear();
+  pending_line.text.clear();
+  if(pending_line.is_in_block) {
+    Queue([this, index = pending_line.block_index, colorized_line, line] {
+      WriteBlockLine(index, colorized_line, line);
+    });
+  } else {
+    Queue([this, colorized_line, line] { WriteLine(colorized_line, line); });
+  }
+}
+
+void OutputWriter::BeginBlock(size_t index) {
+  auto& pending_line = GetPendingLine();
+  pending_line.is_in_block = true;
+  pending_line.block_index = index;
+}
+
+void OutputWriter::EndBlock() {
+  auto& pending_line = GetPendingLine();
+  if(!pending_line.is_in_block) return;
+  pending_line.is_in_block = false;
+  Queue([this, index = pending_line.block_index] { WriteEndOfBlock(index); });
+}
+
+void OutputWriter::FlushBlocks() {
+  Queue([this] { WriteBufferedBlocks(); });
+}
+
+OutputOrder OutputWriter::GetOutputOrder() const {
+  return output_order_;
+}
+
+void OutputWriter::AddReporter(std::shared_ptr<Reporter> reporter) {
+  Queue([this, reporter] { reporters_.emplace_back(reporter); });
+}
+
+void OutputWriter::SetStatusProvider(
+        std::function<std::vector<string>()> status_provider) {
+  has_status_ = true;
+  Queue([this, status_provider] { status_provider_ = status_provider; });
+}
+
+void OutputWriter::ReportLemmaStarted(const LemmaJob& lemma_job) {
+  auto time = std::chrono::duration<double>(
+          std::chrono::system_clock::now().time_since_epoch()).count();
+  Queue([this, lemma_job, time] {
+    for(auto& reporter : reporters_) {
+      reporter->ReportLemmaStarted(lemma_job, time);
+    }
+  });
+}
+
+void OutputWriter::ReportLemmaFinished(const LemmaJob& lemma_job,
+                                       const TamarinOutput& tamarin_output) {
+  auto time = std::chrono::duration<double>(
+          std::chrono::system_clock::now().time_since_epoch()).count();
+  Queue([this, lemma_job, tamarin_output, time] {
+    for(auto& reporter : reporters_) {
+      reporter->ReportLemmaFinished(lemma_job, tamarin_output, time);
+    }
+  });
+}
+
+void OutputWriter::Queue(std::function<void()> event) {
+  events_.Push(std::move(event));
+  // Only wake up the output thread if it waits (or is about to wait) for
+  // events, so that producers usually do not touch the mutex
+  if(is_output_thread_waiting_) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    event_available_.notify_one();
+  }
+}
+
+void OutputWriter::RunOutputThread() {
+  while(true) {
+    std::function<void()> event;
+    while(events_.Pop(event)) event();
+    DrawStatus();
+    for(auto stream : streams_) stream->flush();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    is_output_thread_waiting_ = true;
+    auto has_event = [this] { return events_.HasNext() || is_stopping_; };
+    // The status is redrawn at least once per second
+    if(has_status_) event_available_.wait_for(lock, kStatusInterval, has_event);
+    else event_available_.wait(lock, has_event);
+    is_output_thread_waiting_ = false;
+    if(is_stopping_ && !events_.HasNext()) break;
+  }
+  ClearStatus();
+  std::cout.flush();
+}
+
+void OutputWriter::DrawStatus() {
+  if(!status_provider_) return;
+  ClearStatus();
+  auto status_lines = status_provider_();
+  for(const auto& status_line : status_lines) {
+    std::cout << status_line << "\n";
+  }
+  number_of_status_lines_ = status_lines.size();
+}
+
+void OutputWriter::ClearStatus() {
+  if(number_of_status_lines_ == 0) return;
+  // Move to the first status line and clear everything below
+  std::cout << "\033[" << number_of_status_lines_ << "F\033[J";
+  number_of_status_lines_ = 0;
+}
+
+void OutputWriter::WriteLine(const string& colorized_line,
+                             const string& line) {
+  ClearStatus();
+  for(auto stream : streams_) {
+    *stream << (stream == &std::cout ? colorized_line : line) << "\n";
+  }
+}
+
+void OutputWriter::WriteBlockLine(size_t index, const string& colorized_line,
+                                  const string& line) {
+  if(output_order_ == OutputOrder::Completion || index <= next_block_index_) {
+    WriteLine(colorized_line, line);
+    return;
+  }
+  auto& block = buffered_blocks_[index];
+  block.colorized_lines.emplace_back(colorized_line);
+  block.lines.emplace_back(line);
+}
+
+void OutputWriter::WriteEndOfBlock(size_t index) {
+  if(output_order_ == OutputOrder::Completion) return;
+  if(index != next_block_index_) {
+    buffered_blocks_[index].is_ended = true;
+    return;
+  }
+  // Write the blocks that waited for this one
+  ++next_block_index_;
+  for(auto it = buffered_blocks_.find(next_block_index_);
+      it != buffered_blocks_.end();
+      it = buffered_blocks_.find(next_block_index_)) {
+    for(size_t i = 0; i < it->second.lines.size(); ++i) {
+      WriteLine(it->second.colorized_lines[i], it->second.lines[i]);
+    }
+    bool is_ended = it->second.is_ended;
+    buffered_blocks_.erase(it);
+    // The remaining lines of an unfinished block are written directly
+    if(!is_ended) break;
+    ++next_block_index_;
+  }
+}
+
+void OutputWriter::WriteBufferedBlocks() {
+  for(const auto& [index, block] : buffered_blocks_) {
+    for(size_t i = 0; i < block.lines.size(); ++i) {
+      WriteLine(block.colorized_lines[i], block.lines[i]);
+    }
   }
+  buffered_blocks_.clear();
+  next_block_index_ = 0;
 }
 
 } // namespace uttamarin
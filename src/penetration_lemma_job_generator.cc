@@ -22,12 +22,17 @@
 
 #include "penetration_lemma_job_generator.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "heuristic_bandit.h"
+#include "lemma_history.h"
 #include "lemma_name_reader.h"
+#include "theory_index.h"
 #include "utility.h"
 
+using std::shared_ptr;
 using std::string;
 using std::vector;
 
@@ -35,22 +40,36 @@ namespace uttamarin {
 
 PenetrationLemmaJobGenerator::PenetrationLemmaJobGenerator(
                              const string& spthy_file_path,
-                             const string& lemma_name) :
+                             const string& lemma_name,
+                             shared_ptr<LemmaHistory> history,
+                             shared_ptr<const TheoryIndex> theory_index) :
                               spthy_file_path_(spthy_file_path),
-                              lemma_name_(lemma_name){
+                              lemma_name_(lemma_name),
+                              history_(history),
+                              theory_index_(theory_index) {
 
 }
 
+const vector<TamarinHeuristic>&
+PenetrationLemmaJobGenerator::GetAllHeuristics() {
+  static const vector<TamarinHeuristic> all_heuristics =
+                    {TamarinHeuristic::S, TamarinHeuristic::s,
+                     TamarinHeuristic::I, TamarinHeuristic::i,
+                     TamarinHeuristic::C, TamarinHeuristic::c,
+                     TamarinHeuristic::P, TamarinHeuristic::p};
+  return all_heuristics;
+}
+
 vector<LemmaJob> PenetrationLemmaJobGenerator::DoGenerateLemmaJobs() {
   auto lemmas_in_file = ReadLemmaNamesFromSpthyFile(spthy_file_path_);
 
   string lemma_name = GetStringWithShortestEditDistance(lemmas_in_file,
                                                         lemma_name_);
-  vector<TamarinHeuristic> all_heuristics =
-                    {TamarinHeuristic::S, TamarinHeuristic::s,
-                     TamarinHeuristic::I, TamarinHeuristic::i,
-                     TamarinHeuristic::C, TamarinHeuristic::c,
-                     TamarinHeuristic::P, TamarinHeuristic::p};
+  auto all_heuristics = GetAllHeuristics();
+  if(history_ != nullptr && theory_index_ != nullptr) {
+    all_heuristics = HeuristicBandit(history_->GetRecords()).RankHeuristics(
+                             theory_index_->GetLemmaFeatures(lemma_name));
+  }
 
   vector<LemmaJob> lemma_jobs;
 
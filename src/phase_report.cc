@@ -0,0 +1,155 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "phase_report.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "output_writer.h"
+#include "tracing.h"
+
+using std::string;
+using std::vector;
+using json = nlohmann::json;
+
+namespace uttamarin {
+
+namespace {
+
+// Phases of the main thread that run before the lemma jobs
+const vector<string> kSetupPhases = {
+  "config parsing", "history loading", "theory indexing", "lemma discovery"
+};
+
+string FormatSeconds(double seconds) {
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(3) << seconds << "s";
+  return stream.str();
+}
+
+string FormatPercentage(double part, double whole) {
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(1)
+         << (whole > 0 ? 100 * part / whole : 0) << "%";
+  return stream.str();
+}
+
+} // namespace
+
+PhaseBreakdown ComputePhaseBreakdown(int number_of_workers) {
+  PhaseBreakdown breakdown;
+  breakdown.wall_time = tracing::GetElapsedTime();
+  breakdown.number_of_workers = number_of_workers;
+  breakdown.phases = tracing::GetPhaseStatistics();
+
+  breakdown.prover_time = tracing::GetPhaseStatistics("tamarin").total_time;
+  // Workers that wait for a slot of the jobserver are idle
+  breakdown.busy_time =
+          tracing::GetPhaseStatistics("lemma job").total_time -
+          tracing::GetPhaseStatistics("jobserver slot").total_time;
+  breakdown.job_wall_time =
+          tracing::GetPhaseStatistics("process lemma jobs").total_time;
+
+  // Lemma jobs contain the Tamarin runs, their preprocessing and parsing
+  breakdown.overhead_time =
+          breakdown.busy_time - breakdown.prover_time +
+          tracing::GetPhaseStatistics("print result").total_time;
+  for(const auto& phase : kSetupPhases) {
+    breakdown.overhead_time += tracing::GetPhaseStatistics(phase).total_time;
+  }
+
+  double capacity = number_of_workers * breakdown.job_wall_time;
+  breakdown.idle_time = std::max(capacity - breakdown.busy_time, 0.0);
+  breakdown.parallel_efficiency =
+          capacity > 0 ? breakdown.busy_time / capacity : 0;
+  return breakdown;
+}
+
+void PrintPhaseBreakdown(const PhaseBreakdown& breakdown,
+                         OutputWriter& output_writer) {
+  auto total = breakdown.prover_time + breakdown.overhead_time;
+  output_writer << "\nPhase breakdown:\n"
+    << "Wall time: " << FormatSeconds(breakdown.wall_time) << "\n"
+    << "Tamarin: " << FormatSeconds(breakdown.prover_time) << " ("
+    << FormatPercentage(breakdown.prover_time, total) << ")\n"
+    << "Overhead: " << FormatSeconds(breakdown.overhead_time) << " ("
+    << FormatPercentage(breakdown.overhead_time, total) << ")\n"
+    << "Parallel efficiency: "
+    << FormatPercentage(breakdown.parallel_efficiency, 1) << " ("
+    << breakdown.number_of_workers << " worker"
+    << (breakdown.number_of_workers != 1 ? "s" : "") << ", idle "
+    << FormatSeconds(breakdown.idle_time) << ")\n\n";
+
+  output_writer << std::left << std::setw(22) << "Phase" << std::right
+                << std::setw(8) << "Count" << std::setw(12) << "Total"
+                << std::setw(12) << "Mean" << std::setw(12) << "Max" << "\n";
+  for(const auto& phase : breakdown.phases) {
+    output_writer << std::left << std::setw(22) << phase.name << std::right
+                  << std::setw(8) << phase.count
+                  << std::setw(12) << FormatSeconds(phase.total_time)
+                  << std::setw(12) << FormatSeconds(phase.total_time /
+                                                    phase.count)
+                  << std::setw(12) << FormatSeconds(phase.max_time) << "\n";
+  }
+  output_writer << "(Phases are nested: a lemma job contains preprocessing, "
+                << "Tamarin and parsing.)";
+  output_writer.Endl();
+}
+
+void WritePhaseBreakdown(const PhaseBreakdown& breakdown,
+                         const string& json_file_path) {
+  auto phases = json::array();
+  for(const auto& phase : breakdown.phases) {
+    phases.emplace_back(json{{"name", phase.name},
+                             {"count", phase.count},
+                             {"total_time", phase.total_time},
+                             {"max_time", phase.max_time}});
+  }
+  json json_breakdown = {
+    {"wall_time", breakdown.wall_time},
+    {"prover_time", breakdown.prover_time},
+    {"overhead_time", breakdown.overhead_time},
+    {"job_wall_time", breakdown.job_wall_time},
+    {"busy_time", breakdown.busy_time},
+    {"idle_time", breakdown.idle_time},
+    {"parallel_efficiency", breakdown.parallel_efficiency},
+    {"number_of_workers", breakdown.number_of_workers},
+    {"phases", phases}
+  };
+  std::ofstream json_file{json_file_path};
+  if(!json_file) {
+    std::cerr << "Warning: cannot write phase report '" << json_file_path
+              << "'." << std::endl;
+    return;
+  }
+  json_file << json_breakdown.dump(1, '\t') << std::endl;
+}
+
+} // namespace uttamarin
@@ -0,0 +1,154 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "portfolio_lemma_processor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lemma_job.h"
+#include "penetration_lemma_job_generator.h"
+#include "task_control.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace uttamarin {
+
+namespace {
+
+// Returns the i-th element (starting at i = 1) of the Luby sequence
+// 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 4, 8, ...
+int Luby(int i) {
+  for(int k = 1;;++k) {
+    if(i == (1 << k) - 1) return 1 << (k - 1);
+    if(i < (1 << k) - 1) return Luby(i - (1 << (k - 1)) + 1);
+  }
+}
+
+} // namespace
+
+PortfolioLemmaProcessor::PortfolioLemmaProcessor(
+        unique_ptr<LemmaProcessor> decoratee,
+        int base_slice,
+        int timeout) :
+  decoratee_(std::move(decoratee)),
+  base_slice_(std::max(base_slice, 1)),
+  timeout_(timeout) {
+}
+
+TamarinOutput PortfolioLemmaProcessor::DoProcessLemma(
+        const LemmaJob& lemma_job) {
+  auto heuristics = GetHeuristicOrder(lemma_job);
+  // The running time of all slices so far, in seconds. Like the timeouts of
+  // RunShellCommand, it leaves out the time in which a scheduler suspended
+  // the job.
+  double elapsed = 0;
+  double cpu_time = 0;
+  long max_rss = 0;
+  long major_faults = 0;
+  auto failure_reason = FailureReason::Timeout;
+  auto task_control = TaskControl::GetCurrent();
+
+  for(int round = 1;!heuristics.empty();++round) {
+    int slice = base_slice_ * Luby(round);
+    vector<string> remaining_heuristics;
+    for(const auto& heuristic : heuristics) {
+      if(timeout_ > 0 && elapsed >= timeout_) break;
+      int slice_timeout = slice;
+      if(timeout_ > 0) {
+        slice_timeout = std::min(slice, std::max(
+                static_cast<int>(std::ceil(timeout_ - elapsed)), 1));
+      }
+      auto slice_job = lemma_job;
+      slice_job.SetHeuristic(heuristic);
+      slice_job.SetTimeout(slice_timeout);
+      auto start_time = std::chrono::steady_clock::now();
+      double suspended_time = task_control != nullptr ?
+                              task_control->GetSuspendedTime() : 0;
+      auto output = decoratee_->ProcessLemma(slice_job);
+      elapsed += std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start_time)
+                         .count() -
+                 (task_control != nullptr ?
+                  task_control->GetSuspendedTime() - suspended_time : 0);
+      cpu_time += output.cpu_time;
+      max_rss = std::max(max_rss, output.max_rss);
+      major_faults += output.major_faults;
+
+      if(output.result != ProverResult::Unknown) {
+        output.duration = static_cast<int>(elapsed);
+        output.wall_time = elapsed;
+        output.cpu_time = cpu_time;
+        output.max_rss = max_rss;
+        output.major_faults = major_faults;
+        return output;
+      }
+      if(output.failure_reason == FailureReason::Cancelled) return output;
+      // A heuristic that ends without a result before its slice is used up
+      // failed for good (e.g., Tamarin crashed) and is not restarted
+      if(output.failure_reason == FailureReason::Timeout) {
+        remaining_heuristics.emplace_back(heuristic);
+      } else {
+        failure_reason = output.failure_reason;
+      }
+    }
+    if(timeout_ > 0 && elapsed >= timeout_) break;
+    heuristics = remaining_heuristics;
+  }
+
+  if(timeout_ > 0 && elapsed >= timeout_) {
+    failure_reason = FailureReason::Timeout;
+  }
+  TamarinOutput tamarin_output;
+  tamarin_output.result = ProverResult::Unknown;
+  tamarin_output.duration = static_cast<int>(elapsed);
+  tamarin_output.heuristic = lemma_job.GetHeuristic();
+  tamarin_output.failure_reason = failure_reason;
+  tamarin_output.wall_time = elapsed;
+  tamarin_output.cpu_time = cpu_time;
+  tamarin_output.max_rss = max_rss;
+  tamarin_output.major_faults = major_faults;
+  return tamarin_output;
+}
+
+vector<string> PortfolioLemmaProcessor::GetHeuristicOrder(
+        const LemmaJob& lemma_job) {
+  vector<string> heuristics;
+  if(!lemma_job.GetHeuristic().empty()) {
+    heuristics.emplace_back(lemma_job.GetHeuristic());
+  }
+  for(auto heuristic : PenetrationLemmaJobGenerator::GetAllHeuristics()) {
+    if(ToString(heuristic) != lemma_job.GetHeuristic()) {
+      heuristics.emplace_back(ToString(heuristic));
+    }
+  }
+  return heuristics;
+}
+
+} // namespace uttamarin
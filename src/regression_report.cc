@@ -0,0 +1,148 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "regression_report.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "lemma_history.h"
+#include "output_writer.h"
+
+using std::string;
+using std::vector;
+
+namespace uttamarin {
+
+namespace {
+
+// Number of earlier runs that form the baseline of a lemma
+const size_t kBaselineRuns = 5;
+
+// Smallest increase of the wall-clock time (in seconds) that counts
+const double kMinimumTimeIncrease = 1.0;
+
+double Median(vector<double> values) {
+  std::sort(values.begin(), values.end());
+  auto middle = values.size() / 2;
+  return values.size() % 2 == 1 ? values[middle] :
+         (values[middle - 1] + values[middle]) / 2;
+}
+
+string FormatNumber(double number) {
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(number == std::floor(number) ?
+                                            0 : 1) << number;
+  return stream.str();
+}
+
+} // namespace
+
+vector<Regression> FindRegressions(const LemmaHistory& history,
+                                   const vector<string>& lemmas,
+                                   const string& run_id,
+                                   double threshold) {
+  vector<Regression> regressions;
+  for(const auto& lemma_name : lemmas) {
+    auto records = history.GetRecordsOfLemma(lemma_name);
+    auto current = std::find_if(records.rbegin(), records.rend(),
+                                [&run_id](const LemmaRecord& record) {
+                                  return record.run_id == run_id;
+                                });
+    if(current == records.rend()) continue;
+
+    vector<double> baseline_times;
+    vector<double> baseline_steps;
+    vector<string> baseline_runs;
+    for(auto it = current;it != records.rend();++it) {
+      if(it->run_id == run_id || it->result == ProverResult::Unknown ||
+         std::find(baseline_runs.begin(), baseline_runs.end(), it->run_id) !=
+         baseline_runs.end()) continue;
+      baseline_runs.emplace_back(it->run_id);
+      baseline_times.emplace_back(GetWallTime(*it));
+      if(it->steps >= 0) baseline_steps.emplace_back(it->steps);
+      if(baseline_runs.size() >= kBaselineRuns) break;
+    }
+    if(baseline_runs.empty()) continue;
+
+    if(current->result == ProverResult::Unknown) {
+      regressions.emplace_back(Regression{lemma_name, "result", 1, 0});
+      continue;
+    }
+    auto baseline_time = Median(baseline_times);
+    auto current_time = GetWallTime(*current);
+    if(current_time > baseline_time * (1 + threshold) &&
+       current_time - baseline_time >= kMinimumTimeIncrease) {
+      regressions.emplace_back(Regression{lemma_name, "wall time",
+                                          baseline_time, current_time});
+    }
+    if(!baseline_steps.empty() && current->steps >= 0) {
+      auto baseline_step_count = Median(baseline_steps);
+      if(current->steps > baseline_step_count * (1 + threshold)) {
+        regressions.emplace_back(Regression{lemma_name, "steps",
+                                            baseline_step_count,
+                                            static_cast<double>(
+                                                    current->steps)});
+      }
+    }
+  }
+  return regressions;
+}
+
+void PrintRegressionReport(const vector<Regression>& regressions,
+                           double threshold,
+                           OutputWriter& output_writer) {
+  output_writer << "\nRegressions (threshold: "
+                << FormatNumber(threshold * 100) << "%): ";
+  if(regressions.empty()) {
+    output_writer << "none";
+    output_writer.Endl();
+    return;
+  }
+  output_writer << regressions.size() << "\n";
+  for(const auto& regression : regressions) {
+    output_writer << regression.lemma_name << ": ";
+    if(regression.metric == "result") {
+      output_writer.WriteColorized("no definitive result anymore",
+                                   TextColor::Red);
+    } else {
+      std::ostringstream change;
+      change << regression.metric << " " << FormatNumber(regression.baseline)
+             << (regression.metric == "wall time" ? "s" : "") << " -> "
+             << FormatNumber(regression.current)
+             << (regression.metric == "wall time" ? "s" : "") << " (+"
+             << FormatNumber(std::round((regression.current /
+                                         std::max(regression.baseline, 1e-9)
+                                         - 1) * 100))
+             << "%)";
+      output_writer.WriteColorized(change.str(), TextColor::Red);
+    }
+    output_writer << "\n";
+  }
+  output_writer.Endl();
+}
+
+} // namespace uttamarin
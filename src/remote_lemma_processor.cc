@@ -0,0 +1,486 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "remote_lemma_processor.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "lemma_job.h"
+#include "task_control.h"
+#include "tcp_socket.h"
+#include "utility.h"
+#include "worker_protocol.h"
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+using json = nlohmann::json;
+
+namespace uttamarin {
+
+namespace {
+
+// Maximum number of times that a lemma job runs on some worker
+const int kMaxAttempts = 3;
+
+// Interval in which a waiting lemma job checks whether its task was cancelled
+const std::chrono::milliseconds kCancelCheckInterval(100);
+
+// Time (in seconds) after which a TCP worker that does not connect, say
+// hello or accept any data is considered lost
+const int kNetworkTimeout = 60;
+
+// Starts the given worker command with pipes as its standard input and
+// output. Returns the process id of the shell or -1.
+pid_t StartWorker(const string& command, int& input, int& output) {
+  int to_worker[2];
+  int from_worker[2];
+  if(pipe2(to_worker, O_CLOEXEC) != 0) return -1;
+  if(pipe2(from_worker, O_CLOEXEC) != 0) {
+    close(to_worker[0]);
+    close(to_worker[1]);
+    return -1;
+  }
+  auto pid = fork();
+  if(pid == 0) {
+    dup2(to_worker[0], STDIN_FILENO);
+    dup2(from_worker[1], STDOUT_FILENO);
+    execl("/bin/sh", "sh", "-c", command.c_str(), nullptr);
+    _exit(127);
+  }
+  close(to_worker[0]);
+  close(from_worker[1]);
+  if(pid < 0) {
+    close(to_worker[1]);
+    close(from_worker[0]);
+    return -1;
+  }
+  input = to_worker[1];
+  output = from_worker[0];
+  return pid;
+}
+
+TamarinOutput CreateFailedOutput(const string& heuristic,
+                                 FailureReason failure_reason,
+                                 const string& error) {
+  TamarinOutput tamarin_output;
+  tamarin_output.result = ProverResult::Unknown;
+  tamarin_output.duration = 0;
+  tamarin_output.heuristic = heuristic;
+  tamarin_output.failure_reason = failure_reason;
+  tamarin_output.error = error;
+  return tamarin_output;
+}
+
+} // namespace
+
+struct RemoteLemmaProcessor::Job {
+  explicit Job(const LemmaJob& lemma_job) : lemma_job(lemma_job) {}
+
+  uint64_t id = 0;
+  LemmaJob lemma_job;
+  string theory_hash;
+  int timeout = 0;
+  int attempts = 0;
+  std::set<const Worker*> tried_workers;
+  Worker* worker = nullptr; // that queues or runs the job
+  bool is_running = false;
+  bool is_cancelled = false;
+  bool is_finished = false;
+  TamarinOutput tamarin_output;
+};
+
+struct RemoteLemmaProcessor::Worker {
+  string name;
+  int input = -1; // to the worker
+  int output = -1; // from the worker, the same socket as 'input' for TCP
+  pid_t pid = -1; // of a started worker command
+  int slots = 0;
+  string tamarin_version;
+  bool is_connected = false;
+  std::set<string> theories; // hashes of the theories that the worker has
+  std::deque<shared_ptr<Job>> queue;
+  std::unordered_map<uint64_t, shared_ptr<Job>> running; // by id
+  std::deque<json> outbox; // messages that the writer still has to send
+  std::condition_variable has_messages;
+  std::thread reader;
+  std::thread writer;
+};
+
+RemoteLemmaProcessor::RemoteLemmaProcessor(const vector<string>& workers,
+                                           int timeout) :
+  timeout_(timeout),
+  next_job_id_(1),
+  is_stopping_(false) {
+  // Lost workers are detected by their connections, not by a signal
+  std::signal(SIGPIPE, SIG_IGN);
+  for(const auto& name : workers) {
+    auto worker = std::make_unique<Worker>();
+    worker->name = name;
+    string host;
+    string port;
+    bool is_tcp = SplitAddress(name, host, port);
+    if(is_tcp) {
+      worker->input = ConnectToAddress(host, port, kNetworkTimeout);
+      worker->output = worker->input;
+    } else {
+      worker->pid = StartWorker(name, worker->input, worker->output);
+    }
+    json hello;
+    if(worker->output >= 0 && ReceiveMessage(worker->output, hello) &&
+       hello.value("type", json()) == "hello" &&
+       hello.value("slots", json()).is_number_integer() &&
+       hello.value("slots", 0) > 0 &&
+       hello.value("tamarin_version", json("")).is_string()) {
+      worker->slots = hello.value("slots", 0);
+      worker->tamarin_version = hello.value("tamarin_version", "");
+      worker->is_connected = true;
+      if(is_tcp) {
+        // Results may take hours, but sending keeps its timeout
+        timeval no_time_limit{0, 0};
+        setsockopt(worker->output, SOL_SOCKET, SO_RCVTIMEO, &no_time_limit,
+                   sizeof(no_time_limit));
+      }
+    } else {
+      std::cerr << "Warning: cannot reach the worker '" << name
+                << "', running without it." << std::endl;
+    }
+    workers_.emplace_back(std::move(worker));
+  }
+  for(auto& worker : workers_) {
+    if(!worker->is_connected) continue;
+    worker->reader = std::thread(&RemoteLemmaProcessor::ReadResults, this,
+                                 worker.get());
+    worker->writer = std::thread(&RemoteLemmaProcessor::WriteMessages, this,
+                                 worker.get());
+  }
+}
+
+RemoteLemmaProcessor::~RemoteLemmaProcessor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+    for(auto& worker : workers_) {
+      worker->is_connected = false;
+      worker->has_messages.notify_all();
+    }
+  }
+  // Workers stop once their input ends
+  for(auto& worker : workers_) {
+    if(worker->input >= 0 && worker->pid < 0) {
+      // Also wakes up a writer that is stuck in sending
+      shutdown(worker->input, SHUT_WR);
+    }
+    if(worker->writer.joinable()) worker->writer.join();
+    if(worker->input >= 0 && worker->pid >= 0) close(worker->input);
+  }
+  for(auto& worker : workers_) {
+    if(worker->reader.joinable()) worker->reader.join();
+    if(worker->output >= 0) close(worker->output);
+    if(worker->pid > 0) waitpid(worker->pid, nullptr, 0);
+  }
+}
+
+int RemoteLemmaProcessor::GetNumberOfSlots() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int slots = 0;
+  for(const auto& worker : workers_) {
+    if(worker->is_connected) slots += worker->slots;
+  }
+  return slots;
+}
+
+string RemoteLemmaProcessor::GetTamarinVersion() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for(const auto& worker : workers_) {
+    if(worker->is_connected) return worker->tamarin_version;
+  }
+  return "";
+}
+
+bool RemoteLemmaProcessor::Enqueue(shared_ptr<Job> job) {
+  Worker* best_worker = nullptr;
+  double best_cost = 0;
+  for(auto& worker : workers_) {
+    if(!worker->is_connected || job->tried_workers.count(worker.get()) > 0) {
+      continue;
+    }
+    // Sending the theory costs about as much as one more job per slot
+    bool has_theory =
+            worker->theories.count(job->theory_hash) > 0 ||
+            std::any_of(worker->queue.begin(), worker->queue.end(),
+                        [&job](const shared_ptr<Job>& queued_job) {
+                          return queued_job->theory_hash == job->theory_hash;
+                        });
+    double cost = (worker->queue.size() + worker->running.size() + 1.0) /
+                  worker->slots + (has_theory ? 0 : 1);
+    if(best_worker == nullptr || cost < best_cost) {
+      best_worker = worker.get();
+      best_cost = cost;
+    }
+  }
+  if(best_worker == nullptr) return false;
+  job->worker = best_worker;
+  job->is_running = false;
+  best_worker->queue.emplace_back(job);
+  return true;
+}
+
+void RemoteLemmaProcessor::Dispatch() {
+  std::unordered_map<Worker*, vector<shared_ptr<Job>>> jobs_of;
+  auto has_free_slot = [&jobs_of](Worker* worker) {
+    return static_cast<int>(worker->running.size() +
+                            jobs_of[worker].size()) < worker->slots;
+  };
+  for(auto& worker : workers_) {
+    while(worker->is_connected && !worker->queue.empty() &&
+          has_free_slot(worker.get())) {
+      jobs_of[worker.get()].emplace_back(worker->queue.front());
+      worker->queue.pop_front();
+    }
+  }
+  for(auto& worker : workers_) {
+    while(worker->is_connected && has_free_slot(worker.get())) {
+      Worker* victim = nullptr;
+      for(auto& other_worker : workers_) {
+        if(other_worker->queue.empty() ||
+           other_worker->queue.back()->tried_workers.count(worker.get()) > 0) {
+          continue;
+        }
+        if(victim == nullptr ||
+           other_worker->queue.size() > victim->queue.size()) {
+          victim = other_worker.get();
+        }
+      }
+      if(victim == nullptr) break;
+      jobs_of[worker.get()].emplace_back(victim->queue.back());
+      victim->queue.pop_back();
+    }
+  }
+
+  for(auto& [worker, jobs] : jobs_of) {
+    // One message per theory with all its jobs
+    vector<string> theory_hashes;
+    std::unordered_map<string, json> json_jobs_of;
+    for(auto& job : jobs) {
+      if(json_jobs_of.count(job->theory_hash) == 0) {
+        theory_hashes.emplace_back(job->theory_hash);
+        json_jobs_of[job->theory_hash] = json::array();
+      }
+      json_jobs_of[job->theory_hash].push_back(
+              {{"id", job->id},
+               {"lemma", job->lemma_job.GetLemmaName()},
+               {"heuristic", job->lemma_job.GetHeuristic()},
+               {"timeout", job->timeout}});
+      job->worker = worker;
+      job->is_running = true;
+      ++job->attempts;
+      job->tried_workers.insert(worker);
+      worker->running[job->id] = job;
+    }
+    for(const auto& theory_hash : theory_hashes) {
+      if(worker->theories.insert(theory_hash).second) {
+        Post(worker, {{"type", "theory"},
+                      {"hash", theory_hash},
+                      {"contents", theory_of_[theory_hash]}});
+      }
+      Post(worker, {{"type", "jobs"},
+                    {"theory", theory_hash},
+                    {"jobs", std::move(json_jobs_of[theory_hash])}});
+    }
+  }
+}
+
+void RemoteLemmaProcessor::Cancel(shared_ptr<Job> job) {
+  job->is_cancelled = true;
+  if(job->is_running) {
+    Post(job->worker, {{"type", "cancel"}, {"id", job->id}});
+    return;
+  }
+  auto& queue = job->worker->queue;
+  queue.erase(std::remove(queue.begin(), queue.end(), job), queue.end());
+  Finish(job, CreateFailedOutput(job->lemma_job.GetHeuristic(),
+                                 FailureReason::Cancelled, ""));
+}
+
+void RemoteLemmaProcessor::Finish(shared_ptr<Job> job,
+                                  const TamarinOutput& tamarin_output) {
+  job->tamarin_output = tamarin_output;
+  job->is_finished = true;
+  job_finished_.notify_all();
+}
+
+void RemoteLemmaProcessor::Post(Worker* worker, json message) {
+  worker->outbox.emplace_back(std::move(message));
+  worker->has_messages.notify_one();
+}
+
+void RemoteLemmaProcessor::WriteMessages(Worker* worker) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while(true) {
+    worker->has_messages.wait(lock, [worker] {
+      return !worker->outbox.empty() || !worker->is_connected;
+    });
+    if(!worker->is_connected) break;
+    auto message = std::move(worker->outbox.front());
+    worker->outbox.pop_front();
+    lock.unlock();
+    bool is_sent = SendMessage(worker->input, message);
+    lock.lock();
+    if(!is_sent) {
+      // The reader then sees the connection end and retries the jobs
+      if(worker->pid < 0) shutdown(worker->output, SHUT_RDWR);
+      break;
+    }
+  }
+}
+
+void RemoteLemmaProcessor::ReadResults(Worker* worker) {
+  json message;
+  while(ReceiveMessage(worker->output, message)) {
+    uint64_t id = 0;
+    TamarinOutput tamarin_output;
+    // Fields of an unexpected type make the json library throw. A worker
+    // that sends them breaks the protocol and is dropped like a lost one.
+    try {
+      if(message.value("type", "") != "result" || !message.contains("id") ||
+         !message["id"].is_number_unsigned()) {
+        continue;
+      }
+      id = message["id"].get<uint64_t>();
+      tamarin_output = ToTamarinOutput(message.value("output",
+                                                     json::object()));
+    } catch(const std::exception&) {
+      std::cerr << "Warning: invalid message from the worker '"
+                << worker->name << "'." << std::endl;
+      break;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = worker->running.find(id);
+    if(it == worker->running.end()) continue;
+    auto job = it->second;
+    worker->running.erase(it);
+    // Tamarin may crash because of its worker (e.g., for lack of memory)
+    if(tamarin_output.failure_reason == FailureReason::Crash &&
+       !job->is_cancelled && job->attempts < kMaxAttempts && Enqueue(job)) {
+      std::cerr << "Warning: Tamarin crashed on lemma '"
+                << job->lemma_job.GetLemmaName() << "' on the worker '"
+                << worker->name << "', retrying it on another worker."
+                << std::endl;
+    } else {
+      Finish(job, tamarin_output);
+    }
+    Dispatch();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  worker->is_connected = false;
+  worker->outbox.clear();
+  worker->has_messages.notify_all();
+  vector<shared_ptr<Job>> lost_jobs(worker->queue.begin(),
+                                    worker->queue.end());
+  for(const auto& [id, job] : worker->running) lost_jobs.emplace_back(job);
+  worker->queue.clear();
+  worker->running.clear();
+  if(!is_stopping_) {
+    std::cerr << "Warning: lost the worker '" << worker->name << "'";
+    if(!lost_jobs.empty()) {
+      std::cerr << ", retrying its " << lost_jobs.size()
+                << " job(s) on the other workers";
+    }
+    std::cerr << "." << std::endl;
+  }
+  for(auto& job : lost_jobs) {
+    job->is_running = false;
+    if(job->is_cancelled) {
+      Finish(job, CreateFailedOutput(job->lemma_job.GetHeuristic(),
+                                     FailureReason::Cancelled, ""));
+    } else if(job->attempts >= kMaxAttempts || !Enqueue(job)) {
+      Finish(job, CreateFailedOutput(job->lemma_job.GetHeuristic(),
+                                     FailureReason::Crash,
+                                     "lost the worker '" + worker->name +
+                                     "'"));
+    }
+  }
+  Dispatch();
+}
+
+TamarinOutput RemoteLemmaProcessor::DoProcessLemma(const LemmaJob& lemma_job) {
+  std::ostringstream theory_stream;
+  theory_stream << std::ifstream(lemma_job.GetSpthyFilePath()).rdbuf();
+  auto job = std::make_shared<Job>(lemma_job);
+  job->theory_hash = HashString(theory_stream.str());
+  job->timeout = lemma_job.GetTimeout() >= 0 ? lemma_job.GetTimeout() :
+                                               timeout_;
+  auto task_control = TaskControl::GetCurrent();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  job->id = next_job_id_++;
+  // The theory is kept until no job needs to send it anymore
+  if(theory_users_[job->theory_hash]++ == 0) {
+    theory_of_[job->theory_hash] = theory_stream.str();
+  }
+  if(Enqueue(job)) {
+    Dispatch();
+  } else {
+    Finish(job, CreateFailedOutput(lemma_job.GetHeuristic(),
+                                   FailureReason::Crash,
+                                   "no worker is connected"));
+  }
+  while(!job->is_finished) {
+    job_finished_.wait_for(lock, kCancelCheckInterval);
+    if(!job->is_finished && !job->is_cancelled && task_control != nullptr &&
+       task_control->IsCancelled()) {
+      Cancel(job);
+    }
+  }
+  if(--theory_users_[job->theory_hash] == 0) {
+    theory_users_.erase(job->theory_hash);
+    theory_of_.erase(job->theory_hash);
+  }
+  return job->tamarin_output;
+}
+
+} // namespace uttamarin
@@ -0,0 +1,399 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "remote_result_cache.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "nlohmann/json.hpp"
+
+#include "tcp_socket.h"
+#include "worker_protocol.h"
+
+using std::string;
+using json = nlohmann::json;
+
+namespace uttamarin {
+
+namespace {
+
+// Seconds after which a request to the cache gives up
+const int kRequestTimeout = 10;
+
+// Largest header and body of a request that the cache server accepts
+const size_t kMaxHeaderSize = 16 * 1024;
+const size_t kMaxBodySize = 64 * 1024 * 1024;
+
+// Requests that the cache server handles at a time, which bounds its memory
+// to this many bodies
+const int kMaxConcurrentRequests = 16;
+
+bool SendAll(int connection, const string& data) {
+  size_t sent = 0;
+  while(sent < data.size()) {
+    auto result = send(connection, data.data() + sent, data.size() - sent,
+                       MSG_NOSIGNAL);
+    if(result < 0 && errno == EINTR) continue;
+    if(result <= 0) return false;
+    sent += result;
+  }
+  return true;
+}
+
+// Reads from the connection until 'data' has at least the given size or the
+// connection ends. Returns false if the connection ends first.
+bool ReceiveAtLeast(int connection, string& data, size_t size) {
+  while(data.size() < size) {
+    char buffer[65536];
+    auto received = recv(connection, buffer, sizeof(buffer), 0);
+    if(received < 0 && errno == EINTR) continue;
+    if(received <= 0) return false;
+    data.append(buffer, received);
+  }
+  return true;
+}
+
+// Returns the value of the given header (e.g., "content-length") in the
+// given HTTP header section or the empty string
+string FindHeader(const string& headers, const string& name) {
+  std::istringstream lines(headers);
+  for(string line;std::getline(lines, line);) {
+    auto colon = line.find(':');
+    if(colon == string::npos) continue;
+    auto header_name = line.substr(0, colon);
+    std::transform(header_name.begin(), header_name.end(),
+                   header_name.begin(), [](unsigned char c) {
+                     return std::tolower(c);
+                   });
+    if(header_name != name) continue;
+    auto value = line.substr(colon + 1);
+    value.erase(0, value.find_first_not_of(" \t"));
+    value.erase(value.find_last_not_of(" \t\r") + 1);
+    return value;
+  }
+  return "";
+}
+
+// Keys are hashes (see CachingLemmaProcessor), which keeps requests from
+// reaching files outside of the cache
+bool IsValidKey(const string& key) {
+  return !key.empty() && key.size() <= 64 &&
+         key.find_first_not_of("0123456789abcdef") == string::npos;
+}
+
+// Compares the tokens in a time that does not depend on where they differ
+bool IsSameToken(const string& token, const string& expected_token) {
+  if(token.size() != expected_token.size()) return false;
+  unsigned char difference = 0;
+  for(size_t i = 0;i < token.size();++i) {
+    difference |= token[i] ^ expected_token[i];
+  }
+  return difference == 0;
+}
+
+void SendResponse(int connection, const string& status,
+                  const string& body="") {
+  SendAll(connection, "HTTP/1.0 " + status + "\r\n"
+                      "Content-Type: application/octet-stream\r\n"
+                      "Content-Length: " + std::to_string(body.size()) +
+                      "\r\n\r\n" + body);
+}
+
+// Handles one request of a RemoteResultCache: GET or PUT of
+// .../results/<key> or .../proofs/<key>
+void HandleCacheRequest(int connection, const string& directory,
+                        const string& write_token) {
+  timeval time_limit{kRequestTimeout, 0};
+  setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &time_limit,
+             sizeof(time_limit));
+  string data;
+  size_t header_end = string::npos;
+  while((header_end = data.find("\r\n\r\n")) == string::npos) {
+    if(data.size() > kMaxHeaderSize ||
+       !ReceiveAtLeast(connection, data, data.size() + 1)) {
+      close(connection);
+      return;
+    }
+  }
+  auto headers = data.substr(0, header_end);
+  std::istringstream request_line(headers.substr(0, headers.find('\n')));
+  string method;
+  string target;
+  request_line >> method >> target;
+
+  auto slash = target.rfind('/');
+  auto kind_slash = slash == string::npos || slash == 0 ?
+                    string::npos : target.rfind('/', slash - 1);
+  auto key = slash == string::npos ? "" : target.substr(slash + 1);
+  auto kind = kind_slash == string::npos ? "" :
+              target.substr(kind_slash + 1, slash - kind_slash - 1);
+  if((kind != "results" && kind != "proofs") || !IsValidKey(key)) {
+    SendResponse(connection, "404 Not Found");
+    close(connection);
+    return;
+  }
+  auto file_path = directory + "/" + kind + "/" + key;
+
+  if(method == "GET") {
+    std::ifstream file(file_path, std::ios::binary);
+    if(!file) {
+      SendResponse(connection, "404 Not Found");
+    } else {
+      std::ostringstream contents;
+      contents << file.rdbuf();
+      SendResponse(connection, "200 OK", contents.str());
+    }
+  } else if(method == "PUT" &&
+            (write_token.empty() ||
+             !IsSameToken(FindHeader(headers, "authorization"),
+                          "Bearer " + write_token))) {
+    SendResponse(connection, "403 Forbidden");
+  } else if(method == "PUT") {
+    auto content_length = FindHeader(headers, "content-length");
+    size_t body_size = 0;
+    if(content_length.empty() || content_length.size() > 18 ||
+       content_length.find_first_not_of("0123456789") != string::npos ||
+       (body_size = std::stoull(content_length)) > kMaxBodySize) {
+      SendResponse(connection, "413 Payload Too Large");
+    } else if(!ReceiveAtLeast(connection, data,
+                              header_end + 4 + body_size)) {
+      SendResponse(connection, "400 Bad Request");
+    } else {
+      // Readers must never see a partial file
+      std::ostringstream temp_path;
+      temp_path << file_path << ".tmp." << std::this_thread::get_id();
+      {
+        std::ofstream file(temp_path.str(), std::ios::binary);
+        file.write(data.data() + header_end + 4, body_size);
+      }
+      if(std::rename(temp_path.str().c_str(), file_path.c_str()) == 0) {
+        SendResponse(connection, "201 Created");
+      } else {
+        std::remove(temp_path.str().c_str());
+        SendResponse(connection, "500 Internal Server Error");
+      }
+    }
+  } else {
+    SendResponse(connection, "405 Method Not Allowed");
+  }
+  close(connection);
+}
+
+} // namespace
+
+RemoteResultCache::RemoteResultCache(const string& url,
+                                     const string& write_token) :
+  url_(url),
+  write_token_(write_token),
+  is_valid_(false),
+  is_unreachable_(false),
+  is_refusing_(false) {
+  const string scheme = "http://";
+  if(url.rfind(scheme, 0) != 0) return;
+  auto authority_end = url.find('/', scheme.size());
+  auto authority = url.substr(scheme.size(),
+                              authority_end == string::npos ?
+                              string::npos : authority_end - scheme.size());
+  path_ = authority_end == string::npos ? "" : url.substr(authority_end);
+  while(!path_.empty() && path_.back() == '/') path_.pop_back();
+  if(!SplitAddress(authority, host_, port_)) {
+    host_ = authority;
+    port_ = "80";
+  }
+  is_valid_ = !host_.empty() &&
+              host_.find_first_of(" \t:@") == string::npos;
+}
+
+bool RemoteResultCache::IsValid() const {
+  return is_valid_;
+}
+
+std::optional<TamarinOutput> RemoteResultCache::Find(const string& key) {
+  string response_body;
+  if(SendRequest("GET", "/results/" + key, "", response_body) != 200) {
+    return std::nullopt;
+  }
+  auto json_output = json::parse(response_body, nullptr, false);
+  if(!json_output.is_object()) return std::nullopt;
+  return ToTamarinOutput(json_output);
+}
+
+void RemoteResultCache::Insert(const string& key,
+                               const TamarinOutput& tamarin_output) {
+  if(write_token_.empty()) return;
+  string response_body;
+  SendRequest("PUT", "/results/" + key, ToJson(tamarin_output).dump(),
+              response_body);
+}
+
+std::optional<string> RemoteResultCache::FindProof(const string& key) {
+  string response_body;
+  if(SendRequest("GET", "/proofs/" + key, "", response_body) != 200) {
+    return std::nullopt;
+  }
+  return response_body;
+}
+
+void RemoteResultCache::InsertProof(const string& key, const string& proof) {
+  if(write_token_.empty()) return;
+  string response_body;
+  SendRequest("PUT", "/proofs/" + key, proof, response_body);
+}
+
+int RemoteResultCache::SendRequest(const string& method, const string& path,
+                                   const string& body,
+                                   string& response_body) {
+  if(!is_valid_ || is_unreachable_) return -1;
+  // A cache that is down must not slow down every lemma
+  auto connection = ConnectToAddress(host_, port_, kRequestTimeout);
+  string request = method + " " + path_ + path + " HTTP/1.0\r\n"
+                   "Host: " + host_ + ":" + port_ + "\r\n";
+  if(method == "PUT") {
+    request += "Authorization: Bearer " + write_token_ + "\r\n"
+               "Content-Type: application/octet-stream\r\n"
+               "Content-Length: " + std::to_string(body.size()) + "\r\n";
+  }
+  request += "\r\n" + body;
+  string response;
+  if(connection >= 0 && SendAll(connection, request)) {
+    // HTTP/1.0 servers close the connection after the response
+    while(ReceiveAtLeast(connection, response, response.size() + 1)) {}
+  }
+  if(connection >= 0) close(connection);
+
+  auto header_end = response.find("\r\n\r\n");
+  int status = -1;
+  if(header_end != string::npos) {
+    std::istringstream status_line(response.substr(0, response.find('\n')));
+    string version;
+    status_line >> version >> status;
+    if(version.rfind("HTTP/", 0) != 0) status = -1;
+  }
+  if(status < 0) {
+    if(!is_unreachable_.exchange(true)) {
+      std::cerr << "Warning: cannot reach the remote result cache '" << url_
+                << "', running without it." << std::endl;
+    }
+    return -1;
+  }
+  if(method == "PUT" && status / 100 != 2 && !is_refusing_.exchange(true)) {
+    std::cerr << "Warning: the remote result cache '" << url_ << "' refuses "
+              << "to store results (HTTP status " << status << ")."
+              << std::endl;
+  }
+  response_body = response.substr(header_end + 4);
+  auto content_length = FindHeader(response.substr(0, header_end),
+                                   "content-length");
+  if(!content_length.empty() && content_length.size() <= 18 &&
+     content_length.find_first_not_of("0123456789") == string::npos) {
+    response_body = response_body.substr(0, std::stoull(content_length));
+  }
+  return status;
+}
+
+std::optional<string> ReadCacheToken(const string& token_file_path) {
+  std::ifstream token_file(token_file_path);
+  std::ostringstream contents;
+  contents << token_file.rdbuf();
+  auto token = contents.str();
+  token.erase(0, token.find_first_not_of(" \t\r\n"));
+  token.erase(token.find_last_not_of(" \t\r\n") + 1);
+  if(!token_file || token.empty() ||
+     token.find_first_of("\r\n") != string::npos) {
+    return std::nullopt;
+  }
+  return token;
+}
+
+bool RunCacheServer(const string& listen_address, const string& directory,
+                    const string& write_token) {
+  std::signal(SIGPIPE, SIG_IGN);
+  for(const auto& subdirectory : {directory, directory + "/results",
+                                  directory + "/proofs"}) {
+    if(mkdir(subdirectory.c_str(), 0755) != 0 && errno != EEXIST) {
+      std::cerr << "Error: cannot create the directory '" << subdirectory
+                << "': " << std::strerror(errno) << std::endl;
+      return false;
+    }
+  }
+  auto server_socket = ListenOnAddress(listen_address);
+  if(server_socket < 0) return false;
+  std::cout << "Serving the result cache in '" << directory << "' on '"
+            << listen_address << "'"
+            << (write_token.empty() ? " (read-only, no --token_file)" : "")
+            << "." << std::endl;
+
+  std::mutex mutex;
+  std::condition_variable request_finished;
+  int running_requests = 0;
+  while(true) {
+    {
+      // Further connections wait in the backlog of the socket
+      std::unique_lock<std::mutex> lock(mutex);
+      request_finished.wait(lock, [&] {
+        return running_requests < kMaxConcurrentRequests;
+      });
+    }
+    auto connection = accept4(server_socket, nullptr, nullptr, SOCK_CLOEXEC);
+    if(connection < 0) {
+      if(errno == EINTR || errno == ECONNABORTED) continue;
+      std::cerr << "Error: cannot accept connections: "
+                << std::strerror(errno) << std::endl;
+      close(server_socket);
+      // The threads of the requests refer to the locals
+      std::unique_lock<std::mutex> lock(mutex);
+      request_finished.wait(lock, [&] { return running_requests == 0; });
+      return false;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++running_requests;
+    }
+    std::thread([&, connection] {
+      HandleCacheRequest(connection, directory, write_token);
+      std::lock_guard<std::mutex> lock(mutex);
+      --running_requests;
+      request_finished.notify_all();
+    }).detach();
+  }
+}
+
+} // namespace uttamarin
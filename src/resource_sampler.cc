@@ -0,0 +1,251 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "resource_sampler.h"
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tracing.h"
+#include "worker_pool.h"
+
+using std::string;
+using std::vector;
+
+namespace uttamarin {
+
+namespace {
+
+// The fields of /proc/<pid>/stat that the sampler needs
+struct ProcessStat {
+  int parent_pid;
+  long major_faults; // including those of waited-for children
+  long long cpu_ticks; // user and system time, including waited-for children
+};
+
+bool ReadProcessStat(int pid, ProcessStat& process_stat) {
+  std::ifstream stat_stream{"/proc/" + std::to_string(pid) + "/stat"};
+  string stat;
+  if(!std::getline(stat_stream, stat)) return false;
+  // The command name in parentheses may contain spaces
+  auto command_end = stat.rfind(')');
+  if(command_end == string::npos) return false;
+  std::istringstream fields{stat.substr(command_end + 1)};
+  // Fields 3 to 17 of proc(5): state, ppid, pgrp, session, tty_nr, tpgid,
+  // flags, minflt, cminflt, majflt, cmajflt, utime, stime, cutime, cstime
+  string state;
+  long long skipped, major_faults, child_major_faults;
+  long long user_time, system_time, child_user_time, child_system_time;
+  fields >> state >> process_stat.parent_pid >> skipped >> skipped >> skipped
+         >> skipped >> skipped >> skipped >> skipped >> major_faults
+         >> child_major_faults >> user_time >> system_time
+         >> child_user_time >> child_system_time;
+  if(!fields) return false;
+  process_stat.major_faults = major_faults + child_major_faults;
+  process_stat.cpu_ticks = user_time + system_time + child_user_time +
+                           child_system_time;
+  return true;
+}
+
+// Returns the resident memory of the given process in KB (from statm)
+long ReadResidentMemory(int pid) {
+  std::ifstream statm_stream{"/proc/" + std::to_string(pid) + "/statm"};
+  long size, resident_pages;
+  if(!(statm_stream >> size >> resident_pages)) return 0;
+  return resident_pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Adds the storage I/O of the given process to the sample (if /proc exposes
+// it for the process)
+void AddStorageIo(int pid, ResourceSample& sample) {
+  std::ifstream io_stream{"/proc/" + std::to_string(pid) + "/io"};
+  string key;
+  long long value;
+  while(io_stream >> key >> value) {
+    if(key == "read_bytes:") sample.read_bytes += value;
+    else if(key == "write_bytes:") sample.write_bytes += value;
+  }
+}
+
+// Reads the stat of all processes on the system
+std::unordered_map<int, ProcessStat> ReadAllProcessStats() {
+  std::unordered_map<int, ProcessStat> process_stats;
+  DIR* proc_directory = opendir("/proc");
+  if(proc_directory == nullptr) return process_stats;
+  while(auto entry = readdir(proc_directory)) {
+    if(!std::isdigit(static_cast<unsigned char>(entry->d_name[0]))) continue;
+    int pid = std::stoi(entry->d_name);
+    ProcessStat process_stat;
+    if(ReadProcessStat(pid, process_stat)) process_stats[pid] = process_stat;
+  }
+  closedir(proc_directory);
+  return process_stats;
+}
+
+// Returns the given process and all its subprocesses
+vector<int> GetProcessTree(
+        int root_pid,
+        std::unordered_map<int, vector<int>>& children_of) {
+  vector<int> pids = {root_pid};
+  for(size_t i = 0; i < pids.size(); ++i) {
+    for(auto child : children_of[pids[i]]) pids.emplace_back(child);
+  }
+  return pids;
+}
+
+std::unordered_map<int, vector<int>> GetChildren(
+        const std::unordered_map<int, ProcessStat>& process_stats) {
+  std::unordered_map<int, vector<int>> children_of;
+  for(const auto& [pid, process_stat] : process_stats) {
+    children_of[process_stat.parent_pid].emplace_back(pid);
+  }
+  return children_of;
+}
+
+} // namespace
+
+long ReadProcessTreeMemory(int pid) {
+  auto children_of = GetChildren(ReadAllProcessStats());
+  long memory = 0;
+  for(auto process : GetProcessTree(pid, children_of)) {
+    memory += ReadResidentMemory(process);
+  }
+  return memory;
+}
+
+ResourceSampler::ResourceSampler(int interval, bool is_keeping_samples) :
+  interval_(interval),
+  is_keeping_samples_(is_keeping_samples),
+  is_stopping_(false) {
+  thread_ = std::thread(&ResourceSampler::Run, this);
+}
+
+ResourceSampler::~ResourceSampler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  stop_requested_.notify_all();
+  thread_.join();
+}
+
+void ResourceSampler::Watch(int pid, const string& label) {
+  auto worker_index = WorkerPool::GetCurrentWorkerIndex();
+  auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  watched_processes_[pid] = WatchedProcess{
+          label,
+          worker_index < 0 ? " (main)" :
+          " (worker " + std::to_string(worker_index) + ")",
+          now, now, 0, {}};
+}
+
+vector<ResourceSample> ResourceSampler::Unwatch(int pid) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = watched_processes_.find(pid);
+  if(it == watched_processes_.end()) return {};
+  auto watched_process = std::move(it->second);
+  watched_processes_.erase(it);
+  if(!is_keeping_samples_) watched_process.samples.clear();
+  // Let the counters drop to zero between two runs on the same track
+  tracing::RecordCounter("memory" + watched_process.counter_suffix,
+                         {{"rss_mb", 0}});
+  tracing::RecordCounter("cpu" + watched_process.counter_suffix,
+                         {{"cores", 0}});
+  return watched_process.samples;
+}
+
+vector<ResourceSampler::RunningProcess>
+ResourceSampler::GetRunningProcesses() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  vector<RunningProcess> running_processes;
+  for(const auto& [pid, watched_process] : watched_processes_) {
+    if(watched_process.samples.empty()) continue;
+    running_processes.emplace_back(RunningProcess{
+            watched_process.label, watched_process.samples.back()});
+  }
+  return running_processes;
+}
+
+void ResourceSampler::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while(!is_stopping_) {
+    stop_requested_.wait_for(lock, std::chrono::milliseconds(interval_));
+    if(is_stopping_ || watched_processes_.empty()) continue;
+    lock.unlock();
+    SampleProcesses();
+    lock.lock();
+  }
+}
+
+void ResourceSampler::SampleProcesses() {
+  auto process_stats = ReadAllProcessStats();
+  auto now = std::chrono::steady_clock::now();
+  auto children_of = GetChildren(process_stats);
+  static const double kTicksPerSecond = sysconf(_SC_CLK_TCK);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for(auto& [root_pid, watched_process] : watched_processes_) {
+    if(process_stats.count(root_pid) == 0) continue;
+    ResourceSample sample{
+            std::chrono::duration<double>(
+                    now - watched_process.start_time).count(), 0, 0, 0, 0, 0};
+    long long cpu_ticks = 0;
+    for(auto pid : GetProcessTree(root_pid, children_of)) {
+      const auto& process_stat = process_stats[pid];
+      cpu_ticks += process_stat.cpu_ticks;
+      sample.major_faults += process_stat.major_faults;
+      sample.rss += ReadResidentMemory(pid);
+      AddStorageIo(pid, sample);
+    }
+    double elapsed_time = std::chrono::duration<double>(
+            now - watched_process.last_sample_time).count();
+    if(elapsed_time > 0) {
+      sample.cpu_utilization =
+              (cpu_ticks - watched_process.last_cpu_ticks) /
+              kTicksPerSecond / elapsed_time;
+    }
+    watched_process.last_cpu_ticks = cpu_ticks;
+    watched_process.last_sample_time = now;
+    if(!is_keeping_samples_) watched_process.samples.clear();
+    watched_process.samples.emplace_back(sample);
+
+    tracing::RecordCounter("memory" + watched_process.counter_suffix,
+                           {{"rss_mb", sample.rss / 1024.0}});
+    tracing::RecordCounter("cpu" + watched_process.counter_suffix,
+                           {{"cores", sample.cpu_utilization}});
+    tracing::RecordCounter("major faults" + watched_process.counter_suffix,
+                           {{"major_faults",
+                             static_cast<double>(sample.major_faults)}});
+  }
+}
+
+} // namespace uttamarin
@@ -0,0 +1,46 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "result_cache.h"
+
+#include <mutex>
+#include <optional>
+#include <string>
+
+using std::string;
+
+namespace uttamarin {
+
+std::optional<TamarinOutput> ResultCache::Find(const string& key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = output_of_.find(key);
+  if(it == output_of_.end()) return std::nullopt;
+  return it->second;
+}
+
+void ResultCache::Insert(const string& key,
+                         const TamarinOutput& tamarin_output) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  output_of_[key] = tamarin_output;
+}
+
+} // namespace uttamarin
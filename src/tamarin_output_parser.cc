@@ -0,0 +1,243 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "tamarin_output_parser.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "utility.h"
+
+using std::istream;
+using std::string;
+
+namespace uttamarin {
+
+namespace {
+
+const std::string_view kSummaryHeader = "summary of summaries:";
+
+// Size of the first window at the end of the output that FindSummarySection
+// searches (the summary of a theory with 100 lemmas is about 10 KB)
+const size_t kInitialSummaryWindow = 64 * 1024;
+
+bool StartsWith(const string& text, const string& prefix) {
+  return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Parses a summary line such as "lemma_name (all-traces): verified (7 steps)"
+// if it belongs to the given lemma. Returns false otherwise.
+bool ParseLemmaLine(const string& line, const string& lemma_name,
+                    TamarinOutput& tamarin_output) {
+  if(!StartsWith(line, lemma_name + " (")) return false;
+  auto status_start = line.find("): ", lemma_name.size());
+  if(status_start == string::npos) return false;
+  auto status = line.substr(status_start + 3);
+
+  if(StartsWith(status, "falsified")) {
+    tamarin_output.result = ProverResult::False;
+  } else if(StartsWith(status, "verified")) {
+    tamarin_output.result = ProverResult::True;
+  } else {
+    tamarin_output.result = ProverResult::Unknown;
+  }
+  auto steps_start = status.rfind('(');
+  if(steps_start != string::npos &&
+     status.find(" steps)", steps_start) != string::npos) {
+    tamarin_output.steps = std::atoi(status.c_str() + steps_start + 1);
+  }
+  return true;
+}
+
+bool IsParseError(const string& error_output) {
+  return error_output.find("parse error") != string::npos ||
+         (error_output.find("(line ") != string::npos &&
+          (error_output.find("unexpected") != string::npos ||
+           error_output.find("expecting") != string::npos));
+}
+
+} // namespace
+
+bool ParseTamarinOutput(istream& tamarin_stream,
+                        const string& lemma_name,
+                        TamarinOutput& tamarin_output) {
+  tamarin_output.result = ProverResult::Unknown;
+  bool has_summary = false;
+  string line;
+  while(std::getline(tamarin_stream, line)) {
+    line = Trim(line);
+    if(line == "summary of summaries:") {
+      // Only the last summary counts
+      has_summary = true;
+      tamarin_output.result = ProverResult::Unknown;
+      tamarin_output.steps = -1;
+      tamarin_output.processing_time = -1;
+      tamarin_output.warnings.clear();
+    } else if(!has_summary) {
+      continue;
+    } else if(StartsWith(line, "processing time:")) {
+      tamarin_output.processing_time =
+              std::strtod(line.c_str() + 16, nullptr);
+    } else if(StartsWith(line, "WARNING")) {
+      tamarin_output.warnings.emplace_back(line);
+    } else {
+      ParseLemmaLine(line, lemma_name, tamarin_output);
+    }
+  }
+  return has_summary;
+}
+
+bool ParseGcStatistics(istream& rts_stream, GcStatistics& gc_statistics) {
+  // The statistics form a Haskell list of pairs, one pair per line, e.g.,
+  //  [("bytes allocated", "104857600")
+  //  ,("max_bytes_used", "2097152")
+  std::unordered_map<string, double> value_of;
+  string line;
+  while(std::getline(rts_stream, line)) {
+    auto key_start = line.find("(\"");
+    if(key_start == string::npos) continue;
+    key_start += 2;
+    auto key_end = line.find("\", \"", key_start);
+    if(key_end == string::npos) continue;
+    value_of[line.substr(key_start, key_end - key_start)] =
+            std::strtod(line.c_str() + key_end + 4, nullptr);
+  }
+  if(value_of.count("bytes allocated") == 0) return false;
+
+  auto value = [&value_of](const string& key, const string& old_key="") {
+    if(value_of.count(key) != 0) return value_of[key];
+    return value_of.count(old_key) != 0 ? value_of[old_key] : 0.0;
+  };
+  gc_statistics.bytes_allocated =
+          static_cast<long long>(value("bytes allocated"));
+  gc_statistics.max_residency = static_cast<long long>(value("max_bytes_used"));
+  gc_statistics.number_of_gcs = static_cast<long long>(value("num_GCs"));
+  gc_statistics.gc_cpu_time = value("GC_cpu_seconds");
+  // GHC renamed mutator_cpu_seconds to mut_cpu_seconds
+  gc_statistics.mutator_cpu_time =
+          value("mut_cpu_seconds", "mutator_cpu_seconds");
+  double total_cpu_time = value("total_cpu_seconds");
+  if(total_cpu_time > 0) {
+    gc_statistics.gc_time_fraction = gc_statistics.gc_cpu_time /
+                                     total_cpu_time;
+    gc_statistics.productivity = gc_statistics.mutator_cpu_time /
+                                 total_cpu_time;
+  }
+  // As in the "Parallel GC work balance" of +RTS -s
+  double capabilities = value("n_capabilities");
+  double copied_bytes = value("par_copied_bytes");
+  if(capabilities > 1 && copied_bytes > 0) {
+    gc_statistics.parallel_gc_balance =
+            (value("cumulative_par_balanced_copied_bytes") / copied_bytes -
+             1) / (capabilities - 1);
+  }
+  return true;
+}
+
+std::string_view FindSummarySection(std::string_view tamarin_output) {
+  const char* data = tamarin_output.data();
+  const char* end = data + tamarin_output.size();
+  for(size_t window = kInitialSummaryWindow;;window *= 2) {
+    auto start = tamarin_output.size() > window ? end - window : data;
+    const char* last_header = nullptr;
+    for(auto pos = start;pos < end;) {
+      auto header = static_cast<const char*>(
+              memmem(pos, end - pos, kSummaryHeader.data(),
+                     kSummaryHeader.size()));
+      if(header == nullptr) break;
+      last_header = header;
+      pos = header + kSummaryHeader.size();
+    }
+    if(last_header != nullptr) {
+      auto line_end = static_cast<const char*>(
+              memrchr(data, '\n', last_header - data));
+      return tamarin_output.substr(line_end == nullptr ? 0 :
+                                   line_end + 1 - data);
+    }
+    if(start == data) return {};
+  }
+}
+
+std::optional<string> ReadSummarySection(const string& tamarin_output_path) {
+  int file_descriptor = open(tamarin_output_path.c_str(), O_RDONLY);
+  if(file_descriptor == -1) return std::nullopt;
+  struct stat file_status;
+  if(fstat(file_descriptor, &file_status) == -1 || file_status.st_size == 0) {
+    close(file_descriptor);
+    return std::nullopt;
+  }
+  size_t size = file_status.st_size;
+  auto data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+  close(file_descriptor);
+  if(data == MAP_FAILED) return std::nullopt;
+
+  auto summary = FindSummarySection(
+          std::string_view{static_cast<const char*>(data), size});
+  std::optional<string> result;
+  if(!summary.empty()) result = string{summary};
+  munmap(data, size);
+  return result;
+}
+
+FailureReason DetermineFailureReason(ProverResult result,
+                                     bool has_summary,
+                                     int exit_code,
+                                     const string& error_output) {
+  if(result != ProverResult::Unknown) return FailureReason::None;
+  // A Tamarin that was killed otherwise (e.g., for lack of memory) crashed
+  if(exit_code == kTimeoutExitCode) return FailureReason::Timeout;
+  if(has_summary) return FailureReason::Incomplete;
+  if(IsParseError(error_output)) return FailureReason::ParseError;
+  return FailureReason::Crash;
+}
+
+string ToString(const FailureReason& failure_reason) {
+  switch(failure_reason) {
+    case FailureReason::Timeout: return "timeout";
+    case FailureReason::Incomplete: return "incomplete";
+    case FailureReason::ParseError: return "parse error";
+    case FailureReason::Crash: return "crash";
+    case FailureReason::Cancelled: return "cancelled";
+    default: return "";
+  }
+}
+
+FailureReason ToFailureReason(const string& name) {
+  if(name == "timeout") return FailureReason::Timeout;
+  if(name == "incomplete") return FailureReason::Incomplete;
+  if(name == "parse error") return FailureReason::ParseError;
+  if(name == "crash") return FailureReason::Crash;
+  if(name == "cancelled") return FailureReason::Cancelled;
+  return FailureReason::None;
+}
+
+} // namespace uttamarin
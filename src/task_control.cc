@@ -0,0 +1,106 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "task_control.h"
+
+#include <signal.h>
+
+#include <chrono>
+#include <mutex>
+
+using steady_clock = std::chrono::steady_clock;
+
+namespace uttamarin {
+
+namespace {
+
+thread_local TaskControl* current_task_control = nullptr;
+
+} // namespace
+
+TaskControl::TaskControl() :
+  is_suspended_(false),
+  is_cancelled_(false),
+  suspended_time_(0) {
+}
+
+TaskControl* TaskControl::GetCurrent() {
+  return current_task_control;
+}
+
+void TaskControl::SetCurrent(TaskControl* task_control) {
+  current_task_control = task_control;
+}
+
+void TaskControl::Suspend() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if(is_suspended_) return;
+  is_suspended_ = true;
+  suspend_time_ = steady_clock::now();
+  for(auto process_group : process_groups_) kill(-process_group, SIGSTOP);
+}
+
+void TaskControl::Resume() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if(!is_suspended_) return;
+  is_suspended_ = false;
+  suspended_time_ += std::chrono::duration<double>(
+          steady_clock::now() - suspend_time_).count();
+  for(auto process_group : process_groups_) kill(-process_group, SIGCONT);
+}
+
+bool TaskControl::IsSuspended() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return is_suspended_;
+}
+
+void TaskControl::Cancel() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  is_cancelled_ = true;
+  for(auto process_group : process_groups_) kill(-process_group, SIGKILL);
+}
+
+bool TaskControl::IsCancelled() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return is_cancelled_;
+}
+
+double TaskControl::GetSuspendedTime() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if(!is_suspended_) return suspended_time_;
+  return suspended_time_ + std::chrono::duration<double>(
+          steady_clock::now() - suspend_time_).count();
+}
+
+void TaskControl::AddProcessGroup(int process_group) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  process_groups_.insert(process_group);
+  if(is_cancelled_) kill(-process_group, SIGKILL);
+  else if(is_suspended_) kill(-process_group, SIGSTOP);
+}
+
+void TaskControl::RemoveProcessGroup(int process_group) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  process_groups_.erase(process_group);
+}
+
+} // namespace uttamarin
@@ -0,0 +1,138 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "tcp_socket.h"
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+using std::string;
+
+namespace uttamarin {
+
+namespace {
+
+// Number of connections that may wait for the socket to accept them
+const int kConnectionBacklog = 16;
+
+} // namespace
+
+bool SplitAddress(const string& address, string& host, string& port) {
+  auto colon = address.rfind(':');
+  if(colon == string::npos || colon == 0 || colon + 1 == address.size() ||
+     address.find_first_of(" \t") != string::npos ||
+     address.find_first_not_of("0123456789", colon + 1) != string::npos) {
+    return false;
+  }
+  host = address.substr(0, colon);
+  port = address.substr(colon + 1);
+  if(host.size() > 2 && host.front() == '[' && host.back() == ']') {
+    host = host.substr(1, host.size() - 2);
+  }
+  return true;
+}
+
+int ListenOnAddress(const string& listen_address) {
+  string host;
+  string port;
+  if(!SplitAddress(listen_address, host, port)) {
+    std::cerr << "Error: '" << listen_address << "' is no address of the "
+              << "form HOST:PORT." << std::endl;
+    return -1;
+  }
+  addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  addrinfo* addresses = nullptr;
+  if(getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+    std::cerr << "Error: cannot resolve '" << listen_address << "'."
+              << std::endl;
+    return -1;
+  }
+  int server_socket = -1;
+  for(auto address = addresses;address != nullptr;
+      address = address->ai_next) {
+    server_socket = socket(address->ai_family,
+                           address->ai_socktype | SOCK_CLOEXEC,
+                           address->ai_protocol);
+    if(server_socket < 0) continue;
+    int reuse = 1;
+    setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &reuse,
+               sizeof(reuse));
+    if(bind(server_socket, address->ai_addr, address->ai_addrlen) == 0 &&
+       listen(server_socket, kConnectionBacklog) == 0) {
+      break;
+    }
+    close(server_socket);
+    server_socket = -1;
+  }
+  freeaddrinfo(addresses);
+  if(server_socket < 0) {
+    std::cerr << "Error: cannot listen on '" << listen_address << "': "
+              << std::strerror(errno) << std::endl;
+  }
+  return server_socket;
+}
+
+int ConnectToAddress(const string& host, const string& port, int timeout) {
+  addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addresses = nullptr;
+  if(getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+    return -1;
+  }
+  int connection = -1;
+  for(auto address = addresses;address != nullptr;
+      address = address->ai_next) {
+    connection = socket(address->ai_family,
+                        address->ai_socktype | SOCK_CLOEXEC,
+                        address->ai_protocol);
+    if(connection < 0) continue;
+    if(timeout > 0) {
+      // On Linux, the send timeout applies to connecting as well
+      timeval time_limit{timeout, 0};
+      setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &time_limit,
+                 sizeof(time_limit));
+      setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &time_limit,
+                 sizeof(time_limit));
+    }
+    if(connect(connection, address->ai_addr, address->ai_addrlen) == 0) break;
+    close(connection);
+    connection = -1;
+  }
+  freeaddrinfo(addresses);
+  return connection;
+}
+
+} // namespace uttamarin
@@ -0,0 +1,123 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "tenant_accounting.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+#include "lemma_processor.h"
+#include "output_writer.h"
+
+using std::string;
+using json = nlohmann::json;
+
+namespace uttamarin {
+
+namespace {
+
+// Returns the given number of seconds in hours with two decimals
+string ToHoursString(double seconds) {
+  std::ostringstream hours_stream;
+  hours_stream << std::fixed << std::setprecision(2) << seconds / 3600;
+  return hours_stream.str();
+}
+
+} // namespace
+
+TenantAccounting::TenantAccounting(const string& accounting_file_path) :
+  accounting_file_path_(accounting_file_path) {
+  if(accounting_file_path_ == "") return;
+  std::ifstream accounting_file(accounting_file_path_);
+  string line;
+  while(std::getline(accounting_file, line)) {
+    auto job = json::parse(line, nullptr, false);
+    if(!job.is_object()) continue;
+    AddUsage(job.value("tenant", ""), job.value("cpu_time", 0.0),
+             job.value("wall_time", 0.0));
+  }
+}
+
+void TenantAccounting::AddJob(const string& tenant, const string& lemma_name,
+                              const TamarinOutput& tamarin_output) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  AddUsage(tenant, tamarin_output.cpu_time, tamarin_output.wall_time);
+  if(accounting_file_path_ == "") return;
+  auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count();
+  std::ofstream accounting_file(accounting_file_path_, std::ios::app);
+  accounting_file << json{{"timestamp", timestamp},
+                          {"tenant", tenant},
+                          {"lemma", lemma_name},
+                          {"cpu_time", tamarin_output.cpu_time},
+                          {"wall_time", tamarin_output.wall_time}}.dump()
+                  << std::endl;
+}
+
+std::map<string, TenantUsage> TenantAccounting::GetUsage() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return usage_of_;
+}
+
+void TenantAccounting::AddUsage(const string& tenant, double cpu_time,
+                                double wall_time) {
+  auto& usage = usage_of_[tenant];
+  ++usage.jobs;
+  usage.cpu_time += cpu_time;
+  usage.wall_time += wall_time;
+}
+
+void PrintAccountingReport(
+        const std::map<string, TenantUsage>& usage_of_tenants,
+        OutputWriter& output_writer) {
+  double total_cpu_time = 0;
+  for(const auto& [tenant, usage] : usage_of_tenants) {
+    total_cpu_time += usage.cpu_time;
+  }
+  output_writer << std::left << std::setw(20) << "Tenant" << std::right
+                << std::setw(8) << "Jobs" << std::setw(12) << "CPU hours"
+                << std::setw(12) << "Wall hours" << std::setw(8) << "Share";
+  output_writer.Endl();
+  for(const auto& [tenant, usage] : usage_of_tenants) {
+    auto share = total_cpu_time > 0 ? usage.cpu_time / total_cpu_time : 0;
+    output_writer << std::left << std::setw(20) << tenant << std::right
+                  << std::setw(8) << usage.jobs
+                  << std::setw(12) << ToHoursString(usage.cpu_time)
+                  << std::setw(12) << ToHoursString(usage.wall_time)
+                  << std::setw(7) << static_cast<int>(share * 100 + 0.5)
+                  << "%";
+    output_writer.Endl();
+  }
+  if(usage_of_tenants.empty()) {
+    output_writer << "No jobs accounted yet.";
+    output_writer.Endl();
+  }
+}
+
+} // namespace uttamarin
@@ -22,34 +22,68 @@
 
 #include "terminator.h"
 
-#include <csignal>
+#include <signal.h>
 
+#include <atomic>
+#include <csignal>
 #include <iostream>
-#include <string>
-
-using std::string;
 
 namespace uttamarin::termination {
 
-// Holds the name of the tamarin process. This name is used for killing Tamarin 
-// when the program receives a SIGINT signal (sent by Ctrl+C).
-const string tamarin_process = "tamarin-prover";
+namespace {
+
+// Most process groups that are running at the same time
+const int kMaxProcessGroups = 4096;
+
+// The process groups of the running Tamarin processes (0 for a free entry).
+// The signal handler reads them, so they are lock-free atomics.
+std::atomic<pid_t> process_groups[kMaxProcessGroups];
+
+// Signals after which the Tamarin processes are stopped as well
+const int kTerminatingSignals[] = {SIGINT, SIGTERM, SIGHUP};
 
-void (*default_sigint_handler)(int signal);
+void (*default_handlers[NSIG])(int signal);
 
-// Signal handler for SIGINT signal (sent by Ctrl+C)
+} // namespace
+
+// Signal handler for SIGINT (sent by Ctrl+C), SIGTERM and SIGHUP
 void sigint_handler(int signal)
 {
-  std::cout << std::endl;
-  std::system(("killall " + tamarin_process + " 2> /dev/null").c_str());
-  std::signal(signal, default_sigint_handler);
+  if(signal == SIGINT) std::cout << std::endl;
+  for(auto& process_group : process_groups) {
+    auto group = process_group.load();
+    if(group <= 0) continue;
+    kill(-group, SIGTERM);
+    // A stopped process only handles the signal once it continues
+    kill(-group, SIGCONT);
+  }
+  std::signal(signal, default_handlers[signal]);
   std::raise(signal);
 }
 
-// Registers a SIGINT handler. This is needed for killing Tamarin
-// in case the program receives a SIGINT signal (sent by Ctrl+C).
+// Registers the signal handler for SIGINT, SIGTERM and SIGHUP. This is needed
+// for stopping Tamarin, which runs in process groups of its own, when the
+// program is interrupted (e.g., by Ctrl+C or by a CI job that is cancelled).
 void registerSIGINTHandler(){
-  default_sigint_handler = std::signal(SIGINT, sigint_handler);
+  for(auto signal : kTerminatingSignals) {
+    default_handlers[signal] = std::signal(signal, sigint_handler);
+    // Signals ignored by our caller (e.g., nohup) stay ignored
+    if(default_handlers[signal] == SIG_IGN) std::signal(signal, SIG_IGN);
+  }
+}
+
+void registerProcessGroup(pid_t process_group) {
+  for(auto& entry : process_groups) {
+    pid_t free_entry = 0;
+    if(entry.compare_exchange_strong(free_entry, process_group)) return;
+  }
+}
+
+void unregisterProcessGroup(pid_t process_group) {
+  for(auto& entry : process_groups) {
+    pid_t registered = process_group;
+    if(entry.compare_exchange_strong(registered, 0)) return;
+  }
 }
 
 } // namespace uttamarin::terminator
@@ -0,0 +1,529 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "theory_index.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "utility.h"
+
+using std::string;
+using std::vector;
+
+namespace uttamarin {
+
+namespace {
+
+// Keywords that start a new top-level element of a theory
+const std::set<string> kTopLevelKeywords = {
+  "rule", "lemma", "restriction", "axiom", "equations", "functions",
+  "builtins", "heuristic", "tactic", "predicates", "predicate", "options",
+  "export", "diffLemma", "end"
+};
+
+// Keywords that start a declaration belonging to the signature of a theory
+const std::set<string> kSignatureKeywords = {
+  "equations", "functions", "builtins", "heuristic", "tactic", "predicates",
+  "predicate", "options", "export"
+};
+
+// Facts that are built into Tamarin
+const std::set<string> kBuiltInFacts = {"Fr", "In", "Out", "K", "KU", "KD"};
+
+// Facts that depend on the outputs of the protocol (via the adversary)
+const std::set<string> kAdversaryFacts = {"In", "K", "KU", "KD"};
+
+bool IsIdentifierChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// Replaces all comments ("// ..." and "/* ... */") as well as formal text
+// ("{* ... *}") by whitespace. Comment markers within double quotes are
+// ignored.
+string RemoveComments(const string& text) {
+  string result = text;
+  bool in_quotes = false;
+  for(size_t i = 0;i < result.size();++i) {
+    if(result[i] == '"') {
+      in_quotes = !in_quotes;
+    } else if(!in_quotes && result.compare(i, 2, "//") == 0) {
+      while(i < result.size() && result[i] != '\n') result[i++] = ' ';
+    } else if(!in_quotes && (result.compare(i, 2, "/*") == 0 ||
+                             result.compare(i, 2, "{*") == 0)) {
+      auto end = result.find(result[i] == '/' ? "*/" : "*}", i + 2);
+      end = end == string::npos ? result.size() : end + 2;
+      for(;i < end;++i) if(result[i] != '\n') result[i] = ' ';
+      --i;
+    }
+  }
+  return result;
+}
+
+void SkipWhitespace(const string& text, size_t& pos) {
+  while(pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+    ++pos;
+}
+
+string ReadIdentifier(const string& text, size_t& pos) {
+  auto start = pos;
+  while(pos < text.size() && IsIdentifierChar(text[pos])) ++pos;
+  return text.substr(start, pos - start);
+}
+
+// Replaces every sequence of whitespace by a single space, so that hashes do
+// not change when a declaration is merely reformatted.
+string NormalizeWhitespace(const string& text) {
+  string result;
+  for(char c : text) {
+    if(!std::isspace(static_cast<unsigned char>(c))) result += c;
+    else if(!result.empty() && result.back() != ' ') result += ' ';
+  }
+  if(!result.empty() && result.back() == ' ') result.pop_back();
+  return result;
+}
+
+bool Intersects(const std::set<string>& A, const std::set<string>& B) {
+  return std::any_of(A.begin(), A.end(), [&B](const string& element) {
+                       return B.count(element) > 0;
+                     });
+}
+
+// Returns the identifiers of the formula, with the quantifier symbols '∀' and
+// '∃' replaced by "All" and "Ex".
+vector<string> TokenizeFormula(const string& formula) {
+  vector<string> tokens;
+  for(size_t pos = 0;pos < formula.size();) {
+    if(IsIdentifierChar(formula[pos])) {
+      tokens.emplace_back(ReadIdentifier(formula, pos));
+    } else if(formula.compare(pos, 3, "∀") == 0) {
+      tokens.emplace_back("All");
+      pos += 3;
+    } else if(formula.compare(pos, 3, "∃") == 0) {
+      tokens.emplace_back("Ex");
+      pos += 3;
+    } else {
+      ++pos;
+    }
+  }
+  return tokens;
+}
+
+// Returns the fact symbols used in the text, i.e., capitalized identifiers
+// that are followed by an opening parenthesis.
+std::set<string> ExtractFactSymbols(const string& text) {
+  std::set<string> facts;
+  for(size_t pos = 0;pos < text.size();) {
+    if(!IsIdentifierChar(text[pos])) { ++pos; continue; }
+    auto identifier = ReadIdentifier(text, pos);
+    auto next = pos;
+    SkipWhitespace(text, next);
+    if(next < text.size() && text[next] == '(' &&
+       std::isupper(static_cast<unsigned char>(identifier[0])) &&
+       identifier != "All" && identifier != "Ex") {
+      facts.insert(identifier);
+    }
+  }
+  return facts;
+}
+
+// Returns the position of the next top-level keyword at or after 'pos' that
+// is not within double quotes (or the end of the text if there is none).
+size_t FindNextTopLevelKeyword(const string& text, size_t pos) {
+  bool in_quotes = false;
+  while(pos < text.size()) {
+    if(text[pos] == '"') {
+      in_quotes = !in_quotes;
+      ++pos;
+    } else if(!in_quotes && IsIdentifierChar(text[pos])) {
+      auto start = pos;
+      if(kTopLevelKeywords.count(ReadIdentifier(text, pos)) > 0) return start;
+    } else {
+      ++pos;
+    }
+  }
+  return text.size();
+}
+
+// Takes the body of a rule ("[...] --[...]-> [...]" or "[...] --> [...]") and
+// fills the fact symbols of its premises, actions and conclusions.
+// Returns the file named by the given line if it is an #include directive
+// of Tamarin's preprocessor, relative to the given directory, or the empty
+// string otherwise
+string ParseIncludeDirective(const string& line, const string& directory) {
+  auto directive = Trim(line);
+  if(directive.rfind("#include", 0) != 0) return "";
+  auto begin = directive.find('"');
+  auto end = directive.find('"', begin + 1);
+  if(begin == string::npos || end == string::npos) return "";
+  auto included_file = directive.substr(begin + 1, end - begin - 1);
+  if(included_file.empty() || included_file[0] == '/') return included_file;
+  return directory + included_file;
+}
+
+string GetDirectory(const string& file_path) {
+  return file_path.find('/') == string::npos ? string{} :
+         file_path.substr(0, file_path.find_last_of('/') + 1);
+}
+
+// Adds the files included by the given file (see GetIncludedFiles) that are
+// not in 'seen_files' yet
+void CollectIncludedFiles(const string& file_path,
+                          std::set<string>& seen_files,
+                          vector<string>& included_files) {
+  std::ifstream file(file_path);
+  string line;
+  while(std::getline(file, line)) {
+    auto included_file = ParseIncludeDirective(line, GetDirectory(file_path));
+    if(included_file.empty()) continue;
+    if(!seen_files.insert(included_file).second) continue;
+    included_files.emplace_back(included_file);
+    CollectIncludedFiles(included_file, seen_files, included_files);
+  }
+}
+
+// Replaces every #include directive in the given text of the given file by
+// the text of the included file (read by 'read_file'), like Tamarin's
+// preprocessor. Files that were included before or cannot be read are left
+// out.
+string ExpandIncludes(const string& text, const string& file_path,
+                      const IncludedFileReader& read_file,
+                      std::set<string>& seen_files) {
+  string expanded_text;
+  for(size_t pos = 0;pos < text.size();) {
+    auto line_end = std::min(text.find('\n', pos), text.size() - 1);
+    auto line = text.substr(pos, line_end + 1 - pos);
+    pos = line_end + 1;
+    auto included_file = ParseIncludeDirective(line, GetDirectory(file_path));
+    if(included_file.empty()) {
+      expanded_text += line;
+      continue;
+    }
+    if(!seen_files.insert(included_file).second) continue;
+    auto included_text = read_file(included_file);
+    if(included_text.has_value()) {
+      expanded_text += ExpandIncludes(included_text.value(), included_file,
+                                      read_file, seen_files);
+    }
+  }
+  return expanded_text;
+}
+
+std::optional<string> ReadFile(const string& file_path) {
+  std::ifstream file_stream{file_path, std::ifstream::binary};
+  if(!file_stream) return std::nullopt;
+  std::ostringstream contents;
+  contents << file_stream.rdbuf();
+  return contents.str();
+}
+
+void ParseRuleBody(const string& body, RuleInfo& rule) {
+  auto actions_start = body.find("--[");
+  auto arrow = actions_start != string::npos ? actions_start : body.find("-->");
+  if(arrow == string::npos) return;
+  rule.premise_facts = ExtractFactSymbols(body.substr(0, arrow));
+  if(actions_start != string::npos) {
+    auto actions_end = body.find("]->", actions_start);
+    if(actions_end == string::npos) return;
+    rule.action_facts = ExtractFactSymbols(
+            body.substr(actions_start + 3, actions_end - actions_start - 3));
+    rule.conclusion_facts = ExtractFactSymbols(body.substr(actions_end + 3));
+  } else {
+    rule.conclusion_facts = ExtractFactSymbols(body.substr(arrow + 3));
+  }
+}
+
+} // namespace
+
+TheoryIndex::TheoryIndex(const string& spthy_file_path) :
+  TheoryIndex(FromTheoryText(ReadFile(spthy_file_path).value_or(""),
+                             spthy_file_path)) {
+}
+
+TheoryIndex TheoryIndex::FromTheoryText(const string& theory_text,
+                                        const string& spthy_file_path,
+                                        const IncludedFileReader& read_file) {
+  TheoryIndex theory_index;
+  std::set<string> seen_files{spthy_file_path};
+  auto expanded_text = ExpandIncludes(theory_text, spthy_file_path,
+                                      read_file ? read_file : ReadFile,
+                                      seen_files);
+  theory_index.theory_hash_ = HashString(expanded_text);
+  theory_index.ParseTheory(expanded_text);
+  return theory_index;
+}
+
+void TheoryIndex::ParseTheory(const string& theory_text) {
+  auto text = RemoveComments(theory_text);
+  string signature = "";
+  for(size_t pos = 0;pos < text.size();) {
+    if(!IsIdentifierChar(text[pos])) { ++pos; continue; }
+    auto start = pos;
+    auto keyword = ReadIdentifier(text, pos);
+    if(keyword == "rule") {
+      ParseRule(text, pos);
+      continue;
+    }
+    if(keyword == "restriction" || keyword == "axiom") {
+      ParseRestriction(text, pos);
+      continue;
+    }
+    if(kSignatureKeywords.count(keyword) > 0) {
+      auto end = FindNextTopLevelKeyword(text, pos);
+      signature += NormalizeWhitespace(text.substr(start, end - start)) + "\n";
+      pos = end;
+      continue;
+    }
+    if(keyword != "lemma") continue;
+
+    LemmaInfo lemma;
+    SkipWhitespace(text, pos);
+    lemma.name = ReadIdentifier(text, pos);
+    SkipWhitespace(text, pos);
+    if(pos < text.size() && text[pos] == '[') {
+      auto end = text.find(']', pos);
+      if(end == string::npos) break;
+      std::istringstream attribute_stream{text.substr(pos + 1, end - pos - 1)};
+      string attribute;
+      while(std::getline(attribute_stream, attribute, ',')) {
+        lemma.attributes.emplace_back(Trim(attribute));
+      }
+      pos = end + 1;
+      SkipWhitespace(text, pos);
+    }
+    if(lemma.name.empty() || pos >= text.size() || text[pos] != ':') continue;
+    ++pos;
+    SkipWhitespace(text, pos);
+
+    lemma.is_exists_trace = text.compare(pos, 12, "exists-trace") == 0;
+    if(lemma.is_exists_trace) pos += 12;
+    else if(text.compare(pos, 10, "all-traces") == 0) pos += 10;
+    SkipWhitespace(text, pos);
+
+    if(pos >= text.size() || text[pos] != '"') continue;
+    auto end = text.find('"', pos + 1);
+    if(end == string::npos) break;
+    lemma.formula = text.substr(pos + 1, end - pos - 1);
+    pos = FindNextTopLevelKeyword(text, end + 1);
+    lemma.hash = HashString(NormalizeWhitespace(text.substr(start,
+                                                            pos - start)));
+    lemmas_.emplace_back(lemma);
+  }
+  signature_hash_ = HashString(signature);
+}
+
+void TheoryIndex::ParseRule(const string& text, size_t& pos) {
+  auto start = pos;
+  RuleInfo rule;
+  SkipWhitespace(text, pos);
+  rule.name = ReadIdentifier(text, pos);
+  SkipWhitespace(text, pos);
+  if(pos < text.size() && text[pos] == '[') {
+    auto end = text.find(']', pos);
+    if(end == string::npos) return;
+    pos = end + 1;
+    SkipWhitespace(text, pos);
+  }
+  if(rule.name.empty() || pos >= text.size() || text[pos] != ':') return;
+  ++pos;
+  auto end = FindNextTopLevelKeyword(text, pos);
+  ParseRuleBody(text.substr(pos, end - pos), rule);
+  rule.hash = HashString("rule " +
+                         NormalizeWhitespace(text.substr(start, end - start)));
+  pos = end;
+  rules_.emplace_back(rule);
+}
+
+void TheoryIndex::ParseRestriction(const string& text, size_t& pos) {
+  auto start = pos;
+  RestrictionInfo restriction;
+  SkipWhitespace(text, pos);
+  restriction.name = ReadIdentifier(text, pos);
+  auto end = FindNextTopLevelKeyword(text, pos);
+  auto declaration = text.substr(start, end - start);
+  auto formula_start = declaration.find('"');
+  auto formula_end = formula_start == string::npos ? string::npos :
+                     declaration.find('"', formula_start + 1);
+  if(formula_end != string::npos) {
+    restriction.formula = declaration.substr(formula_start + 1,
+                                             formula_end - formula_start - 1);
+  }
+  restriction.hash = HashString("restriction " +
+                                NormalizeWhitespace(declaration));
+  pos = end;
+  restrictions_.emplace_back(restriction);
+}
+
+const string& TheoryIndex::GetTheoryHash() const {
+  return theory_hash_;
+}
+
+const vector<LemmaInfo>& TheoryIndex::GetLemmas() const {
+  return lemmas_;
+}
+
+const LemmaInfo* TheoryIndex::FindLemma(const string& lemma_name) const {
+  auto it = std::find_if(lemmas_.begin(), lemmas_.end(),
+                         [&lemma_name](const LemmaInfo& lemma) {
+                           return lemma.name == lemma_name;
+                         });
+  return it == lemmas_.end() ? nullptr : &*it;
+}
+
+const vector<RuleInfo>& TheoryIndex::GetRules() const {
+  return rules_;
+}
+
+const vector<RestrictionInfo>& TheoryIndex::GetRestrictions() const {
+  return restrictions_;
+}
+
+std::set<string> TheoryIndex::GetFactSymbols() const {
+  std::set<string> facts;
+  for(const auto& rule : rules_) {
+    for(const auto* rule_facts : {&rule.premise_facts, &rule.action_facts,
+                                  &rule.conclusion_facts}) {
+      for(const auto& fact : *rule_facts) {
+        if(kBuiltInFacts.count(fact) == 0) facts.insert(fact);
+      }
+    }
+  }
+  return facts;
+}
+
+vector<string> TheoryIndex::GetLemmaFeatures(const string& lemma_name) const {
+  auto lemma = FindLemma(lemma_name);
+  if(lemma == nullptr) return {};
+
+  vector<string> features;
+  features.emplace_back(lemma->is_exists_trace ? "trace:exists" : "trace:all");
+  for(const auto& attribute : lemma->attributes) {
+    features.emplace_back("attribute:" + attribute);
+  }
+
+  int quantifiers = 0;
+  int alternations = 0;
+  string last_quantifier = "";
+  bool has_negation = false;
+  for(const auto& token : TokenizeFormula(lemma->formula)) {
+    if(token == "not") has_negation = true;
+    if(token != "All" && token != "Ex") continue;
+    if(last_quantifier.empty()) features.emplace_back("quantifier:" + token);
+    else if(last_quantifier != token) ++alternations;
+    last_quantifier = token;
+    ++quantifiers;
+  }
+  if(quantifiers == 0) features.emplace_back("quantifier:none");
+  features.emplace_back("quantifiers:" + std::to_string(std::min(quantifiers,
+                                                                 4)));
+  features.emplace_back("alternations:" + std::to_string(std::min(alternations,
+                                                                  3)));
+  if(lemma->formula.find("==>") != string::npos ||
+     lemma->formula.find("⇒") != string::npos) {
+    features.emplace_back("implication");
+  }
+  if(has_negation || lemma->formula.find("¬") != string::npos) {
+    features.emplace_back("negation");
+  }
+  for(const auto& fact : ExtractFactSymbols(lemma->formula)) {
+    features.emplace_back("fact:" + fact);
+  }
+  return features;
+}
+
+vector<string> TheoryIndex::GetRulesInCone(const string& lemma_name) const {
+  auto lemma = FindLemma(lemma_name);
+  if(lemma == nullptr) return {};
+
+  auto needed_facts = ExtractFactSymbols(lemma->formula);
+  for(const auto& restriction : restrictions_) {
+    auto restriction_facts = ExtractFactSymbols(restriction.formula);
+    needed_facts.insert(restriction_facts.begin(), restriction_facts.end());
+  }
+
+  vector<bool> is_in_cone(rules_.size(), false);
+  for(bool has_changed = true;has_changed;) {
+    has_changed = false;
+    if(Intersects(needed_facts, kAdversaryFacts)) needed_facts.insert("Out");
+    for(size_t i = 0;i < rules_.size();++i) {
+      if(is_in_cone[i] ||
+         (!Intersects(rules_[i].action_facts, needed_facts) &&
+          !Intersects(rules_[i].conclusion_facts, needed_facts))) continue;
+      is_in_cone[i] = true;
+      has_changed = true;
+      needed_facts.insert(rules_[i].premise_facts.begin(),
+                          rules_[i].premise_facts.end());
+    }
+  }
+
+  vector<string> rules_in_cone;
+  for(size_t i = 0;i < rules_.size();++i) {
+    if(is_in_cone[i]) rules_in_cone.emplace_back(rules_[i].name);
+  }
+  return rules_in_cone;
+}
+
+string TheoryIndex::GetLemmaConeHash(const string& lemma_name) const {
+  auto lemma = FindLemma(lemma_name);
+  if(lemma == nullptr) return "";
+
+  string cone = signature_hash_;
+  for(const auto& restriction : restrictions_) cone += restriction.hash;
+  auto rules_in_cone = GetRulesInCone(lemma_name);
+  for(const auto& rule : rules_) {
+    if(std::find(rules_in_cone.begin(), rules_in_cone.end(), rule.name) !=
+       rules_in_cone.end()) cone += rule.hash;
+  }
+  for(const auto& other_lemma : lemmas_) {
+    if(&other_lemma == lemma) break;
+    const auto& attributes = other_lemma.attributes;
+    if(std::find(attributes.begin(), attributes.end(), "reuse") !=
+       attributes.end() ||
+       std::find(attributes.begin(), attributes.end(), "sources") !=
+       attributes.end()) {
+      cone += GetLemmaConeHash(other_lemma.name);
+    }
+  }
+  cone += lemma->hash;
+  return HashString(cone);
+}
+
+string ReadTheoryText(const string& spthy_file_path) {
+  std::set<string> seen_files{spthy_file_path};
+  return ExpandIncludes(ReadFile(spthy_file_path).value_or(""),
+                        spthy_file_path, ReadFile, seen_files);
+}
+
+vector<string> GetIncludedFiles(const string& spthy_file_path) {
+  std::set<string> seen_files{spthy_file_path};
+  vector<string> included_files;
+  CollectIncludedFiles(spthy_file_path, seen_files, included_files);
+  return included_files;
+}
+
+} // namespace uttamarin
@@ -0,0 +1,229 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "theory_watcher.h"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "app.h"
+#include "dashboard.h"
+#include "default_lemma_job_generator.h"
+#include "file_watcher.h"
+#include "lemma_history.h"
+#include "lemma_job.h"
+#include "lemma_name_reader.h"
+#include "m4_theory_preprocessor.h"
+#include "output_writer.h"
+#include "theory_index.h"
+#include "utility.h"
+#include "ut_tamarin_config.h"
+#include "watch_lemma_processor.h"
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace uttamarin {
+
+namespace {
+
+// Time in milliseconds without further changes after which a change of the
+// watched files starts a new run (editors often write a file several times)
+const int kDebounceTime = 300;
+
+string GetFileName(const string& file_path) {
+  return file_path.substr(file_path.find_last_of('/') + 1);
+}
+
+} // namespace
+
+TheoryWatcher::TheoryWatcher(const CmdParameters& parameters,
+                             const LemmaProcessorParts& lemma_processor_parts,
+                             shared_ptr<OutputWriter> output_writer,
+                             shared_ptr<Dashboard> dashboard) :
+  parameters_(parameters),
+  lemma_processor_parts_(lemma_processor_parts),
+  output_writer_(output_writer),
+  dashboard_(dashboard),
+  watched_jobs_(std::make_shared<WatchedJobs>()) {
+}
+
+TheoryWatcher::~TheoryWatcher() {
+  if(run_thread_.joinable()) run_thread_.join();
+}
+
+bool TheoryWatcher::Run() {
+  FileWatcher file_watcher;
+  vector<string> changed_files;
+  while(true) {
+    if(!file_watcher.SetFiles(GetWatchedFiles())) {
+      std::cerr << "Error: cannot watch the files of '"
+                << parameters_.spthy_file_path << "' for changes."
+                << std::endl;
+      return false;
+    }
+    StartRun(changed_files);
+    changed_files = file_watcher.WaitForChanges(kDebounceTime);
+    if(changed_files.empty()) {
+      std::cerr << "Error: cannot wait for changes of '"
+                << parameters_.spthy_file_path << "'." << std::endl;
+      return false;
+    }
+  }
+}
+
+void TheoryWatcher::StartRun(const vector<string>& changed_files) {
+  shared_ptr<UtTamarinConfig> config;
+  try {
+    config = std::make_shared<UtTamarinConfig>(parameters_);
+  } catch(const std::exception& exception) {
+    std::cerr << "Error: cannot read the config file '"
+              << parameters_.config_file_path << "': " << exception.what()
+              << std::endl;
+    return;
+  }
+  auto theory_index =
+          std::make_shared<const TheoryIndex>(parameters_.spthy_file_path);
+  string context = HashFileContents(parameters_.config_file_path) + "\n";
+  for(const auto& included_file :
+      GetIncludedFiles(parameters_.spthy_file_path)) {
+    context += HashFileContents(included_file) + "\n";
+  }
+  auto context_hash = HashString(context);
+  vector<string> declared_lemmas;
+  for(const auto& lemma : theory_index->GetLemmas()) {
+    declared_lemmas.emplace_back(lemma.name);
+  }
+
+  DefaultLemmaJobGenerator lemma_job_generator(
+          parameters_.spthy_file_path, parameters_.starting_lemma, config,
+          lemma_processor_parts_.history, theory_index,
+          GetLemmaNames(declared_lemmas, context_hash));
+  auto lemma_jobs = SelectLemmaJobs(lemma_job_generator.GenerateLemmaJobs(),
+                                    parameters_.lemmas);
+  std::set<string> keys;
+  for(const auto& lemma_job : lemma_jobs) {
+    keys.insert(WatchedJobs::GetKey(*theory_index, context_hash, lemma_job));
+  }
+
+  int cancelled_jobs = 0;
+  auto run = watched_jobs_->StartRun(keys, cancelled_jobs);
+  if(run_thread_.joinable()) run_thread_.join();
+
+  // Jobs that wait for running jobs come first, since they occupy a worker
+  // without running Tamarin, followed by the affected lemmas
+  auto get_rank = [&](const LemmaJob& lemma_job) {
+    auto key = WatchedJobs::GetKey(*theory_index, context_hash, lemma_job);
+    if(watched_jobs_->IsRunning(key)) return 0;
+    return watched_jobs_->HasResult(key) ? 2 : 1;
+  };
+  int affected_lemmas = 0;
+  for(const auto& lemma_job : lemma_jobs) {
+    if(get_rank(lemma_job) == 1) ++affected_lemmas;
+  }
+  std::stable_sort(lemma_jobs.begin(), lemma_jobs.end(),
+                   [&](const LemmaJob& a, const LemmaJob& b) {
+                     return get_rank(a) < get_rank(b);
+                   });
+
+  if(!changed_files.empty()) {
+    *output_writer_ << "\nChanged: ";
+    for(size_t i = 0;i < changed_files.size();++i) {
+      *output_writer_ << (i > 0 ? ", " : "") << GetFileName(changed_files[i]);
+    }
+    *output_writer_ << " (" << affected_lemmas << " of " << lemma_jobs.size()
+                    << " lemmas affected, " << cancelled_jobs
+                    << " stale job(s) cancelled)\n";
+    output_writer_->Endl();
+  }
+  if(dashboard_ != nullptr) {
+    vector<string> lemma_names;
+    for(const auto& lemma_job : lemma_jobs) {
+      lemma_names.emplace_back(lemma_job.GetLemmaName());
+    }
+    dashboard_->AddQueuedLemmas(lemma_names);
+  }
+
+  // Every run gets a run id of its own
+  auto lemma_processor_parts = lemma_processor_parts_;
+  lemma_processor_parts.run_info = CreateRunInfo(
+          lemma_processor_parts_.run_info.tamarin_version);
+  auto lemma_processor = CreateLemmaProcessor(parameters_,
+                                              lemma_processor_parts,
+                                              theory_index);
+  lemma_processor = std::make_unique<WatchLemmaProcessor>(
+          std::move(lemma_processor), watched_jobs_, run, theory_index,
+          context_hash);
+  auto app = std::make_unique<App>(std::move(lemma_processor),
+                                   std::make_unique<M4TheoryPreprocessor>(
+                                           config),
+                                   config,
+                                   output_writer_);
+
+  auto number_of_files = GetWatchedFiles().size();
+  run_thread_ = std::thread([this, app = std::move(app), lemma_jobs,
+                             number_of_files] {
+    app->RunOnLemmas(lemma_jobs);
+    *output_writer_ << "\nWatching '"
+                    << GetFileName(parameters_.spthy_file_path) << "'";
+    if(number_of_files > 1) {
+      *output_writer_ << " and " << number_of_files - 1 << " other file(s)";
+    }
+    *output_writer_ << " for changes (Ctrl+C to stop) ...";
+    output_writer_->Endl();
+  });
+}
+
+vector<string> TheoryWatcher::GetLemmaNames(
+        const vector<string>& declared_lemmas,
+        const string& context_hash) {
+  string lemma_names_source = context_hash;
+  for(const auto& lemma : declared_lemmas) lemma_names_source += "\n" + lemma;
+  if(lemma_names_source == lemma_names_source_) return lemma_names_;
+  lemma_names_ = ReadLemmaNamesFromSpthyFile(parameters_.spthy_file_path);
+  // Tamarin finds no lemmas in theories it cannot parse, which the next
+  // change may fix
+  lemma_names_source_ = lemma_names_.empty() ? "" : lemma_names_source;
+  return lemma_names_;
+}
+
+vector<string> TheoryWatcher::GetWatchedFiles() const {
+  vector<string> files{parameters_.spthy_file_path};
+  for(const auto& included_file :
+      GetIncludedFiles(parameters_.spthy_file_path)) {
+    files.emplace_back(included_file);
+  }
+  if(parameters_.config_file_path != "") {
+    files.emplace_back(parameters_.config_file_path);
+  }
+  return files;
+}
+
+} // namespace uttamarin
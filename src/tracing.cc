@@ -0,0 +1,226 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "tracing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "worker_pool.h"
+
+using std::string;
+using json = nlohmann::json;
+
+namespace uttamarin::tracing {
+
+namespace {
+
+struct TraceEvent {
+  string name;
+  string detail;
+  long long start_time; // in microseconds
+  long long duration; // in microseconds
+  int track;
+};
+
+struct CounterEvent {
+  string name;
+  long long time; // in microseconds
+  std::vector<std::pair<string, double>> values;
+};
+
+struct TraceState {
+  string trace_file_path;
+  std::chrono::steady_clock::time_point start_time;
+  std::vector<TraceEvent> events;
+  std::vector<CounterEvent> counter_events;
+  std::chrono::steady_clock::time_point statistics_start_time;
+  std::map<string, PhaseStatistics> statistics_of;
+  std::mutex mutex;
+};
+
+std::atomic<bool> is_enabled{false};
+std::atomic<bool> is_statistics_enabled{false};
+
+TraceState& GetTraceState() {
+  static TraceState trace_state;
+  return trace_state;
+}
+
+long long ToMicroseconds(std::chrono::steady_clock::time_point time) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+          time - GetTraceState().start_time).count();
+}
+
+int GetCurrentTrack() {
+  return WorkerPool::GetCurrentWorkerIndex() + 1;
+}
+
+string GetTrackName(int track) {
+  return track == 0 ? "main" : "worker " + std::to_string(track - 1);
+}
+
+} // namespace
+
+void Start(const string& trace_file_path) {
+  auto& trace_state = GetTraceState();
+  {
+    std::lock_guard<std::mutex> lock(trace_state.mutex);
+    trace_state.trace_file_path = trace_file_path;
+    trace_state.start_time = std::chrono::steady_clock::now();
+    trace_state.events.clear();
+    trace_state.counter_events.clear();
+  }
+  if(!is_enabled.exchange(true)) std::atexit(Write);
+}
+
+bool IsEnabled() {
+  return is_enabled;
+}
+
+void Write() {
+  if(!is_enabled) return;
+  auto& trace_state = GetTraceState();
+  std::lock_guard<std::mutex> lock(trace_state.mutex);
+
+  auto trace_events = json::array();
+  std::set<int> tracks = {0};
+  for(const auto& event : trace_state.events) {
+    json trace_event = {{"name", event.name}, {"cat", "uttamarin"},
+                        {"ph", "X"}, {"ts", event.start_time},
+                        {"dur", event.duration}, {"pid", 1},
+                        {"tid", event.track}};
+    if(!event.detail.empty()) trace_event["args"] = {{"detail", event.detail}};
+    trace_events.emplace_back(trace_event);
+    tracks.insert(event.track);
+  }
+  for(const auto& event : trace_state.counter_events) {
+    json values = json::object();
+    for(const auto& [name, value] : event.values) values[name] = value;
+    trace_events.emplace_back(json{{"name", event.name}, {"cat", "uttamarin"},
+                                   {"ph", "C"}, {"ts", event.time},
+                                   {"pid", 1}, {"args", values}});
+  }
+  for(auto track : tracks) {
+    trace_events.emplace_back(json{{"name", "thread_name"}, {"ph", "M"},
+                                   {"pid", 1}, {"tid", track},
+                                   {"args", {{"name", GetTrackName(track)}}}});
+  }
+  trace_events.emplace_back(json{{"name", "process_name"}, {"ph", "M"},
+                                 {"pid", 1},
+                                 {"args", {{"name", "uttamarin"}}}});
+
+  std::ofstream trace_file{trace_state.trace_file_path};
+  if(!trace_file) {
+    std::cerr << "Warning: cannot write trace file '"
+              << trace_state.trace_file_path << "'." << std::endl;
+    return;
+  }
+  trace_file << json{{"traceEvents", trace_events},
+                     {"displayTimeUnit", "ms"}}.dump() << std::endl;
+}
+
+void RecordCounter(const string& name,
+                   const std::vector<std::pair<string, double>>& values) {
+  if(!is_enabled) return;
+  auto time = std::chrono::steady_clock::now();
+  auto& trace_state = GetTraceState();
+  std::lock_guard<std::mutex> lock(trace_state.mutex);
+  trace_state.counter_events.emplace_back(
+          CounterEvent{name, ToMicroseconds(time), values});
+}
+
+void EnableStatistics() {
+  auto& trace_state = GetTraceState();
+  std::lock_guard<std::mutex> lock(trace_state.mutex);
+  if(is_statistics_enabled) return;
+  trace_state.statistics_start_time = std::chrono::steady_clock::now();
+  is_statistics_enabled = true;
+}
+
+std::vector<PhaseStatistics> GetPhaseStatistics() {
+  auto& trace_state = GetTraceState();
+  std::lock_guard<std::mutex> lock(trace_state.mutex);
+  std::vector<PhaseStatistics> phase_statistics;
+  for(const auto& [name, statistics] : trace_state.statistics_of) {
+    phase_statistics.emplace_back(statistics);
+  }
+  return phase_statistics;
+}
+
+PhaseStatistics GetPhaseStatistics(const string& name) {
+  auto& trace_state = GetTraceState();
+  std::lock_guard<std::mutex> lock(trace_state.mutex);
+  auto it = trace_state.statistics_of.find(name);
+  if(it == trace_state.statistics_of.end()) return {name, 0, 0, 0};
+  return it->second;
+}
+
+double GetElapsedTime() {
+  return std::chrono::duration<double>(
+          std::chrono::steady_clock::now() -
+          GetTraceState().statistics_start_time).count();
+}
+
+ScopedSpan::ScopedSpan(const string& name, const string& detail) :
+  is_enabled_(is_enabled || is_statistics_enabled) {
+  if(!is_enabled_) return;
+  name_ = name;
+  detail_ = detail;
+  start_time_ = std::chrono::steady_clock::now();
+}
+
+ScopedSpan::~ScopedSpan() {
+  if(!is_enabled_) return;
+  auto end_time = std::chrono::steady_clock::now();
+  auto& trace_state = GetTraceState();
+  std::lock_guard<std::mutex> lock(trace_state.mutex);
+  if(is_statistics_enabled) {
+    auto& statistics = trace_state.statistics_of[name_];
+    double duration =
+            std::chrono::duration<double>(end_time - start_time_).count();
+    statistics.name = name_;
+    ++statistics.count;
+    statistics.total_time += duration;
+    statistics.max_time = std::max(statistics.max_time, duration);
+  }
+  if(is_enabled) {
+    trace_state.events.emplace_back(TraceEvent{
+            name_, detail_, ToMicroseconds(start_time_),
+            ToMicroseconds(end_time) - ToMicroseconds(start_time_),
+            GetCurrentTrack()});
+  }
+}
+
+} // namespace uttamarin::tracing
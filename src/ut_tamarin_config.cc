@@ -24,6 +24,8 @@
 
 #include <algorithm>
 #include <fstream>
+#include <iostream>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -31,6 +33,7 @@
 #include "nlohmann/json.hpp"
 
 #include "cmd_parameters.h"
+#include "lemma_job.h"
 
 using std::string;
 using std::vector;
@@ -47,6 +50,7 @@ UtTamarinConfig::UtTamarinConfig(const CmdParameters &cmd_parameters)
     penetration_lemma_(cmd_parameters.penetration_lemma),
     proof_directory_(cmd_parameters.proof_directory),
     timeout_(cmd_parameters.timeout),
+    jobs_(cmd_parameters.jobs),
     abort_after_failure_(cmd_parameters.abort_after_failure)
     {
   ParseJsonConfigFile(cmd_parameters.config_file_path);
@@ -89,6 +93,101 @@ void UtTamarinConfig::ParseJsonConfigFile(const std::string &config_file_path) {
     auto lemma_name = lemma_annotation["lemma_name"].get<string>();
     local_annotations_[lemma_name] = GetFactAnnotations(lemma_annotation);
   }
+
+  for(auto lemma_heuristic : json_config["lemma_heuristics"]){
+    auto lemma_name = lemma_heuristic["lemma_name"].get<string>();
+    auto heuristic = lemma_heuristic["heuristic"].get<string>();
+    if(!IsValidHeuristic(heuristic)) {
+      std::cerr << "Warning: ignoring invalid heuristic '" << heuristic
+                << "' for lemma '" << lemma_name << "'." << std::endl;
+      continue;
+    }
+    lemma_heuristics_[lemma_name] = heuristic;
+  }
+}
+
+void UtTamarinConfig::WriteLemmaHeuristics(
+        const string& config_file_path,
+        const std::unordered_map<string, string>& heuristics) {
+  auto json_config = ReadJsonObject(config_file_path);
+
+  // Keeps the entries of lemmas without a new heuristic (e.g., committed
+  // ones that the history no longer knows) and sorts by lemma name, so that
+  // the exported section is stable across runs
+  std::map<string, json> entry_of;
+  json other_entries = json::array();
+  if(json_config["lemma_heuristics"].is_array()){
+    for(const auto& entry : json_config["lemma_heuristics"]){
+      if(entry.is_object() && entry.contains("lemma_name") &&
+         entry["lemma_name"].is_string()) {
+        entry_of[entry["lemma_name"].get<string>()] = entry;
+      } else {
+        other_entries.push_back(entry);
+      }
+    }
+  }
+  for(const auto& [lemma_name, heuristic] : heuristics){
+    if(heuristic.empty()) continue;
+    entry_of[lemma_name]["lemma_name"] = lemma_name;
+    entry_of[lemma_name]["heuristic"] = heuristic;
+  }
+  json_config["lemma_heuristics"] = json::array();
+  for(const auto& [lemma_name, entry] : entry_of){
+    json_config["lemma_heuristics"].push_back(entry);
+  }
+  for(const auto& entry : other_entries){
+    json_config["lemma_heuristics"].push_back(entry);
+  }
+
+  std::ofstream output_stream{config_file_path};
+  output_stream << json_config.dump(1, '\t') << std::endl;
+}
+
+void UtTamarinConfig::WriteLemmaAnnotations(
+        const string& config_file_path,
+        const string& lemma_name,
+        const FactAnnotations& annotations) {
+  auto json_config = ReadJsonObject(config_file_path);
+  auto lemma_annotation = ToJsonLemmaAnnotation(lemma_name, annotations);
+
+  if(!json_config["lemma_annotations"].is_array()){
+    json_config["lemma_annotations"] = json::array();
+  }
+  auto& lemma_annotations = json_config["lemma_annotations"];
+  auto it = std::find_if(lemma_annotations.begin(), lemma_annotations.end(),
+                         [&lemma_name](const json& entry) {
+                           return entry.value("lemma_name", "") == lemma_name;
+                         });
+  if(it != lemma_annotations.end()) *it = lemma_annotation;
+  else lemma_annotations.push_back(lemma_annotation);
+
+  std::ofstream output_stream{config_file_path};
+  output_stream << json_config.dump(1, '\t') << std::endl;
+}
+
+json UtTamarinConfig::ToJsonLemmaAnnotation(
+        const string& lemma_name,
+        const FactAnnotations& annotations) {
+  json lemma_annotation = {{"lemma_name", lemma_name}};
+  if(!annotations.important_facts.empty()){
+    lemma_annotation["important_facts"] = annotations.important_facts;
+  }
+  if(!annotations.unimportant_facts.empty()){
+    lemma_annotation["unimportant_facts"] = annotations.unimportant_facts;
+  }
+  if(!annotations.neutral_facts.empty()){
+    lemma_annotation["neutral_facts"] = annotations.neutral_facts;
+  }
+  return lemma_annotation;
+}
+
+json UtTamarinConfig::ReadJsonObject(const string& file_path) {
+  ifstream file_stream{file_path};
+  if(file_stream.good()){
+    auto json_object = json::parse(file_stream, nullptr, false);
+    if(json_object.is_object()) return json_object;
+  }
+  return json::object();
 }
 
 FactAnnotations UtTamarinConfig::GetFactAnnotations(json json_annotation){
@@ -136,6 +235,10 @@ int UtTamarinConfig::GetTimeout() const {
   return timeout_;
 }
 
+int UtTamarinConfig::GetJobs() const {
+  return jobs_;
+}
+
 bool UtTamarinConfig::IsAbortAfterFailure() const {
   return abort_after_failure_;
 }
@@ -160,4 +263,21 @@ const {
   return FactAnnotations{vector<string>{}, vector<string>{}, vector<string>{}};
 }
 
+void UtTamarinConfig::SetLocalAnnotations(const string& lemma_name,
+                                          const FactAnnotations& annotations) {
+  local_annotations_[lemma_name] = annotations;
+}
+
+string UtTamarinConfig::GetLemmaHeuristic(const string& lemma_name) const {
+  if(lemma_heuristics_.count(lemma_name) > 0) {
+    return lemma_heuristics_.at(lemma_name);
+  }
+  return "";
+}
+
+const std::unordered_map<string, string>&
+UtTamarinConfig::GetLemmaHeuristics() const {
+  return lemma_heuristics_;
+}
+
 } // namespace uttamarin
@@ -22,17 +22,111 @@
 
 #include "utility.h"
 
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <limits>
+#include <optional>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#include "task_control.h"
+#include "terminator.h"
+#include "tracing.h"
+
 using std::string;
 using std::vector;
 
 namespace uttamarin {
 
+namespace {
+
+// Seconds that a terminated process group gets to exit before it is killed
+const double kTerminationGracePeriod = 1;
+
+// Seconds between two checks whether a process has exited, if the kernel
+// cannot notify about it
+const double kExitPollInterval = 0.05;
+
+// Returns true if the given child process has exited (without reaping it)
+bool HasExited(pid_t pid) {
+  siginfo_t info;
+  info.si_pid = 0;
+  return waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 &&
+         info.si_pid == pid;
+}
+
+// Waits until the given child process exits (without reaping it) or the
+// time returned by 'get_remaining_time' (in seconds, which may grow while
+// waiting) runs out. Returns false if the time ran out.
+bool WaitForExit(pid_t pid, const std::function<double()>& get_remaining_time) {
+  int process_descriptor = -1;
+#ifdef SYS_pidfd_open
+  process_descriptor = syscall(SYS_pidfd_open, pid, 0);
+#endif
+  bool has_exited = false;
+  while(!has_exited) {
+    auto remaining_time = get_remaining_time();
+    if(remaining_time <= 0) break;
+    if(process_descriptor >= 0) {
+      // The descriptor becomes readable once the process exits
+      pollfd poll_descriptor{process_descriptor, POLLIN, 0};
+      auto timeout_ms = std::min(std::ceil(remaining_time * 1000),
+                                 static_cast<double>(
+                                         std::numeric_limits<int>::max()));
+      has_exited = poll(&poll_descriptor, 1, static_cast<int>(timeout_ms)) > 0;
+    } else {
+      has_exited = HasExited(pid);
+      if(!has_exited) {
+        usleep(std::min(remaining_time, kExitPollInterval) * 1e6);
+      }
+    }
+  }
+  if(process_descriptor >= 0) close(process_descriptor);
+  return has_exited;
+}
+
+// Terminates the given process group, which is killed if it does not exit
+// within the grace period
+void TerminateProcessGroup(pid_t process_group) {
+  kill(-process_group, SIGTERM);
+  // A stopped process only handles the signal once it continues
+  kill(-process_group, SIGCONT);
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::duration<double>(kTerminationGracePeriod);
+  if(!WaitForExit(process_group, [deadline] {
+       return std::chrono::duration<double>(
+               deadline - std::chrono::steady_clock::now()).count();
+     })) {
+    kill(-process_group, SIGKILL);
+  }
+}
+
+} // namespace
+
+string Trim(const string& text) {
+  auto start = text.find_first_not_of(" \f\n\r\t\v");
+  if(start == string::npos) return "";
+  auto end = text.find_last_not_of(" \f\n\r\t\v");
+  return text.substr(start, end - start + 1);
+}
+
 string ToSecondsString(int duration) { 
   return std::to_string(duration) + " second" + (duration != 1 ? "s" : ""); 
 }
@@ -73,14 +167,216 @@ string GetStringWithShortestEditDistance(const vector<string>& candidates,
   return closest_lemma;
 }
 
+string HashString(const string& input) {
+  uint64_t hash = 14695981039346656037ULL;
+  for(unsigned char c : input) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  std::ostringstream hex_stream;
+  hex_stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return hex_stream.str();
+}
+
+string Sha256String(const string& input) {
+  static const uint32_t k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+  uint32_t hash[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                      0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  auto rotate = [](uint32_t x, int n) { return (x >> n) | (x << (32 - n)); };
+
+  // The message is padded with a one bit, zeros and its length in bits to a
+  // multiple of 64 bytes
+  string message = input;
+  message += static_cast<char>(0x80);
+  while(message.size() % 64 != 56) message += '\0';
+  uint64_t bit_length = static_cast<uint64_t>(input.size()) * 8;
+  for(int shift = 56;shift >= 0;shift -= 8) {
+    message += static_cast<char>((bit_length >> shift) & 0xff);
+  }
+
+  for(size_t block = 0;block < message.size();block += 64) {
+    uint32_t w[64];
+    for(int i = 0;i < 16;++i) {
+      w[i] = 0;
+      for(int j = 0;j < 4;++j) {
+        w[i] = (w[i] << 8) |
+               static_cast<unsigned char>(message[block + 4 * i + j]);
+      }
+    }
+    for(int i = 16;i < 64;++i) {
+      uint32_t s0 = rotate(w[i - 15], 7) ^ rotate(w[i - 15], 18) ^
+                    (w[i - 15] >> 3);
+      uint32_t s1 = rotate(w[i - 2], 17) ^ rotate(w[i - 2], 19) ^
+                    (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = hash[0], b = hash[1], c = hash[2], d = hash[3];
+    uint32_t e = hash[4], f = hash[5], g = hash[6], h = hash[7];
+    for(int i = 0;i < 64;++i) {
+      uint32_t s1 = rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25);
+      uint32_t choice = (e & f) ^ (~e & g);
+      uint32_t temp1 = h + s1 + choice + k[i] + w[i];
+      uint32_t s0 = rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22);
+      uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+      uint32_t temp2 = s0 + majority;
+      h = g; g = f; f = e; e = d + temp1;
+      d = c; c = b; b = a; a = temp1 + temp2;
+    }
+    hash[0] += a; hash[1] += b; hash[2] += c; hash[3] += d;
+    hash[4] += e; hash[5] += f; hash[6] += g; hash[7] += h;
+  }
+
+  std::ostringstream hex_stream;
+  for(auto word : hash) {
+    hex_stream << std::hex << std::setw(8) << std::setfill('0') << word;
+  }
+  return hex_stream.str();
+}
+
+string HashFileContents(const string& file_path) {
+  std::ifstream file_stream{file_path, std::ifstream::binary};
+  std::ostringstream contents;
+  contents << file_stream.rdbuf();
+  return HashString(contents.str());
+}
+
+string CreateTempFile(const string& suffix, const string& directory) {
+  string path_template = directory + "/uttamarin_XXXXXX" + suffix;
+  int file_descriptor = mkstemps(path_template.data(), suffix.size());
+  if(file_descriptor != -1) close(file_descriptor);
+  return path_template;
+}
+
+string ShellQuote(const string& text) {
+  string quoted = "'";
+  for(char c : text) {
+    if(c == '\'') {
+      quoted += "'\\''";
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + "'";
+}
+
+std::optional<string> ReadFileAtGitRevision(const string& file_path,
+                                            const string& revision) {
+  auto separator = file_path.rfind('/');
+  auto directory = separator == string::npos ? "." :
+                   file_path.substr(0, separator + 1);
+  auto file_name = separator == string::npos ? file_path :
+                   file_path.substr(separator + 1);
+  // "./" makes git resolve the path relative to the directory of the file
+  return ReadShellCommandOutput("git -C " + ShellQuote(directory) +
+                                " show " +
+                                ShellQuote(revision + ":./" + file_name));
+}
+
+std::optional<string> ReadShellCommandOutput(const string& cmd) {
+  auto fp = popen((cmd + " 2>/dev/null").c_str(), "r");
+  if(fp == nullptr) return std::nullopt;
+  string output;
+  char buffer[4096];
+  size_t bytes_read;
+  while((bytes_read = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+    output.append(buffer, bytes_read);
+  }
+  int status = pclose(fp);
+  if(status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    return std::nullopt;
+  }
+  return output;
+}
+
 int ExecuteShellCommand(const string& cmd) { 
-  auto start_time = std::chrono::high_resolution_clock::now();
-  int status; 
-  auto fp = popen(cmd.c_str(), "r"); 
-  pclose(fp); 
-  auto end_time = std::chrono::high_resolution_clock::now(); 
-  return std::chrono::duration_cast<std::chrono::seconds> 
-    (end_time - start_time).count(); 
+  return static_cast<int>(RunShellCommand(cmd).duration);
+}
+
+ShellCommandResult RunShellCommand(const string& cmd,
+                                   const std::function<void(int)>& on_start,
+                                   double timeout) {
+  auto start_time = std::chrono::steady_clock::now();
+  ShellCommandResult result{-1, 0, 0, 0, 0};
+  auto task_control = TaskControl::GetCurrent();
+  auto start_suspended_time =
+          task_control != nullptr ? task_control->GetSuspendedTime() : 0;
+
+  pid_t pid;
+  {
+    tracing::ScopedSpan span("spawn");
+    auto parent_pid = getpid();
+    pid = fork();
+    if(pid == 0) {
+      setpgid(0, 0);
+      // The own process group does not receive the signals of ours, so the
+      // command must not outlive us if we are killed
+      prctl(PR_SET_PDEATHSIG, SIGKILL);
+      if(getppid() != parent_pid) _exit(127);
+      // Like popen, discard the standard output that is not redirected
+      int null_descriptor = open("/dev/null", O_WRONLY);
+      if(null_descriptor != -1) dup2(null_descriptor, STDOUT_FILENO);
+      execl("/bin/sh", "sh", "-c", cmd.c_str(), static_cast<char*>(nullptr));
+      _exit(127);
+    }
+  }
+  if(pid > 0) {
+    // Both parent and child set the group, so it exists before either goes on
+    setpgid(pid, pid);
+    termination::registerProcessGroup(pid);
+    if(task_control != nullptr) task_control->AddProcessGroup(pid);
+    if(on_start) on_start(pid);
+  }
+
+  auto get_suspended_time = [&] {
+    return task_control != nullptr ?
+           task_control->GetSuspendedTime() - start_suspended_time : 0;
+  };
+  bool is_timed_out = false;
+  if(pid > 0 && timeout > 0) {
+    is_timed_out = !WaitForExit(pid, [&] {
+      return timeout - std::chrono::duration<double>(
+              std::chrono::steady_clock::now() - start_time).count() +
+             get_suspended_time();
+    });
+    if(is_timed_out) TerminateProcessGroup(pid);
+  }
+
+  int status;
+  struct rusage usage;
+  pid_t waited_pid = -1;
+  if(pid > 0) {
+    do {
+      waited_pid = wait4(pid, &status, 0, &usage);
+    } while(waited_pid == -1 && errno == EINTR);
+    if(task_control != nullptr) task_control->RemoveProcessGroup(pid);
+    termination::unregisterProcessGroup(pid);
+  }
+  auto end_time = std::chrono::steady_clock::now();
+  result.duration =
+          std::chrono::duration<double>(end_time - start_time).count() -
+          get_suspended_time();
+  if(waited_pid != pid) return result;
+
+  if(is_timed_out) result.exit_code = kTimeoutExitCode;
+  else if(WIFEXITED(status)) result.exit_code = WEXITSTATUS(status);
+  else result.exit_code = 128 + WTERMSIG(status);
+  // The usage includes all descendants of the shell that were waited for
+  result.cpu_time = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+                    (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+  result.max_rss = usage.ru_maxrss;
+  result.major_faults = usage.ru_majflt;
+  return result;
 }
 
 } // namespace uttamarin
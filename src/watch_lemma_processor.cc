@@ -0,0 +1,183 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "watch_lemma_processor.h"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "lemma_job.h"
+#include "theory_index.h"
+#include "utility.h"
+
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+
+namespace uttamarin {
+
+namespace {
+
+TamarinOutput CreateCancelledOutput(const LemmaJob& lemma_job) {
+  TamarinOutput tamarin_output;
+  tamarin_output.result = ProverResult::Unknown;
+  tamarin_output.duration = 0;
+  tamarin_output.heuristic = lemma_job.GetHeuristic();
+  tamarin_output.failure_reason = FailureReason::Cancelled;
+  return tamarin_output;
+}
+
+} // namespace
+
+WatchedJobs::WatchedJobs() :
+  run_(0),
+  running_jobs_(0) {
+}
+
+WatchedJobs::~WatchedJobs() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for(auto& [key, job] : job_of_) {
+    if(!job->output.has_value()) job->control.Cancel();
+  }
+  job_finished_.wait(lock, [this] { return running_jobs_ == 0; });
+}
+
+string WatchedJobs::GetKey(const TheoryIndex& theory_index,
+                           const string& context_hash,
+                           const LemmaJob& lemma_job) {
+  // Tamarin uses the heuristic 's' if no heuristic is given, and the
+  // heuristic of a lemma may switch between both (e.g., once the history
+  // knows the lemma)
+  auto heuristic = lemma_job.GetHeuristic().empty() ?
+                   ToString(TamarinHeuristic::s) : lemma_job.GetHeuristic();
+  return HashString(
+          theory_index.GetLemmaConeHash(lemma_job.GetLemmaName()) + "\n" +
+          lemma_job.GetLemmaName() + "\n" + heuristic + "\n" +
+          context_hash);
+}
+
+int WatchedJobs::StartRun(const std::set<string>& keys, int& cancelled_jobs) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cancelled_jobs = 0;
+  for(auto it = job_of_.begin();it != job_of_.end();) {
+    if(keys.count(it->first) == 0 && !it->second->output.has_value()) {
+      it->second->control.Cancel();
+      ++cancelled_jobs;
+      it = job_of_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  ++run_;
+  job_finished_.notify_all();
+  return run_;
+}
+
+bool WatchedJobs::IsRunning(const string& key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = job_of_.find(key);
+  return it != job_of_.end() && !it->second->output.has_value();
+}
+
+bool WatchedJobs::HasResult(const string& key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = job_of_.find(key);
+  return it != job_of_.end() && it->second->output.has_value();
+}
+
+TamarinOutput WatchedJobs::Process(int run, const string& key,
+                                   const LemmaJob& lemma_job,
+                                   std::function<TamarinOutput()> process) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if(run != run_) return CreateCancelledOutput(lemma_job);
+  auto& job = job_of_[key];
+  if(job == nullptr) {
+    job = std::make_shared<Job>();
+    ++running_jobs_;
+    std::thread([this, job, key, process] {
+      TaskControl::SetCurrent(&job->control);
+      auto output = process();
+      TaskControl::SetCurrent(nullptr);
+      std::lock_guard<std::mutex> lock(mutex_);
+      job->output = output;
+      // Jobs without a result to reuse (e.g., cancelled ones) run again
+      if(output.failure_reason == FailureReason::Cancelled) {
+        auto it = job_of_.find(key);
+        if(it != job_of_.end() && it->second == job) job_of_.erase(it);
+      }
+      --running_jobs_;
+      job_finished_.notify_all();
+    }).detach();
+  }
+  auto awaited_job = job;
+  job_finished_.wait(lock, [&] {
+    return awaited_job->output.has_value() || run != run_;
+  });
+  if(!awaited_job->output.has_value()) return CreateCancelledOutput(lemma_job);
+  return awaited_job->output.value();
+}
+
+WatchLemmaProcessor::WatchLemmaProcessor(
+        unique_ptr<LemmaProcessor> decoratee,
+        shared_ptr<WatchedJobs> watched_jobs,
+        int run,
+        shared_ptr<const TheoryIndex> theory_index,
+        const string& context_hash) :
+  decoratee_(std::move(decoratee)),
+  watched_jobs_(watched_jobs),
+  run_(run),
+  theory_index_(theory_index),
+  context_hash_(context_hash) {
+}
+
+TamarinOutput WatchLemmaProcessor::DoProcessLemma(const LemmaJob& lemma_job) {
+  auto key = WatchedJobs::GetKey(*theory_index_, context_hash_, lemma_job);
+  // The App removes the preprocessed theory as soon as the job of its run
+  // ends, which may be before Tamarin read it if a later run takes over.
+  // The job therefore runs on a copy that is removed with its last owner.
+  shared_ptr<const string> spthy_copy_path(
+          new string(CreateTempFile(".spthy")), [](const string* path) {
+            std::remove(path->c_str());
+            delete path;
+          });
+  {
+    std::ifstream source(lemma_job.GetSpthyFilePath());
+    std::ofstream copy(*spthy_copy_path);
+    copy << source.rdbuf();
+  }
+  auto job = lemma_job;
+  job.SetSpthyFilePath(*spthy_copy_path);
+  auto decoratee = decoratee_;
+  return watched_jobs_->Process(run_, key, lemma_job,
+                                [decoratee, job, spthy_copy_path] {
+    return decoratee->ProcessLemma(job);
+  });
+}
+
+} // namespace uttamarin
@@ -0,0 +1,101 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace uttamarin {
+
+namespace {
+
+thread_local int current_worker_index = -1;
+
+} // namespace
+
+WorkerPool::WorkerPool(int number_of_workers) :
+  unfinished_tasks_(0),
+  is_stopping_(false) {
+  for(int i = 0;i < std::max(number_of_workers, 1);++i) {
+    workers_.emplace_back(&WorkerPool::RunWorker, this, i);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  Wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  task_available_.notify_all();
+  for(auto& worker : workers_) worker.join();
+}
+
+void WorkerPool::Submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.emplace_back(std::move(task));
+    ++unfinished_tasks_;
+  }
+  task_available_.notify_one();
+}
+
+void WorkerPool::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  all_tasks_finished_.wait(lock, [this] { return unfinished_tasks_ == 0; });
+}
+
+int WorkerPool::GetNumberOfWorkers() const {
+  return workers_.size();
+}
+
+int WorkerPool::GetCurrentWorkerIndex() {
+  return current_worker_index;
+}
+
+void WorkerPool::RunWorker(int worker_index) {
+  current_worker_index = worker_index;
+  while(true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      task_available_.wait(lock, [this] {
+        return is_stopping_ || !tasks_.empty();
+      });
+      if(tasks_.empty()) return;
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --unfinished_tasks_;
+    }
+    all_tasks_finished_.notify_all();
+  }
+}
+
+} // namespace uttamarin
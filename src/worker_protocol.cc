@@ -0,0 +1,169 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "worker_protocol.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "tamarin_output_parser.h"
+
+using std::string;
+using json = nlohmann::json;
+
+namespace uttamarin {
+
+namespace {
+
+// Largest message that is accepted, which protects workers from reading
+// arbitrary data as the length of a message
+const uint32_t kMaxMessageSize = 1U << 30;
+
+bool WriteAll(int file_descriptor, const char* data, size_t size) {
+  while(size > 0) {
+    auto written = write(file_descriptor, data, size);
+    if(written < 0 && errno == EINTR) continue;
+    if(written <= 0) return false;
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+bool ReadAll(int file_descriptor, char* data, size_t size) {
+  while(size > 0) {
+    auto received = read(file_descriptor, data, size);
+    if(received < 0 && errno == EINTR) continue;
+    if(received <= 0) return false;
+    data += received;
+    size -= received;
+  }
+  return true;
+}
+
+string ToProtocolString(const ProverResult& result) {
+  switch(result) {
+    case ProverResult::True: return "verified";
+    case ProverResult::False: return "falsified";
+    default: return "unknown";
+  }
+}
+
+ProverResult ToProverResult(const string& result) {
+  if(result == "verified") return ProverResult::True;
+  if(result == "falsified") return ProverResult::False;
+  return ProverResult::Unknown;
+}
+
+} // namespace
+
+bool SendMessage(int file_descriptor, const json& message) {
+  auto payload = message.dump();
+  if(payload.size() > kMaxMessageSize) return false;
+  uint32_t size = payload.size();
+  char header[4] = {static_cast<char>(size >> 24),
+                    static_cast<char>(size >> 16),
+                    static_cast<char>(size >> 8),
+                    static_cast<char>(size)};
+  return WriteAll(file_descriptor, header, sizeof(header)) &&
+         WriteAll(file_descriptor, payload.data(), payload.size());
+}
+
+bool ReceiveMessage(int file_descriptor, json& message) {
+  unsigned char header[4];
+  if(!ReadAll(file_descriptor, reinterpret_cast<char*>(header),
+              sizeof(header))) {
+    return false;
+  }
+  uint32_t size = (uint32_t{header[0]} << 24) | (uint32_t{header[1]} << 16) |
+                  (uint32_t{header[2]} << 8) | uint32_t{header[3]};
+  if(size > kMaxMessageSize) return false;
+  string payload(size, '\0');
+  if(!ReadAll(file_descriptor, payload.data(), size)) return false;
+  message = json::parse(payload, nullptr, false);
+  return message.is_object();
+}
+
+json ToJson(const TamarinOutput& tamarin_output) {
+  const auto& gc_statistics = tamarin_output.gc_statistics;
+  return json{{"result", ToProtocolString(tamarin_output.result)},
+              {"duration", tamarin_output.duration},
+              {"heuristic", tamarin_output.heuristic},
+              {"failure", ToString(tamarin_output.failure_reason)},
+              {"wall_time", tamarin_output.wall_time},
+              {"processing_time", tamarin_output.processing_time},
+              {"cpu_time", tamarin_output.cpu_time},
+              {"max_rss", tamarin_output.max_rss},
+              {"major_faults", tamarin_output.major_faults},
+              {"steps", tamarin_output.steps},
+              {"warnings", tamarin_output.warnings},
+              {"error", tamarin_output.error},
+              {"gc", {{"bytes_allocated", gc_statistics.bytes_allocated},
+                      {"max_residency", gc_statistics.max_residency},
+                      {"number_of_gcs", gc_statistics.number_of_gcs},
+                      {"gc_cpu_time", gc_statistics.gc_cpu_time},
+                      {"mutator_cpu_time", gc_statistics.mutator_cpu_time},
+                      {"gc_time_fraction", gc_statistics.gc_time_fraction},
+                      {"productivity", gc_statistics.productivity},
+                      {"parallel_gc_balance",
+                       gc_statistics.parallel_gc_balance}}}};
+}
+
+TamarinOutput ToTamarinOutput(const json& json_output) {
+  TamarinOutput tamarin_output;
+  tamarin_output.result = ToProverResult(json_output.value("result", ""));
+  tamarin_output.duration = json_output.value("duration", 0);
+  tamarin_output.heuristic = json_output.value("heuristic", "");
+  tamarin_output.failure_reason =
+          ToFailureReason(json_output.value("failure", ""));
+  tamarin_output.wall_time = json_output.value("wall_time", 0.0);
+  tamarin_output.processing_time =
+          json_output.value("processing_time", -1.0);
+  tamarin_output.cpu_time = json_output.value("cpu_time", 0.0);
+  tamarin_output.max_rss = json_output.value("max_rss", 0L);
+  tamarin_output.major_faults = json_output.value("major_faults", 0L);
+  tamarin_output.steps = json_output.value("steps", -1);
+  tamarin_output.warnings =
+          json_output.value("warnings", std::vector<string>{});
+  tamarin_output.error = json_output.value("error", "");
+  auto json_gc = json_output.value("gc", json::object());
+  auto& gc_statistics = tamarin_output.gc_statistics;
+  gc_statistics.bytes_allocated = json_gc.value("bytes_allocated", -1LL);
+  gc_statistics.max_residency = json_gc.value("max_residency", 0LL);
+  gc_statistics.number_of_gcs = json_gc.value("number_of_gcs", 0LL);
+  gc_statistics.gc_cpu_time = json_gc.value("gc_cpu_time", 0.0);
+  gc_statistics.mutator_cpu_time = json_gc.value("mutator_cpu_time", 0.0);
+  gc_statistics.gc_time_fraction = json_gc.value("gc_time_fraction", 0.0);
+  gc_statistics.productivity = json_gc.value("productivity", 0.0);
+  gc_statistics.parallel_gc_balance =
+          json_gc.value("parallel_gc_balance", -1.0);
+  return tamarin_output;
+}
+
+} // namespace uttamarin
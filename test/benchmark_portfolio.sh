@@ -0,0 +1,46 @@
+#!/usr/bin/env bash
+# Compares the sequential run of the heuristics in the fixed penetration order
+# (each with the full timeout, until one of them produces a definitive result)
+# with the Luby portfolio (--portfolio) on the given lemmas. Run this file from
+# its parent directory, e.g.:
+#   ./test/benchmark_portfolio.sh ./test/test_protocol.spthy 60 \
+#     first_true_statement non_terminating_statement
+UTTAMARIN=${UTTAMARIN:-./build/bin/uttamarin}
+SPTHY_FILE=$1
+TIMEOUT=$2
+shift 2
+# The order of PenetrationLemmaJobGenerator::GetAllHeuristics
+HEURISTICS="S s I i C c P p"
+
+CONFIG_FILE=$(mktemp /tmp/uttamarin_benchmark_XXXXXX.json)
+OUTPUT_FILE=$(mktemp /tmp/uttamarin_benchmark_XXXXXX.out)
+sequential_total=0
+portfolio_total=0
+
+for lemma in "$@"; do
+  start=$(date +%s%3N)
+  for heuristic in $HEURISTICS; do
+    echo "{ \"lemma_allow_list\": [\"$lemma\"], \"lemma_heuristics\": [" \
+         "{ \"lemma_name\": \"$lemma\", \"heuristic\": \"$heuristic\" } ] }" \
+         > "$CONFIG_FILE"
+    $UTTAMARIN "$SPTHY_FILE" --config_file="$CONFIG_FILE" \
+      --timeout="$TIMEOUT" --no_history --quiet > "$OUTPUT_FILE"
+    grep -q "verified: 1\|false: 1" "$OUTPUT_FILE" && break
+  done
+  sequential=$(( $(date +%s%3N) - start ))
+
+  echo "{ \"lemma_allow_list\": [\"$lemma\"] }" > "$CONFIG_FILE"
+  start=$(date +%s%3N)
+  $UTTAMARIN "$SPTHY_FILE" --config_file="$CONFIG_FILE" --portfolio \
+    --timeout="$TIMEOUT" --no_history --quiet > /dev/null
+  portfolio=$(( $(date +%s%3N) - start ))
+
+  printf "%-40s sequential: %8d ms  portfolio: %8d ms\n" \
+    "$lemma" "$sequential" "$portfolio"
+  sequential_total=$(( sequential_total + sequential ))
+  portfolio_total=$(( portfolio_total + portfolio ))
+done
+
+printf "%-40s sequential: %8d ms  portfolio: %8d ms\n" \
+  "Total" "$sequential_total" "$portfolio_total"
+rm -f "$CONFIG_FILE" "$OUTPUT_FILE"
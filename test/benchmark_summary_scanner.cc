@@ -0,0 +1,112 @@
+// MIT License
+//
+// Copyright (c) 2020 Benjamin Kiesl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// Compares reading the whole Tamarin output line by line with locating the
+// summary at the end of a memory-mapped output (ReadSummarySection). Builds
+// with -DUTTAMARIN_BUILD_BENCHMARKS=ON; usage:
+//   ./build/bin/benchmark_summary_scanner [size of the output in MB]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "lemma_processor.h"
+#include "tamarin_output_parser.h"
+#include "utility.h"
+
+using namespace uttamarin;
+
+namespace {
+
+const int kNumberOfLemmas = 100;
+const int kRepetitions = 5;
+
+// Writes a synthetic Tamarin output with a proof of about 'size_in_mb' MB
+// followed by the summary of summaries.
+void WriteSyntheticOutput(const std::string& path, int size_in_mb) {
+  std::ofstream output{path};
+  const std::string proof_line =
+          "      case Init_case_1 solve( !KU( senc(<'1', ~n>, ~k) ) @ #vk )\n";
+  for(size_t written = 0;written < size_in_mb * 1024ULL * 1024ULL;
+      written += proof_line.size()) {
+    output << proof_line;
+  }
+  output << "\n===================================================="
+            "==========================\n"
+         << "summary of summaries:\n\nanalyzed: protocol.spthy\n\n"
+         << "  processing time: 42.17s\n\n";
+  for(int i = 0;i < kNumberOfLemmas;++i) {
+    output << "  lemma_" << i << " (all-traces): verified (" << 10 + i
+           << " steps)\n";
+  }
+  output << "\n===================================================="
+            "==========================\n";
+}
+
+template<typename F>
+double MeasureMilliseconds(F function) {
+  auto start_time = std::chrono::steady_clock::now();
+  for(int i = 0;i < kRepetitions;++i) function();
+  auto end_time = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end_time - start_time)
+         .count() / kRepetitions;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  int size_in_mb = argc > 1 ? std::atoi(argv[1]) : 256;
+  auto output_path = CreateTempFile(".ut");
+  WriteSyntheticOutput(output_path, size_in_mb);
+  auto lemma_name = "lemma_" + std::to_string(kNumberOfLemmas - 1);
+
+  TamarinOutput line_by_line_output;
+  auto line_by_line_time = MeasureMilliseconds([&] {
+    std::ifstream tamarin_stream{output_path};
+    ParseTamarinOutput(tamarin_stream, lemma_name, line_by_line_output);
+  });
+
+  TamarinOutput summary_output;
+  auto summary_time = MeasureMilliseconds([&] {
+    std::istringstream summary_stream{
+            ReadSummarySection(output_path).value_or("")};
+    ParseTamarinOutput(summary_stream, lemma_name, summary_output);
+  });
+
+  std::remove(output_path.c_str());
+
+  if(line_by_line_output.steps != summary_output.steps ||
+     summary_output.result != ProverResult::True) {
+    std::cerr << "Error: the parsers disagree." << std::endl;
+    return 1;
+  }
+  std::cout << "Output size:    " << size_in_mb << " MB\n"
+            << "Line by line:   " << line_by_line_time << " ms\n"
+            << "Summary scan:   " << summary_time << " ms\n"
+            << "Speedup:        " << line_by_line_time / summary_time << "x"
+            << std::endl;
+  return 0;
+}
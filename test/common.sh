@@ -0,0 +1,68 @@
+# Shared by the behavior tests (test/test_*.sh), which run from the parent
+# directory of this file, e.g., ./test/test_workers.sh. They run the stand-in
+# test/stub/tamarin-prover instead of Tamarin and print one line per check.
+UTTAMARIN=$(realpath "${UTTAMARIN:-./build/bin/uttamarin}")
+PROTOCOL=$(realpath ./test/test_protocol.spthy)
+export PATH="$(realpath ./test/stub):$PATH"
+TEST_DIR=$(mktemp -d /tmp/uttamarin_test_XXXXXX)
+BACKGROUND_PIDS=()
+FAILURES=0
+
+cleanup() {
+  for pid in "${BACKGROUND_PIDS[@]}"; do kill "$pid" 2> /dev/null; done
+  wait 2> /dev/null
+  rm -rf "$TEST_DIR"
+}
+trap cleanup EXIT
+
+# Runs the given command in the background until the test ends
+background() {
+  "$@" &
+  BACKGROUND_PIDS+=($!)
+}
+
+# Prints whether the command after the description succeeds
+check() {
+  local description=$1
+  shift
+  if "$@"; then
+    echo "PASS: $description"
+  else
+    echo "FAIL: $description"
+    FAILURES=$((FAILURES + 1))
+  fi
+}
+
+# Succeeds if the given file contains a line that matches the given pattern
+contains() {
+  grep -q -- "$2" "$1"
+}
+
+# Succeeds if no line of the given file matches the given pattern
+lacks() {
+  ! grep -q -- "$2" "$1"
+}
+
+# Succeeds if the parts of the given file that match the given pattern are
+# the given words, in this order
+matches_in_order() {
+  local file=$1
+  local pattern=$2
+  shift 2
+  [ "$(grep -o -- "$pattern" "$file" | tr '\n' ' ')" = "$* " ]
+}
+
+# Waits up to ten seconds for the given file to contain the given pattern
+wait_for() {
+  for _ in $(seq 100); do
+    contains "$1" "$2" && return 0
+    sleep 0.1
+  done
+  return 1
+}
+
+finish() {
+  [ "$FAILURES" -eq 0 ] && echo "All checks passed." ||
+    echo "$FAILURES check(s) failed."
+  exit $((FAILURES > 0))
+}
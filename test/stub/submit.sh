@@ -0,0 +1,12 @@
+#!/bin/sh
+# Stand-in for the submit command of a batch system (see --batch_submit) in
+# test/test_batch.sh: runs the array tasks 0 to $1 of the script $2 on this
+# host in the background, like "sbatch --array=0-{last} {script}".
+last=$1
+script=$2
+index=0
+while [ "$index" -le "$last" ]; do
+  UTTAMARIN_ARRAY_INDEX=$index sh "$script" > /dev/null 2>&1 &
+  index=$((index + 1))
+done
+echo "Submitted batch job 1"
@@ -0,0 +1,46 @@
+#!/usr/bin/env bash
+# Checks that the heuristic bandit ranks heuristics by the wall time of their
+# results on similar lemmas, without counting crashes and while counting short
+# timeouts less, and that --bandit_report replays the history with wall times.
+# Run this file from its parent directory.
+source ./test/common.sh
+
+HISTORY="$TEST_DIR/history.jsonl"
+# The features of first_true_statement (see TheoryIndex::GetLemmaFeatures)
+FEATURES='["trace:all","quantifier:All","quantifiers:1","alternations:0",'\
+'"implication","fact:K"]'
+
+# Appends a record of an earlier theory to the history
+record() {
+  echo "{\"lemma\": \"$1\", \"heuristic\": \"$2\", \"result\": \"$3\"," \
+       "\"failure\": \"$4\", \"duration\": 0, \"wall_time\": $5," \
+       "\"theory_hash\": \"earlier\", \"timestamp\": 1," \
+       "\"features\": $FEATURES}" >> "$HISTORY"
+}
+
+# Both results take less than a second, C is faster
+for lemma in similar_lemma other_similar_lemma; do
+  record "$lemma" S verified "" 0.9
+  record "$lemma" C verified "" 0.2
+done
+for _ in 1 2 3; do record crashing_lemma C unknown crash 0.1; done
+# Probes of I timed out after a second, P had a whole minute
+record similar_lemma I unknown timeout 1
+record similar_lemma I unknown timeout 1
+record similar_lemma P unknown timeout 60
+
+"$UTTAMARIN" "$PROTOCOL" --history_file="$HISTORY" --bandit_report \
+  > "$TEST_DIR/report" 2>&1
+check "the replay picks the heuristic with the faster wall time" \
+  contains "$TEST_DIR/report" "similar_lemma: first=C fixed order 0.90s"
+check "the replay sums up wall times" \
+  contains "$TEST_DIR/report" "Fixed order: 1.80s, bandit: 0.40s"
+
+STUB_DELAY=0.05 "$UTTAMARIN" "$PROTOCOL" -j 1 --history_file="$HISTORY" \
+  --penetration_lemma first_true_statement > "$TEST_DIR/penetration" 2>&1
+check "penetration mode tries the heuristics in the order of the bandit" \
+  matches_in_order "$TEST_DIR/penetration" "heuristic=[A-Za-z]*" \
+  heuristic=C heuristic=S heuristic=s heuristic=i heuristic=c heuristic=p \
+  heuristic=I heuristic=P
+
+finish
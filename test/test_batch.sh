@@ -0,0 +1,36 @@
+#!/usr/bin/env bash
+# Checks that lemmas run as job arrays on a batch system, with the stand-in
+# test/stub/submit.sh instead of the real scheduler, and that array tasks that
+# never run fail once their deadline has passed.
+# Run this file from its parent directory.
+source ./test/common.sh
+
+SUBMIT="$(realpath ./test/stub/submit.sh) {last} {script}"
+mkdir "$TEST_DIR/shared"
+
+"$UTTAMARIN" "$PROTOCOL" -t 3 --no_history -q --batch_dir "$TEST_DIR/shared" \
+  --batch_submit "$SUBMIT" > "$TEST_DIR/output" 2>&1
+check "all lemmas ran as array tasks" \
+  contains "$TEST_DIR/output" "verified: 6, false: 3, timeout: 1"
+check "results of the array tasks are read" \
+  contains "$TEST_DIR/output" "first_false_statement .*false.*3 steps"
+
+# A submit command that fails
+"$UTTAMARIN" "$PROTOCOL" -t 3 --no_history -q --batch_dir "$TEST_DIR/shared" \
+  --batch_submit "false" --lemma first_true_statement \
+  > "$TEST_DIR/failed_submit" 2>&1
+check "failed submission reported" \
+  contains "$TEST_DIR/failed_submit" "first_true_statement .*unverified"
+
+# A scheduler that accepts the array but never runs it. The deadline is the
+# timeout, the queue grace period and a minute for the status file.
+start=$SECONDS
+timeout 120 "$UTTAMARIN" "$PROTOCOL" -t 1 --no_history -q \
+  --batch_dir "$TEST_DIR/shared" --batch_submit "true" --batch_queue_grace 1 \
+  --lemma first_true_statement > "$TEST_DIR/lost_task" 2>&1
+check "lost array task fails at its deadline" \
+  [ $((SECONDS - start)) -lt 100 ]
+check "lost array task reported" \
+  contains "$TEST_DIR/lost_task" "first_true_statement .*unverified"
+
+finish
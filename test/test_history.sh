@@ -0,0 +1,36 @@
+#!/usr/bin/env bash
+# Checks that runs take the fastest heuristic of a lemma from the history,
+# unless the config pins a heuristic for it.
+# Run this file from its parent directory.
+source ./test/common.sh
+
+HISTORY="$TEST_DIR/history.jsonl"
+LEMMA=first_true_statement
+
+# All heuristics take less than a second, and c is the fastest of them but
+# not the last one that penetration mode runs
+STUB_DELAY=0.3 STUB_FAST_HEURISTIC=c "$UTTAMARIN" "$PROTOCOL" -j 1 -q \
+  --penetration_lemma="$LEMMA" --history_file="$HISTORY" > /dev/null 2>&1
+
+"$UTTAMARIN" "$PROTOCOL" -q --lemma "$LEMMA" --history_file="$HISTORY" \
+  > "$TEST_DIR/fastest" 2>&1
+check "fastest heuristic of the history by wall time" \
+  contains "$TEST_DIR/fastest" "$LEMMA .* heuristic=c "
+
+echo "{ \"lemma_heuristics\": [ { \"lemma_name\": \"$LEMMA\"," \
+     "\"heuristic\": \"I\" } ] }" > "$TEST_DIR/config.json"
+"$UTTAMARIN" "$PROTOCOL" -q --lemma "$LEMMA" --history_file="$HISTORY" \
+  --config_file="$TEST_DIR/config.json" > "$TEST_DIR/pinned" 2>&1
+check "heuristic of the config pinned over the history" \
+  contains "$TEST_DIR/pinned" "$LEMMA .* heuristic=I "
+
+# An even faster record whose heuristic Tamarin does not know
+grep '"heuristic":"c"' "$HISTORY" | head -n 1 |
+  sed -e 's/"heuristic":"c"/"heuristic":"c --bound=1"/' \
+      -e 's/"wall_time":[0-9.e-]*/"wall_time":0.001/' >> "$HISTORY"
+"$UTTAMARIN" "$PROTOCOL" -q --lemma "$LEMMA" --history_file="$HISTORY" \
+  > "$TEST_DIR/invalid" 2>&1
+check "invalid heuristic of the history ignored" \
+  contains "$TEST_DIR/invalid" "$LEMMA .* heuristic=c "
+
+finish
@@ -0,0 +1,40 @@
+#!/usr/bin/env bash
+# Checks that incremental mode (--incremental) only runs Tamarin again on the
+# lemmas that depend on an edited rule, and reports the others with their
+# earlier proof.
+# Run this file from its parent directory.
+source ./test/common.sh
+
+THEORY="$TEST_DIR/test_protocol.spthy"
+HISTORY="$TEST_DIR/history.jsonl"
+cp "$PROTOCOL" "$THEORY"
+# Only non_terminating_statement depends on the rule Loop (the others only
+# use the adversary knowledge K), and it terminates with the heuristic C
+echo '{ "lemma_heuristics": [ { "lemma_name": "non_terminating_statement",' \
+     '"heuristic": "C" } ] }' > "$TEST_DIR/config.json"
+run() {
+  STUB_WINNING_HEURISTIC=C "$UTTAMARIN" "$THEORY" -q --incremental \
+    --history_file="$HISTORY" --config_file="$TEST_DIR/config.json" "$@"
+}
+
+run > "$TEST_DIR/first" 2>&1
+check "the first run verifies the lemmas" \
+  contains "$TEST_DIR/first" "verified: 7, false: 3"
+
+sed -i 's/--\[ Loop(~X) \]->/--[ Loop(~X), Again(~X) ]->/' "$THEORY"
+records_before=$(wc -l < "$HISTORY")
+run > "$TEST_DIR/second" 2>&1
+check "only the dependent lemma and the false lemmas run again" \
+  [ $(($(wc -l < "$HISTORY") - records_before)) -eq 4 ]
+check "the dependent lemma is verified again" \
+  contains "$TEST_DIR/second" "non_terminating_statement .*steps) heuristic=C"
+check "the other lemmas are reported as unchanged" \
+  contains "$TEST_DIR/second" "first_true_statement .*steps, unchanged)"
+check "the report starts with the header" \
+  [ "$(head -n 1 "$TEST_DIR/second")" = \
+    "Tamarin Tests for file 'test_protocol.spthy':" ]
+check "the summary counts and explains the unchanged lemmas" \
+  matches_in_order "$TEST_DIR/second" "verified: 7, false: 3\|were not run" \
+  "verified: 7, false: 3" "were not run"
+
+finish
@@ -0,0 +1,31 @@
+#!/usr/bin/env bash
+# Checks that parallel results are printed in the order in which they finish
+# and, with --ordered_output, in the order of the theory.
+# Run this file from its parent directory.
+source ./test/common.sh
+
+LEMMAS=(first_true_statement first_false_statement second_true_statement
+        third_true_statement)
+LEMMA_OPTIONS=()
+for lemma in "${LEMMAS[@]}"; do LEMMA_OPTIONS+=(--lemma "$lemma"); done
+
+# The first lemma finishes last
+export STUB_SLOW_LEMMA=first_true_statement
+"$UTTAMARIN" "$PROTOCOL" -j 4 --no_history -q "${LEMMA_OPTIONS[@]}" \
+  > "$TEST_DIR/completion" 2>&1
+check "results in the order of completion" \
+  matches_in_order "$TEST_DIR/completion" "([0-9]/4)" \
+  "(1/4)" "(2/4)" "(3/4)" "(4/4)"
+check "slow lemma printed last" \
+  contains "$TEST_DIR/completion" "first_true_statement .*(4/4)"
+
+"$UTTAMARIN" "$PROTOCOL" -j 4 --no_history -q --ordered_output \
+  "${LEMMA_OPTIONS[@]}" > "$TEST_DIR/ordered" 2>&1
+check "results in the order of the theory" \
+  matches_in_order "$TEST_DIR/ordered" "^[a-z_]*_statement" "${LEMMAS[@]}"
+check "results numbered like a sequential run" \
+  contains "$TEST_DIR/ordered" "third_true_statement .*(4/4)"
+check "summary after all results" \
+  contains "$TEST_DIR/ordered" "verified: 3, false: 1"
+
+finish
@@ -0,0 +1,33 @@
+#!/usr/bin/env bash
+# Checks that an interactive run on a busy server suspends a batch run, also
+# when a host-wide jobserver with a single slot limits the server.
+# Run this file from its parent directory.
+source ./test/common.sh
+
+background "$UTTAMARIN" jobserver --slots 1 --fifo "$TEST_DIR/jobserver" \
+  > "$TEST_DIR/jobserver.log" 2>&1
+wait_for "$TEST_DIR/jobserver.log" "Jobserver with 1 slot"
+background "$UTTAMARIN" serve -j 1 --jobserver "$TEST_DIR/jobserver" \
+  --socket "$TEST_DIR/socket" --no_history > "$TEST_DIR/server.log" 2>&1
+for _ in $(seq 100); do [ -S "$TEST_DIR/socket" ] && break; sleep 0.1; done
+
+# The batch run holds the only worker and slot until its timeout
+"$UTTAMARIN" --server "$TEST_DIR/socket" -t 6 \
+  --lemma non_terminating_statement "$PROTOCOL" > "$TEST_DIR/batch" 2>&1 &
+BATCH_PID=$!
+sleep 1
+
+start=$SECONDS
+timeout 20 "$UTTAMARIN" --server "$TEST_DIR/socket" --priority interactive \
+  --lemma first_true_statement "$PROTOCOL" > "$TEST_DIR/interactive" 2>&1
+interactive_seconds=$((SECONDS - start))
+check "interactive run verified" \
+  contains "$TEST_DIR/interactive" "first_true_statement .*verified"
+check "interactive run did not wait for the batch run" \
+  [ "$interactive_seconds" -lt 5 ]
+
+wait "$BATCH_PID"
+check "batch run resumed and timed out" \
+  contains "$TEST_DIR/batch" "non_terminating_statement .*timeout"
+
+finish
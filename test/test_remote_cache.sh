@@ -0,0 +1,36 @@
+#!/usr/bin/env bash
+# Checks that a local cache server (uttamarin cache_server) only stores the
+# results of runs with its write token and serves them to later runs.
+# Run this file from its parent directory.
+source ./test/common.sh
+
+PORT=$((20000 + RANDOM % 20000))
+echo "secret" > "$TEST_DIR/token"
+echo "guess" > "$TEST_DIR/wrong_token"
+background "$UTTAMARIN" cache_server --listen "127.0.0.1:$PORT" \
+  --dir "$TEST_DIR/cache" --token_file "$TEST_DIR/token" \
+  > "$TEST_DIR/server.log" 2>&1
+wait_for "$TEST_DIR/server.log" "Serving"
+CACHE_OPTIONS=(--remote_cache "http://127.0.0.1:$PORT" --lemma
+               first_true_statement --lemma first_false_statement)
+
+"$UTTAMARIN" "$PROTOCOL" -q --no_history "${CACHE_OPTIONS[@]}" \
+  --remote_cache_token "$TEST_DIR/wrong_token" > "$TEST_DIR/wrong" 2>&1
+check "a wrong token is rejected" \
+  contains "$TEST_DIR/wrong" "refuses to store results (HTTP status 403)"
+
+"$UTTAMARIN" "$PROTOCOL" -q --no_history "${CACHE_OPTIONS[@]}" \
+  --remote_cache_token "$TEST_DIR/token" > "$TEST_DIR/first" 2>&1
+check "the first run runs Tamarin" \
+  lacks "$TEST_DIR/first" "result cache"
+check "the results are stored under SHA-256 keys" \
+  [ "$(ls "$TEST_DIR/cache/results" | grep -c '^[0-9a-f]\{64\}$')" -eq 2 ]
+
+"$UTTAMARIN" "$PROTOCOL" -q --no_history "${CACHE_OPTIONS[@]}" \
+  > "$TEST_DIR/second" 2>&1
+check "the second run is served from the cache" \
+  contains "$TEST_DIR/second" "Note: some results were taken from the result"
+check "the cached results are the same" \
+  contains "$TEST_DIR/second" "verified: 1, false: 1"
+
+finish
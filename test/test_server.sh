@@ -0,0 +1,75 @@
+#!/usr/bin/env bash
+# Checks that a server (uttamarin serve) only lets other users connect if it
+# is shared, cancels the run of a client that goes away, only reads the files
+# that the user of a client may read and shares its workers fairly between
+# users. The checks with another user need root and setpriv.
+# Run this file from its parent directory.
+source ./test/common.sh
+
+# Other users need to reach the binary, the theory and the socket
+chmod 755 "$TEST_DIR"
+cp "$UTTAMARIN" "$PROTOCOL" "$TEST_DIR"
+UTTAMARIN="$TEST_DIR/uttamarin"
+PROTOCOL="$TEST_DIR/test_protocol.spthy"
+
+STUB_DELAY=1 background "$UTTAMARIN" serve -j 1 --no_history \
+  --socket "$TEST_DIR/private_socket" > "$TEST_DIR/private_server.log" 2>&1
+wait_for "$TEST_DIR/private_server.log" "Listening"
+check "only the user of the server may connect" \
+  [ "$(stat -c %a "$TEST_DIR/private_socket")" = 600 ]
+
+"$UTTAMARIN" --server "$TEST_DIR/private_socket" -t 60 \
+  --lemma non_terminating_statement "$PROTOCOL" > /dev/null 2>&1 &
+CLIENT_PID=$!
+wait_for_tamarin() {
+  for _ in $(seq 100); do
+    pgrep -f -- "--prove=non_terminating_statement" > /dev/null && return 0
+    sleep 0.1
+  done
+  return 1
+}
+check "the run of the client started" wait_for_tamarin
+kill "$CLIENT_PID"
+sleep 2
+check "the run of a client that went away is cancelled" \
+  [ -z "$(pgrep -f -- "--prove=non_terminating_statement")" ]
+
+if [ "$(id -u)" -ne 0 ] || ! command -v setpriv > /dev/null; then
+  echo "SKIP: the checks with another user"
+  finish
+fi
+as_nobody() {
+  setpriv --reuid=65534 --regid=65534 --clear-groups "$@"
+}
+
+STUB_DELAY=1 background "$UTTAMARIN" serve -j 1 --no_history --shared \
+  --socket "$TEST_DIR/shared_socket" > "$TEST_DIR/shared_server.log" 2>&1
+wait_for "$TEST_DIR/shared_server.log" "Listening"
+check "all users may connect to a shared server" \
+  [ "$(stat -c %a "$TEST_DIR/shared_socket")" = 666 ]
+
+cp "$PROTOCOL" "$TEST_DIR/private_protocol.spthy"
+chmod 600 "$TEST_DIR/private_protocol.spthy"
+as_nobody "$UTTAMARIN" --server "$TEST_DIR/shared_socket" \
+  --lemma first_true_statement "$TEST_DIR/private_protocol.spthy" \
+  > "$TEST_DIR/private_theory" 2>&1
+check "a theory that the user of the client cannot read is rejected" \
+  contains "$TEST_DIR/private_theory" "not the absolute path of a file that"
+
+# The run of the other user starts after the first lemma of the long run
+"$UTTAMARIN" --server "$TEST_DIR/shared_socket" --lemma first_true_statement \
+  --lemma second_true_statement --lemma first_false_statement \
+  --lemma second_false_statement "$PROTOCOL" > "$TEST_DIR/long" 2>&1 &
+LONG_PID=$!
+sleep 0.5
+as_nobody "$UTTAMARIN" --server "$TEST_DIR/shared_socket" \
+  --lemma third_true_statement "$PROTOCOL" > "$TEST_DIR/short" 2>&1
+check "the run of the other user is verified" \
+  contains "$TEST_DIR/short" "verified: 1"
+check "the run of the other user does not wait for the long run" \
+  kill -0 "$LONG_PID"
+wait "$LONG_PID"
+check "the long run finishes" \
+  contains "$TEST_DIR/long" "verified: 2, false: 2"
+
+finish
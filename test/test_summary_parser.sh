@@ -0,0 +1,46 @@
+#!/usr/bin/env bash
+# Checks how the results and failures of Tamarin are read from its summary.
+# Run this file from its parent directory.
+source ./test/common.sh
+
+cat > "$TEST_DIR/summary.spthy" <<'THEORY'
+theory summary
+begin
+
+lemma summary_true:
+    "All X #i. K(X) @ i ==> K(X) @ i"
+
+lemma summary_false:
+    "All X #i. K(X) @ i ==> not K(X) @ i"
+
+lemma non_terminating_summary:
+    "All X #i. K(X) @ i ==> K(X) @ i"
+
+lemma summary_crash:
+    "All X #i. K(X) @ i ==> K(X) @ i"
+
+lemma summary_killed:
+    "All X #i. K(X) @ i ==> K(X) @ i"
+
+lemma summary_parse_error:
+    "All X #i. K(X) @ i ==> K(X) @ i"
+
+end
+THEORY
+
+"$UTTAMARIN" "$TEST_DIR/summary.spthy" -j 6 -t 2 --no_history -q \
+  > "$TEST_DIR/output" 2>&1
+check "verified lemma with its steps" \
+  contains "$TEST_DIR/output" "summary_true .*verified.*2 steps"
+check "falsified lemma with its steps" \
+  contains "$TEST_DIR/output" "summary_false .*false.*3 steps"
+check "lemma that runs into the timeout" \
+  contains "$TEST_DIR/output" "non_terminating_summary .*unverified.*timeout"
+check "crash without a summary" \
+  contains "$TEST_DIR/output" "summary_crash .*unverified.*crash"
+check "Tamarin killed by a signal is a crash, not a timeout" \
+  contains "$TEST_DIR/output" "summary_killed .*unverified.*crash"
+check "parse error" \
+  contains "$TEST_DIR/output" "summary_parse_error .*unverified.*parse error"
+
+finish
@@ -0,0 +1,39 @@
+#!/usr/bin/env bash
+# Checks that watch mode (--watch) runs only the lemmas that depend on an
+# edited rule again, with the processor chain of a normal run.
+# Run this file from its parent directory.
+source ./test/common.sh
+
+THEORY="$TEST_DIR/test_protocol.spthy"
+HISTORY="$TEST_DIR/history.jsonl"
+cp "$PROTOCOL" "$THEORY"
+# Only non_terminating_statement depends on the rule Loop (the others only
+# use the adversary knowledge K), and it terminates with the heuristic C
+echo '{ "lemma_heuristics": [ { "lemma_name": "non_terminating_statement",' \
+     '"heuristic": "C" } ] }' > "$TEST_DIR/config.json"
+STUB_WINNING_HEURISTIC=C background "$UTTAMARIN" "$THEORY" --watch -q \
+  --history_file="$HISTORY" --config_file="$TEST_DIR/config.json" \
+  --metrics_file="$TEST_DIR/metrics.prom" > "$TEST_DIR/output" 2>&1
+check "the first run verifies the lemmas" \
+  wait_for "$TEST_DIR/output" "verified: 7, false: 3"
+check "the first run exports metrics" \
+  wait_for "$TEST_DIR/metrics.prom" "uttamarin_lemmas"
+
+records_before=$(wc -l < "$HISTORY")
+sed -i 's/--\[ Loop(~X) \]->/--[ Loop(~X), Again(~X) ]->/' "$THEORY"
+check "the change affects only the dependent lemma" \
+  wait_for "$TEST_DIR/output" "Changed: test_protocol.spthy (1 of 10 lemmas"
+# Waits up to ten seconds for the second summary
+wait_for_second_run() {
+  for _ in $(seq 100); do
+    [ "$(grep -c "verified: 7, false: 3" "$TEST_DIR/output")" -eq 2 ] &&
+      return 0
+    sleep 0.1
+  done
+  return 1
+}
+check "the second run verifies the lemmas" wait_for_second_run
+check "only the dependent lemma ran again" \
+  [ $(($(wc -l < "$HISTORY") - records_before)) -eq 1 ]
+
+finish
@@ -0,0 +1,60 @@
+#!/usr/bin/env bash
+# Checks that lemmas run on local worker processes (uttamarin worker), over
+# pipes and over TCP, and that the jobs of a lost worker run on another one.
+# Run this file from its parent directory.
+source ./test/common.sh
+
+PORT=$((20000 + RANDOM % 20000))
+background "$UTTAMARIN" worker --listen "127.0.0.1:$PORT" -j 2 \
+  > "$TEST_DIR/tcp_worker.log" 2>&1
+wait_for "$TEST_DIR/tcp_worker.log" "Listening"
+
+"$UTTAMARIN" "$PROTOCOL" -t 3 --no_history -q \
+  --worker "$UTTAMARIN worker -j 2" --worker "127.0.0.1:$PORT" \
+  > "$TEST_DIR/output" 2>&1
+check "all lemmas ran on the workers" \
+  contains "$TEST_DIR/output" "verified: 6, false: 3, timeout: 1"
+check "no worker was lost" \
+  lacks "$TEST_DIR/output" "Warning"
+
+# Sends the given JSON message with its length to the file descriptor 3
+send_message() {
+  local size=${#1}
+  printf "$(printf '\\x%02x' $((size >> 24 & 255)) $((size >> 16 & 255)) \
+             $((size >> 8 & 255)) $((size & 255)))%s" "$1" >&3
+}
+
+# An idle coordinator does not keep others from the worker, and one that
+# sends a field of the wrong type only loses its own connection
+exec 3<> "/dev/tcp/127.0.0.1/$PORT"
+"$UTTAMARIN" "$PROTOCOL" -t 3 --no_history -q --worker "127.0.0.1:$PORT" \
+  > "$TEST_DIR/concurrent_output" 2>&1
+check "a second coordinator is served at once" \
+  contains "$TEST_DIR/concurrent_output" "verified: 6, false: 3, timeout: 1"
+send_message '{"type": "theory", "hash": "h", "contents": "theory t"}'
+send_message '{"type": "jobs", "theory": "h", "jobs": [{"id": 1,
+  "lemma": "first_true_statement", "timeout": "soon"}]}'
+check "the malformed job is rejected" \
+  wait_for "$TEST_DIR/tcp_worker.log" "invalid message from the coordinator"
+exec 3>&-
+"$UTTAMARIN" "$PROTOCOL" -t 3 --no_history -q --worker "127.0.0.1:$PORT" \
+  > "$TEST_DIR/later_output" 2>&1
+check "the worker survives the malformed job" \
+  contains "$TEST_DIR/later_output" "verified: 6, false: 3, timeout: 1"
+
+# A second TCP worker is killed while it runs lemmas
+PORT=$((PORT + 1))
+"$UTTAMARIN" worker --listen "127.0.0.1:$PORT" -j 2 \
+  > "$TEST_DIR/lost_worker.log" 2>&1 &
+LOST_WORKER_PID=$!
+wait_for "$TEST_DIR/lost_worker.log" "Listening"
+(sleep 1; kill "$LOST_WORKER_PID") &
+STUB_DELAY=2 "$UTTAMARIN" "$PROTOCOL" -t 6 --no_history -q \
+  --worker "127.0.0.1:$PORT" --worker "$UTTAMARIN worker -j 2" \
+  > "$TEST_DIR/lost_output" 2>&1
+check "the lost worker was noticed" \
+  contains "$TEST_DIR/lost_output" "lost the worker '127.0.0.1:$PORT'"
+check "its jobs ran on the other worker" \
+  contains "$TEST_DIR/lost_output" "verified: 6, false: 3, timeout: 1"
+
+finish